@@ -41,6 +41,28 @@
 #include "hwlib.h"
 #include <alt_printf.h>
 
+/* Contatori/tempi per ID e limitatore di storm (irq_stats.c dell'applicazione) */
+#ifndef ALT_INT_PROVISION_IRQ_STATS
+#define ALT_INT_PROVISION_IRQ_STATS 0
+#endif
+#if ALT_INT_PROVISION_IRQ_STATS
+#include "irq_stats.h"
+#endif
+
+/* Undefined/abort verso crash_entry.S dell'applicazione invece del dispatcher IRQ */
+#ifndef ALT_INT_PROVISION_FAULT_VECTORS
+#define ALT_INT_PROVISION_FAULT_VECTORS 0
+#endif
+#if ALT_INT_PROVISION_FAULT_VECTORS
+#define ALT_INT_VECT_UNDEF "b crash_entry_undef; "
+#define ALT_INT_VECT_PABT  "b crash_entry_pabt; "
+#define ALT_INT_VECT_DABT  "b crash_entry_dabt; "
+#else
+#define ALT_INT_VECT_UNDEF "b __intc_isr_irq; "
+#define ALT_INT_VECT_PABT  "b __intc_isr_irq; "
+#define ALT_INT_VECT_DABT  "b __intc_isr_irq; "
+#endif
+
 #ifdef DEBUG_ALT_INTERRUPT
   #define dprintf printf
 #else
@@ -1248,10 +1270,10 @@ __asm__(".section .vectors, \"ax\";"
 ".global __intc_interrupt_vector;"
 "__intc_interrupt_vector:"
         "b _socfpga_main; "
+        ALT_INT_VECT_UNDEF
         "b __intc_isr_irq; "
-        "b __intc_isr_irq; "
-        "b __intc_isr_irq; "
-        "b __intc_isr_irq; "
+        ALT_INT_VECT_PABT
+        ALT_INT_VECT_DABT
         "b __intc_isr_irq; "
         "b __intc_isr_irq; "
         "b __intc_isr_irq; "
@@ -1276,7 +1298,13 @@ void alt_int_handler_irq(void)
     {
         if (alt_int_dispatch[ackintid].callback)
         {
+#if ALT_INT_PROVISION_IRQ_STATS
+            uint32_t t0 = irq_stats_enter(ackintid);
+#endif
             alt_int_dispatch[ackintid].callback(icciar, alt_int_dispatch[ackintid].context);
+#if ALT_INT_PROVISION_IRQ_STATS
+            irq_stats_exit(ackintid, t0);
+#endif
         }
     }
     else
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "alt_mmu.h"          // HWLIB MMU
 #include "socal/socal.h"      // alt_read_word/alt_write_word (se ti servono)
 
@@ -33,16 +34,16 @@
 #define COEF_NUM_OPTIONS_MAX       1024u
 #define PULSE_NUM_OPTIONS_MAX     1024u
 
-// Base delle aree in DDR (COEF prima, poi PULSE)
+// Base delle aree in DDR (COEF prima, poi PULSE): il resto lo calcola dma_layout_plan
 #define COEF_AREA_BASE             (DDR3_BASE)
-// PULSE parte subito dopo l’area COEF (dipende da quante COEF opzioni usi e dal loro stride)
-#define PULSE_AREA_BASE(ncoef, coef_stride)  (COEF_AREA_BASE + (uint32_t)(ncoef) * (uint32_t)(coef_stride))
 
 // OCRAM dest: doppio buffer (tuo mapping)
 #define COEF_DEST_BASE        		0x00000000u    // dual-port 1 MiB
+#define COEF_DEST_SIZE        		0x00100000u
 #define COEF_NUM_PAIRS       		1024
 
 #define PULSE_DEST_BASE           	0x00000000u    // dual-port 128 KiB
+#define PULSE_DEST_SIZE           	0x00020000u
 #define PULSE_NUM_PAIRS       		1024
 
 
@@ -51,12 +52,48 @@
 
 
 
+// Tipi di regione per la mappa MMU dichiarativa: ogni tipo ha i suoi attributi
+// (vedi s_mmu_rgn_attr in arm_mem_regions.c). La granularità (4 KiB, 64 KiB,
+// 1 MiB, 16 MiB) la sceglie HWLIB in base ad allineamento e dimensione.
+typedef enum {
+    ARM_MMU_RGN_SHARED = 0,   // DDR condivisa: Normal WBWA, shareable, eseguibile
+    ARM_MMU_RGN_CODE,         // codice: Normal WBWA, sola lettura, eseguibile
+    ARM_MMU_RGN_DATA,         // dati/heap: Normal WBWA, RW, XN
+    ARM_MMU_RGN_STACK,        // stack: Normal WBWA, RW, XN
+    ARM_MMU_RGN_SHM,          // SHM inter-core: Normal non-cacheable, shareable, XN
+    ARM_MMU_RGN_DMA,          // buffer DMA: Normal non-cacheable, shareable, XN
+    ARM_MMU_RGN_WAVE,         // libreria forme d'onda (GB FPGA): Normal WBWA, XN
+    ARM_MMU_RGN_DEVICE,       // periferiche: Device, XN
+    ARM_MMU_RGN_GUARD,        // guard page: fault
+    ARM_MMU_RGN_QTY
+} arm_mmu_rgn_type_t;
+
+typedef struct {
+    const char         *name;
+    uint32_t            base;   // VA == PA, multiplo di 4 KiB
+    uint32_t            size;   // multiplo di 4 KiB
+    arm_mmu_rgn_type_t  type;
+} arm_mmu_rgn_t;
+
+#define DDR3_SIZE                 0x40000000u   // 1 GiB letto dall'FPGA via F2SDRAM
+// Coda della finestra riservata alla sorgente di calibrazione mSGDMA (msgdma_coef_calibrate):
+// layout e slot di riserva dell'hot-update stanno sotto DDR3_PLAN_END
+#define DDR3_CAL_BYTES            (256u * 1024u)
+#define DDR3_PLAN_END             (DDR3_BASE + DDR3_SIZE - DDR3_CAL_BYTES)
+
 // Inizializza MMU per CORE0 secondo mappa richiesta (non mappa il GB FPGA).
 ALT_STATUS_CODE arm_mmu_setup_core0(void);
 
-// Inizializza MMU per CORE1 secondo mappa richiesta (non mappa il GB FPGA).
+// Inizializza MMU per CORE1 dalla tabella regioni (incluso il GB FPGA in supersection).
 ALT_STATUS_CODE arm_mmu_setup_core1(void);
 
+// Tabella regioni attiva su Core1 (valida dopo arm_mmu_setup_core1)
+const arm_mmu_rgn_t *arm_mmu_core1_regions(uint32_t *count);
+// Finestra DMA non-cacheable di Core1 (da linker: __dma_start__/__dma_end__)
+void arm_mmu_core1_dma_window(uintptr_t *base, size_t *size);
+// Stampa la tabella dichiarativa e le traduzioni effettive lette da TTBR0
+void arm_mmu_dump(void);
+
 // (Opzionale) Abilita SMP/SCU prima delle cache/MMU
 void arm_enable_smp_and_scu(void);
 
@@ -70,6 +107,20 @@ void arm_cache_get_status(bool *mmu_on, bool *icache_on, bool *dcache_on, bool *
 void arm_dcache_clean_invalidate_all(void);
 void arm_icache_invalidate_all(void);
 
+// ===== Manutenzione cache per range (L1 + L2C-310, VA == PA) =====
+// Sotto la soglia si lavora per MVA (alt_cache_system_*), sopra si fa il flush
+// completo (set/way L1 + by-way L2), che costa uguale qualunque sia la size.
+#ifndef ARM_CACHE_FULL_THRESHOLD
+#define ARM_CACHE_FULL_THRESHOLD  (256u * 1024u)
+#endif
+
+// CPU ha scritto -> rendi visibile ai master DMA/FPGA (clean)
+ALT_STATUS_CODE arm_cache_clean_range(const void *addr, size_t len);
+// DMA/FPGA ha scritto -> scarta le copie in cache (bordi non allineati: clean+inv)
+ALT_STATUS_CODE arm_cache_invalidate_range(void *addr, size_t len);
+// Clean + invalidate
+ALT_STATUS_CODE arm_cache_flush_range(void *addr, size_t len);
+
 ALT_STATUS_CODE arm_mm_hw_init(void);
 ALT_STATUS_CODE arm_core0_mm_open(void);
 ALT_STATUS_CODE arm_core0_mm_close(void);
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "shared_ipc.h"
+
+/*
+ * Salute di Core1 e ripristino senza riavviare Core0.
+ *
+ * Core1: un task del suo scheduler incrementa SHM_CTRL->hb_count ogni
+ * CORE1_HEALTH_BEAT_MS (prova che timer, scheduler e loop girano); il timer
+ * privato pubblica a ogni tick l'ultimo PC interrotto e il task in corso.
+ * Undefined/abort: crash_dump salva il record completo, poi tipo, PC, FSR e
+ * FAR finiscono anche qui in SHM e il core si ferma.
+ *
+ * Core0: core1_health_check (scheduler, CORE1_HEALTH_CHECK_MS) segue hb_count.
+ * Heartbeat fermo oltre il timeout, fault pubblicato o boot non concluso:
+ * cattura la diagnostica (core1_diag_t) e, con auto_restart, tiene CPU1 in
+ * reset, ferma i canali PL330 4..7, chiude con errore i comandi wave_prep
+ * aperti e rilancia core1_boot_from_ddr. Trigger, mSGDMA e ring OCRAM sono
+ * di Core0: lo streaming delle forme d'onda non si ferma.
+ */
+
+#define CORE1_HEALTH_BEAT_MS        10u
+#define CORE1_HEALTH_CHECK_MS       20u
+#define CORE1_HEALTH_TIMEOUT_MS     500u     // default, core1_health_timeout_set
+#define CORE1_HEALTH_BOOT_MS        3000u    // core1_on/ripristino -> core1_ready
+#define CORE1_HEALTH_MAX_RESTARTS   3u       // ripristini consecutivi senza arrivare a OK
+
+typedef enum {
+    CORE1_FAULT_NONE  = 0,
+    CORE1_FAULT_UNDEF = 1,
+    CORE1_FAULT_PABT  = 2,
+    CORE1_FAULT_DABT  = 3,
+} core1_fault_t;
+
+typedef enum {
+    CORE1_HEALTH_OFF = 0,
+    CORE1_HEALTH_BOOTING,
+    CORE1_HEALTH_OK,
+    CORE1_HEALTH_STALLED,       // rilevato, nessun ripristino (auto off o tentativi finiti)
+} core1_health_state_t;
+
+typedef struct {
+    uint32_t when;              // core0_ticks della cattura
+    uint32_t reason;            // 0 = heartbeat, 1 = fault, 2 = boot
+    uint32_t hb;
+    uint32_t stalled_ms;
+    uint32_t pc;                // ultimo PC campionato dal timer di Core1
+    uint32_t task;              // task dello scheduler di Core1 in corso (0 = nessuno)
+    uint32_t ticks;             // tick di Core1 durante lo stallo (0 = anche gli IRQ fermi)
+    uint32_t fault_type;        // core1_fault_t
+    uint32_t fault_pc;
+    uint32_t fault_psr;
+    uint32_t fault_fsr;
+    uint32_t fault_far;
+} core1_diag_t;
+
+/* Core1: task di heartbeat nello scheduler */
+ALT_STATUS_CODE core1_health_start(void);
+/* Core1: dal timer privato (core1_timer_int_callback) */
+void core1_health_tick(void);
+/* Core1: da crash_dump_c (modo UND/ABT) */
+void core1_fault_publish(uint32_t type, uint32_t pc, uint32_t psr, uint32_t fsr, uint32_t far);
+
+/* Core0, dopo core1_on: aggancia il controllo allo scheduler */
+ALT_STATUS_CODE core1_health_init(uint32_t timeout_ms);
+void core1_health_timeout_set(uint32_t timeout_ms);
+void core1_health_auto_restart(bool enable);
+void core1_health_check(void);
+/* Ripristino manuale (anche con Core1 sano) */
+ALT_STATUS_CODE core1_health_restart(void);
+core1_health_state_t core1_health_state(void);
+const core1_diag_t *core1_health_last(void);
+void core1_health_dump(void);
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "shared_ipc.h"
+#include "trace_log.h"
+
+/*
+ * Crash dump persistente di Undefined / Prefetch abort / Data abort.
+ *
+ * Ingresso: crash_entry_undef/pabt/dabt (crash_entry.S). Core0 li raggiunge
+ * dalla tabella di alt_interrupt.c (ALT_INT_PROVISION_FAULT_VECTORS=1, prima
+ * tutte le eccezioni finivano nel dispatcher IRQ), Core1 da core1_vectors.S.
+ * Lo stub salva r0..r12 in un'area statica senza usare lo stack del modo
+ * (può essere quello rotto) e passa a crash_dump_c su uno stack di emergenza.
+ *
+ * Record: un slot da CRASH_DUMP_SLOT_BYTES per core negli ultimi 64 KiB della
+ * SHM (DDR non-cacheable, nessuna pulizia di cache prima del reset). Dentro:
+ * r0..r12, sp/lr del modo interrotto, pc, cpsr, FSR/FAR, le prime
+ * CRASH_DUMP_STACK_WORDS parole dallo sp e le ultime CRASH_DUMP_TRACE voci di
+ * trace_log. magic scritto per ultimo, CRC32 sul contenuto.
+ *
+ * Dopo il dump: Core0 chiede un warm reset con SDRAM in self-refresh (la DDR
+ * non perde il contenuto; se il preloader la riazzera per l'ECC, al boot
+ * magic/CRC non tornano e non c'è nulla da riportare). Core1 pubblica il fault
+ * per core1_health e si ferma: lo riavvia Core0. crash_dump_report() al boot
+ * di Core0 stampa i record non ancora riportati.
+ */
+
+#define CRASH_DUMP_MAGIC        0x48535243u     // "CRSH"
+#define CRASH_DUMP_SHM_OFST     0x00FF0000u     // oltre lo staging di wave_prep
+#define CRASH_DUMP_SLOT_BYTES   0x00001000u
+#define CRASH_DUMP_STACK_WORDS  128u
+#define CRASH_DUMP_TRACE        32u
+
+#ifndef CRASH_DUMP_RESET_CORE0
+#define CRASH_DUMP_RESET_CORE0  1               // 0: Core0 resta fermo dopo il dump (debugger)
+#endif
+
+#define CRASH_DUMP_SLOT(core)   ((crash_rec_t *)(uintptr_t)(SHM_BASE + CRASH_DUMP_SHM_OFST + \
+                                                            (uint32_t)(core) * CRASH_DUMP_SLOT_BYTES))
+
+/* Stessi valori di core1_fault_t; WDOG da crash_dump_soft */
+typedef enum {
+    CRASH_NONE  = 0,
+    CRASH_UNDEF = 1,
+    CRASH_PABT  = 2,
+    CRASH_DABT  = 3,
+    CRASH_WDOG  = 4,            // preallarme del watchdog (wdog_mgr), reset in arrivo
+    CRASH_TYPE_QTY
+} crash_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;               // CRC32 da core a fine record
+    uint32_t reported;          // già stampato da crash_dump_report (fuori CRC)
+    uint32_t core;
+    uint32_t type;              // crash_type_t
+    uint32_t count;             // fault registrati nello slot dall'ultimo clear
+    uint32_t uptime_ms;         // tick del core al fault
+    uint32_t r[13];
+    uint32_t sp;                // del modo interrotto (0 = stesso modo del gestore)
+    uint32_t lr;
+    uint32_t pc;                // istruzione che ha generato l'eccezione (soft: ritorno della chiamata)
+    uint32_t cpsr;              // SPSR dell'eccezione
+    uint32_t fsr;               // DFSR (dabt) / IFSR (pabt)
+    uint32_t far;               // DFAR / IFAR
+    uint32_t info;              // CRASH_WDOG: controlli falliti (maschera di wdog_mgr)
+    uint32_t stack_words;       // parole valide in stack[] (da sp in su)
+    uint32_t stack[CRASH_DUMP_STACK_WORDS];
+    uint32_t trace_n;
+    trace_ent_t trace[CRASH_DUMP_TRACE];
+} crash_rec_t;
+
+/* Record valido (magic + CRC) o NULL */
+const crash_rec_t *crash_dump_get(uint32_t core);
+void crash_dump_clear(uint32_t core);
+void crash_dump_print(const crash_rec_t *r);
+/* Core0: stampa i record di entrambi i core non ancora riportati; ritorna quanti */
+uint32_t crash_dump_report(void);
+
+/* Record da codice C (nessuna eccezione): sp/lr/pc del chiamante, stack e trace.
+ * Ritorna: il chiamante prosegue (es. preallarme del watchdog, il reset arriva dopo). */
+void crash_dump_soft(uint32_t type, uint32_t info);
+
+/* Da crash_entry.S, nel modo dell'eccezione: non ritorna */
+void crash_dump_c(uint32_t type, uint32_t lr, uint32_t spsr) __attribute__((noreturn));
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "alt_dma.h"
+
+/*
+ * Servizio copia/riempimento memoria su PL330 (DMA-330 dell'HPS).
+ *
+ * - Pool di canali per core: Core0 usa i thread 0..3 (eventi/IRQ 0..3),
+ *   Core1 i thread 4..7 (eventi/IRQ 4..7). Ogni core ha la propria istanza
+ *   di alt_dma, quindi i due set non devono mai sovrapporsi. DMAGO/DMAKILL
+ *   (interfaccia di debug) e INTEN sono comuni: serializzati tra i core da un
+ *   lock in SHM (pl330_lock in dma_copy.c).
+ * - Completamento: DMASEV a fine programma -> irq[evt] del PL330.
+ *   Core0 lo riceve dal GIC (DMA_IRQ0..3), Core1 dal proprio dispatcher
+ *   (DMA_IRQ4..7, instradate a CPU1 dalla tabella di interrupts.c).
+ *   dma_copy_poll() resta valido su entrambi (IRQ persi o mascherati).
+ * - Fallback sincrono con CPU: servizio non inizializzato, nessun canale libero,
+ *   size sotto DMA_COPY_MIN_BYTES o errore di programmazione del PL330.
+ *   In quel caso la callback viene chiamata subito, nel contesto del chiamante.
+ *
+ * Cache: sorgente pulita e destinazione invalidata prima del via; a fine
+ * transfer la destinazione viene invalidata di nuovo (prefetch speculativi).
+ */
+
+#define DMA_COPY_CH_PER_CORE   4u
+#define DMA_COPY_MIN_BYTES     256u        // sotto: memcpy/memset CPU
+#define DMA_COPY_WAIT_SPINS    50000000u   // timeout dma_copy_wait (poll)
+
+typedef void (*dma_copy_cb_t)(ALT_STATUS_CODE status, void *ctx);
+
+typedef struct {
+    uint32_t dma_ops;       // transfer eseguiti dal PL330
+    uint32_t cpu_ops;       // fallback sincroni
+    uint32_t no_channel;    // richieste senza canale libero
+    uint32_t faults;        // canali finiti in FAULTING
+    uint32_t dma_bytes;
+} dma_copy_stats_t;
+
+/* Core0: alt_dma_init + canali 0..3 + IRQ DMA. Core1: solo canali 4..7 + IRQ DMA. */
+ALT_STATUS_CODE dma_copy_init(void);
+bool dma_copy_is_ready(void);
+
+/* Asincrone: cb (opzionale) chiamata a completamento, da ISR o da dma_copy_poll(). */
+ALT_STATUS_CODE dma_copy_memcpy_async(void *dst, const void *src, size_t len,
+                                      dma_copy_cb_t cb, void *ctx);
+ALT_STATUS_CODE dma_copy_zero_async(void *dst, size_t len,
+                                    dma_copy_cb_t cb, void *ctx);
+
+/* Sincrone: avviano sul PL330 e attendono (o fanno il lavoro con la CPU). */
+ALT_STATUS_CODE dma_copy_memcpy(void *dst, const void *src, size_t len);
+ALT_STATUS_CODE dma_copy_zero(void *dst, size_t len);
+
+/* Completa i transfer terminati senza passare dall'IRQ. Ritorna quanti ne ha chiusi. */
+uint32_t dma_copy_poll(void);
+/* Attende che tutti i canali del core siano liberi. */
+ALT_STATUS_CODE dma_copy_wait_all(void);
+
+const dma_copy_stats_t *dma_copy_stats(void);
+
+/* Solo Core0, con Core1 in reset: DMAKILL sui thread 4..7 ed eventi puliti */
+void dma_copy_stop_peer(void);
@@ -1,44 +1,202 @@
 #pragma once
 #include <stdint.h>
+#include "hwlib.h"
 
 
 
 // === Tabelle dimensioni per CHANNEL ===
 // COEF (coppia Re+Im) in byte
 static const uint32_t g_coef_pair_bytes[4]   = {  64u*1024u, 64u*1024u, 256u*1024u, 512u*1024u };
-// Stride DDR consigliato (≥ size, ben allineato) per ridurre latenze
-static const uint32_t g_coef_stride_bytes[4] = { 128u*1024u, 128u*1024u, 512u*1024u, 1024u*1024u };
 
 // PULSE (coppia Re+Im) in byte
 static const uint32_t g_pulse_pair_bytes[4]   = {  1u*1024u, 16u*1024u,  32u*1024u,  64u*1024u };
-static const uint32_t g_pulse_stride_bytes[4] = { 16u*1024u, 32u*1024u,  64u*1024u, 128u*1024u };
 
-// Stato runtime (se vuoi tenerlo qui; altrimenti in un .c con accessor)
+// === Planner del layout DDR ===
+// Geometria vista dall'F2SDRAM (mappa row-bank-column del controller HPS):
+// un banco cambia ogni DDR_PAGE_BYTES, la stessa riga torna ogni DDR_BANK_SPAN.
+#ifndef DDR_PAGE_BYTES
+#define DDR_PAGE_BYTES     8192u    // riga aperta per banco sull'intera interfaccia
+#endif
+#ifndef DDR_NUM_BANKS
+#define DDR_NUM_BANKS      8u
+#endif
+#define DDR_BANK_SPAN      (DDR_PAGE_BYTES * DDR_NUM_BANKS)
+// 1 = le PULSE partono a metà dei banchi rispetto alle COEF: le due letture
+// mSGDMA contemporanee (COEF su 0, PULSE su 4) non si contendono lo stesso banco
+#ifndef DDR_PLAN_STAGGER
+#define DDR_PLAN_STAGGER   1
+#endif
+
+// Piazzamento calcolato da (channel, coef_count, pulse_count): stessa terna, stesso layout.
+// COEF: impaccate, ognuna all'inizio di un DDR_BANK_SPAN (banco 0).
+// PULSE: a gruppi di pulse_per_group dentro un gruppo di banchi; gruppi a pulse_group_stride.
+typedef struct {
+    uint32_t coef_base;
+    uint32_t coef_stride;
+    uint32_t pulse_base;
+    uint32_t pulse_stride;          // tra PULSE dello stesso gruppo
+    uint32_t pulse_per_group;
+    uint32_t pulse_group_stride;
+    uint32_t end;                   // primo byte dopo l'ultima PULSE
+    uint32_t payload;               // byte utili (size * count)
+    uint32_t footprint;             // end - COEF_AREA_BASE
+    uint32_t eff_permille;          // payload / footprint
+    uint32_t conflict_pages;        // pagine PULSE lette sullo stesso banco della COEF (caso peggiore)
+    uint32_t pulse_pages;
+} dma_plan_t;
+
+// ALT_E_ARG_RANGE se i parametri sono fuori range o il layout esce dalla finestra DDR (p compilato comunque)
+ALT_STATUS_CODE dma_layout_plan(uint32_t channel, uint32_t coef_count, uint32_t pulse_count, dma_plan_t *p);
+// Indirizzo dello slot idx (nessun wrap: idx oltre count = slot successivi dello stesso schema)
+uint32_t dma_plan_coef_addr(const dma_plan_t *p, uint32_t idx);
+uint32_t dma_plan_pulse_addr(const dma_plan_t *p, uint32_t idx);
+// Footprint ed efficienza attesa su console
+void dma_layout_plan_dump(uint32_t channel, uint32_t coef_count, uint32_t pulse_count);
+
+// === Sequenza (playlist) COEF/PULSE ===
+#define SEQ_MAX_STEPS   1024u
+
+// Voce della playlist, come la scrive l'operatore
+typedef struct {
+    uint16_t coef_idx;      // indice opzione COEF (< coef_count)
+    uint16_t pulse_idx;     // indice opzione PULSE (< pulse_count)
+    uint16_t repeat;        // quanti trigger resta su questa voce (0 = 1)
+    uint16_t rsvd;
+    uint32_t prf;           // contatore PRF per questa voce, 0 = quello della config
+} seq_entry_t;
+
+typedef struct {
+    const seq_entry_t *entries;
+    uint32_t count;         // 1..SEQ_MAX_STEPS
+    uint32_t loop_start;    // a fine tabella si riparte da qui (0 = loop completo)
+    uint32_t stagger;       // la PULSE usa la voce (i + stagger) % count
+} seq_program_t;
+
+// Passo compilato: indirizzi sorgente già calcolati, niente aritmetica in ISR
+typedef struct {
+    uint32_t coef_src;
+    uint32_t pulse_src;
+    uint32_t prf;           // 0 = non toccare il contatore
+    uint32_t repeat;        // >= 1
+} seq_step_t;
+
+// Parti massime di una COEF (= engine mSGDMA0..3, vedi msgdma_coef_split)
+#define SEQ_COEF_PARTS  4u
+
+// Ring OCRAM: BANK_SEL porta all'FPGA l'indice dello slot da leggere. Gli slot
+// sono contigui (slot s a s * size del canale) e i DMA ne riempiono fino a
+// depth-1 in anticipo. Profondità = min(2^BANK_SEL_BITS, SEQ_RING_MAX, slot che
+// entrano nella OCRAM COEF e in quella PULSE).
+#ifndef BANK_SEL_BITS
+#define BANK_SEL_BITS   1u          // larghezza del PIO BANK_SEL nel design FPGA (1 = A/B)
+#endif
+#define SEQ_RING_MAX    8u
+
+// Descrittore mSGDMA standard già pronto (ordine dei registri READ/WRITE/LENGTH/CONTROL)
+typedef struct {
+    uint32_t src;
+    uint32_t dst;
+    uint32_t len;
+    uint32_t ctrl;
+} __attribute__((aligned(16))) seq_desc_t;
+
+// === Configurazione forma d'onda (doppio buffer) ===
+// Il chiamante pubblica nello shadow, la ISR del trigger la rende attiva al
+// fronte successivo: una PRI usa sempre una sola configurazione coerente.
+typedef struct {
+    uint32_t channel;       // 0..3
+    uint32_t coef_count;    // quante COEF opzioni cicli (1..1024, qualsiasi valore)
+    uint32_t pulse_count;   // quante PULSE opzioni cicli (1..1024, qualsiasi valore)
+    uint32_t prf;           // valore del contatore PRF (vedi prf_setting)
+    uint32_t gen;           // generazione, assegnata da seq_config_publish
+    // compilati da seq_config_publish (ignorati in ingresso)
+    const seq_step_t *steps;
+    uint32_t n_steps;
+    uint32_t loop_start;
+    // descrittori per slot OCRAM; src = offset nella entry, la base la mette il passo.
+    // La COEF è divisa in coef_parts parti, la parte k va all'engine mSGDMA coef_eng[k].
+    seq_desc_t coef_desc[SEQ_RING_MAX][SEQ_COEF_PARTS];
+    seq_desc_t pulse_desc[SEQ_RING_MAX];
+    uint32_t ring_depth;    // slot OCRAM usati (2..SEQ_RING_MAX)
+    uint8_t  coef_eng[SEQ_COEF_PARTS];
+    uint32_t coef_parts;    // 1..SEQ_COEF_PARTS
+    uint32_t coef_eng_mask; // bit n = parte su mSGDMAn (completamento atteso)
+    uint32_t keep_cursor;   // 1 = stessa sequenza con sorgenti ridirette: il latch non riparte da 0
+    dma_plan_t plan;        // layout DDR della terna, da seq_config_plan (publish/init)
+} seq_config_t;
+
+// Notifica "config attiva" (primo slot della config in lettura all'FPGA):
+// chiamata dalla ISR del trigger, deve essere breve
+typedef void (*seq_config_notify_t)(uint32_t gen);
+
+// Copia ISR-side della config attiva (sola lettura fuori da seq_config_latch)
 extern volatile uint32_t g_channel;      // 0..3
-extern volatile uint32_t g_coef_count;    // quante COEF opzioni cicli (1..1024, potenze di 2)
-extern volatile uint32_t g_pulse_count;  // quante PULSE opzioni cicli (1..1024, potenze di 2)
+extern volatile uint32_t g_coef_count;
+extern volatile uint32_t g_pulse_count;
+
+// Config iniziale (sweep su tutte le opzioni del canale 0): prima di abilitare il trigger,
+// dopo mem_pool_sys_init (tabelle compilate nell'arena DDR). Prima, publish/redirect
+// rispondono ALT_E_BAD_OPERATION.
+ALT_STATUS_CODE seq_config_init(void);
+// Pubblica una nuova config (solo Core0, contesto scheduler). prog NULL = sweep
+// lineare 0..N-1 su COEF e PULSE. Se gen != NULL riceve la generazione.
+ALT_STATUS_CODE seq_config_publish(const seq_config_t *cfg, const seq_program_t *prog, uint32_t *gen);
+// Generazione attiva / test "la mia config è in uso"
+uint32_t seq_config_live_gen(void);
+static inline int seq_config_is_live(uint32_t gen) { return (int32_t)(seq_config_live_gen() - gen) >= 0; }
+void seq_config_set_notify(seq_config_notify_t cb);
+// Da chiamare SOLO nella ISR del trigger: applica lo shadow se pubblicato e ritorna la config attiva.
+// Gli slot già in coda nel ring sono della config precedente: la nuova non è ancora "live".
+const seq_config_t *seq_config_latch(void);
+// Da chiamare SOLO nella ISR del trigger: è andato in lettura uno slot riempito con la config gen.
+// Prima volta per gen: generazione live, trigger di riferimento e notifica.
+void seq_config_shown(uint32_t gen);
+const seq_config_t *seq_config_active(void);
+// Solo Core0, fuori ISR: l'entry a addr (type 0 = COEF, 1 = PULSE) è sorgente di un passo
+// di una delle due config (attiva o shadow/precedente)
+bool seq_config_uses_src(uint32_t type, uint32_t addr);
+// Da chiamare SOLO nella ISR del trigger: passo corrente della sequenza (NULL se vuota), poi avanza.
+// prf = contatore da scrivere quando lo slot riempito con questo passo va in lettura (0 = invariato)
+const seq_step_t *seq_config_step(const seq_config_t *cfg, uint32_t *prf);
+// Passi accodati in totale / al momento dell'ultimo latch (per sapere quando un DMA non legge più)
+uint32_t seq_trigger_count(void);
+uint32_t seq_config_live_trigger(void);
+
+// === Ridirezione sorgenti (hot-update di singole entry) ===
+// type: 0 = COEF, 1 = PULSE (come wave_type_t). Le ridirezioni valgono per il
+// layout (channel, coef_count, pulse_count) fissato da seq_redirect_reset.
+#define SEQ_REDIRECT_MAX   32u
+void seq_redirect_reset(uint32_t channel, uint32_t coef_count, uint32_t pulse_count);
+ALT_STATUS_CODE seq_redirect_set(uint32_t type, uint32_t index, uint32_t addr);   // addr 0 = torna a casa
+// Ridirige old_src -> new_src nella sequenza attiva (o in quella in attesa) al prossimo trigger
+ALT_STATUS_CODE seq_config_redirect(uint32_t type, uint32_t old_src, uint32_t new_src, uint32_t *gen);
 
 // Indici correnti (li hai già: coeff_pair_idx / pulse_pair_idx)
-uint32_t pair_coef_source_addr(uint32_t idx);
+// Calcola cfg->plan da channel/coef_count/pulse_count: dopo averli cambiati, prima degli indirizzi
+ALT_STATUS_CODE seq_config_plan(seq_config_t *cfg);
+uint32_t pair_coef_source_addr_cfg(const seq_config_t *cfg, uint32_t idx);
+uint32_t pair_pulse_source_addr_cfg(const seq_config_t *cfg, uint32_t idx);
+uint32_t pair_coef_source_addr(uint32_t idx);    // config attiva
 uint32_t pair_pulse_source_addr(uint32_t idx);
 
-// Offset banco OCRAM per la coppia corrente, in base al BANK toggle (0=A,1=B)
-static inline uint32_t coef_bank_dst_off(uint32_t bank, uint32_t channel)
+// Offset in OCRAM dello slot del ring (stesso indice scritto su BANK_SEL)
+static inline uint32_t coef_slot_dst_off(uint32_t slot, uint32_t channel)
 {
-    // ping-pong: banco B parte dopo la metà usata da A (pari alla size corrente)
-    return (bank == 0) ? g_coef_pair_bytes[channel] : 0u;
+    return slot * g_coef_pair_bytes[channel];
 }
-static inline uint32_t pulse_bank_dst_off(uint32_t bank, uint32_t channel)
+static inline uint32_t pulse_slot_dst_off(uint32_t slot, uint32_t channel)
 {
-    return (bank == 0) ? g_pulse_pair_bytes[channel] : 0u;
+    return slot * g_pulse_pair_bytes[channel];
 }
+uint32_t seq_ring_depth(uint32_t channel);
 
-void coef_bank_sel(uint32_t bank);
+void coef_bank_sel(uint32_t bank);      // bank = slot del ring
 void pulse_bank_sel(uint32_t bank);
 uint32_t coef_len_for_channel(uint32_t ch);
 uint32_t pulse_len_for_channel(uint32_t ch);
 
-// Config veloce a runtime
-void seq_config_set_channel(uint32_t channel, uint32_t coef_count_pow2, uint32_t pulse_count_pow2);
+// Config veloce a runtime (pubblica; attiva al prossimo trigger)
+// ALT_E_ARG_RANGE se channel > 3 o un count è fuori da 1..1024
+ALT_STATUS_CODE seq_config_set_channel(uint32_t channel, uint32_t coef_count, uint32_t pulse_count);
 uint32_t prf_setting(uint32_t ch);
 void change_pulse(void);
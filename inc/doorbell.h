@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "alt_interrupt.h"
+#include "shared_ipc.h"
+
+/*
+ * Doorbell fra i due core su SGI (una sola linea, DOORBELL_SGI).
+ *
+ * Ogni canale ha un nome e un core destinatario fisso. Il mittente incrementa
+ * SHM_CTRL->db_ring[ch] e manda l'SGI solo se non ce n'è già uno in volo verso
+ * quel core (db_pend): più suonate ravvicinate, anche su canali diversi, fanno
+ * un solo interrupt. Il destinatario azzera db_pend, poi confronta ogni
+ * contatore con l'ultimo visto: la callback riceve quante suonate ha accorpato.
+ *
+ * Callback in ISR (DOORBELL_ISR) o differite a doorbell_poll() nel loop del
+ * core (DOORBELL_TASK, per chi stampa o usa lo scheduler). I contatori stanno
+ * in SHM: una suonata fatta prima che il destinatario registri il canale viene
+ * consegnata alla doorbell_init/doorbell_register successiva.
+ */
+
+#define DOORBELL_SGI        ALT_INT_INTERRUPT_SGI1
+
+typedef enum {
+    DB_CORE0_READY = 0,     // Core0 -> Core1: init finita, SHM valida
+    DB_CORE1_READY,         // Core1 -> Core0: Core1 operativo
+    DB_CMD_TO_CORE1,        // Core0 -> Core1: comandi in SHM
+    DB_RSP_TO_CORE0,        // Core1 -> Core0: risposte in SHM
+    DB_QTY
+} doorbell_ch_t;
+
+typedef enum {
+    DOORBELL_ISR  = 0,
+    DOORBELL_TASK = 1,
+} doorbell_mode_t;
+
+typedef void (*doorbell_cb_t)(doorbell_ch_t ch, uint32_t rings, void *ctx);
+
+/* Core0: azzera i contatori in SHM (prima di liberare Core1) */
+void doorbell_reset(void);
+/* Per core: registra l'SGI sul proprio dispatcher e consegna le suonate arretrate */
+ALT_STATUS_CODE doorbell_init(void);
+
+ALT_STATUS_CODE doorbell_register(doorbell_ch_t ch, doorbell_cb_t cb, void *ctx, doorbell_mode_t mode);
+void doorbell_unregister(doorbell_ch_t ch);
+ALT_STATUS_CODE doorbell_ring(doorbell_ch_t ch);
+
+/* Esegue le callback DOORBELL_TASK in attesa. Ritorna quante ne ha chiamate. */
+uint32_t doorbell_poll(void);
+const char *doorbell_name(doorbell_ch_t ch);
+void doorbell_dump(void);
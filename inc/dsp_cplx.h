@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Kernel DSP su campioni complessi per la generazione COEF/PULSE (Core1).
+ *
+ * Piani float separati (re[], im[]) per il calcolo, interleaved Re,Im int16
+ * Q1.15 per l'FPGA. Ogni kernel ha la versione NEON (se compilato con
+ * -mfpu=neon) e quella scalare _ref di riferimento, usata anche per la coda
+ * (n non multiplo del passo vettoriale) e confrontata da dsp_bench().
+ * Nessun vincolo di allineamento; y può coincidere con un ingresso.
+ */
+
+#define DSP_BLOCK        1024u      // campioni per blocco nei chiamanti (buffer statici)
+#define DSP_BENCH_N      4096u
+
+/* Finestre simmetriche su n campioni (stesso ordine di wave_prep_win_t) */
+typedef enum {
+    DSP_WIN_NONE = 0,
+    DSP_WIN_HANN,
+    DSP_WIN_HAMMING,
+    DSP_WIN_BLACKMAN,
+    DSP_WIN_QTY
+} dsp_win_type_t;
+
+typedef struct {
+    dsp_win_type_t type;
+    double c, s;            // cos/sin(k * 2pi/(n-1)) correnti
+    double dc, ds;          // passo della rotazione
+} dsp_win_t;
+
+/* cos/sin di x in [0, 2pi] in double, senza libm (Core1) */
+void dsp_cossin(double x, double *c, double *s);
+
+void dsp_win_init(dsp_win_t *w, dsp_win_type_t type, uint32_t n);
+/* I prossimi m coefficienti della finestra (a blocchi, senza tabelle) */
+void dsp_win_block(dsp_win_t *w, float *out, uint32_t m);
+
+/* int16 Re,Im interleaved -> piani float (x scale) */
+void dsp_deint_s16(const int16_t *iq, float *re, float *im, uint32_t n, float scale);
+void dsp_deint_s16_ref(const int16_t *iq, float *re, float *im, uint32_t n, float scale);
+/* int16 -> float (x scale), un piano */
+void dsp_s16_f32(const int16_t *x, float *y, uint32_t n, float scale);
+void dsp_s16_f32_ref(const int16_t *x, float *y, uint32_t n, float scale);
+/* float Re,Im interleaved <-> piani */
+void dsp_deint_f32(const float *iq, float *re, float *im, uint32_t n);
+void dsp_deint_f32_ref(const float *iq, float *re, float *im, uint32_t n);
+void dsp_int_f32(const float *re, const float *im, float *iq, uint32_t n);
+void dsp_int_f32_ref(const float *re, const float *im, float *iq, uint32_t n);
+
+/* y = a * b complesso, piani */
+void dsp_cmul_f32(const float *ar, const float *ai, const float *br, const float *bi,
+                  float *yr, float *yi, uint32_t n);
+void dsp_cmul_f32_ref(const float *ar, const float *ai, const float *br, const float *bi,
+                      float *yr, float *yi, uint32_t n);
+/* y = a * b complesso, interleaved */
+void dsp_cmul_f32_iq(const float *a, const float *b, float *y, uint32_t n);
+void dsp_cmul_f32_iq_ref(const float *a, const float *b, float *y, uint32_t n);
+
+/* y = x * k (reale; k = -1 per coniugare un piano Im) */
+void dsp_scale_f32(const float *x, float *y, uint32_t n, float k);
+void dsp_scale_f32_ref(const float *x, float *y, uint32_t n, float k);
+
+/* y = x * w (finestra reale su Re e Im) */
+void dsp_window_f32(const float *xr, const float *xi, const float *w,
+                    float *yr, float *yi, uint32_t n);
+void dsp_window_f32_ref(const float *xr, const float *xi, const float *w,
+                        float *yr, float *yi, uint32_t n);
+
+/* x * gain -> Q1.15 saturato, arrotondato (metà lontano da zero), interleaved.
+ * Ritorna i campioni (Re o Im) saturati. */
+uint32_t dsp_q15_iq(const float *re, const float *im, float gain, int16_t *iq, uint32_t n);
+uint32_t dsp_q15_iq_ref(const float *re, const float *im, float gain, int16_t *iq, uint32_t n);
+
+/* Confronto NEON vs scalare su DSP_BENCH_N campioni: tick e scarti (Core1, arena DDR) */
+void dsp_bench(void);
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+
+/*
+ * FFT complessa in place, radix-4 DIF (+ uno stadio radix-2 per log2(n) dispari),
+ * uscita in ordine naturale. Piani separati re[]/im[], n potenza di 2.
+ *
+ * Twiddle: una tabella per lunghezza di stadio L (w^j, w^2j, w^3j, j < L/4),
+ * calcolata al primo uso e tenuta per sempre nell'arena DDR del core. Le tabelle
+ * non dipendono da n: tutte le dimensioni le condividono (~1.5 MiB fino a 128k).
+ *
+ * dsp_fft_f32   forward non scalata (X[k] = sum x[i] e^-j2pi ik/n)
+ * dsp_ifft_f32  inversa scalata 1/n (forward sui piani scambiati)
+ * dsp_fft_q15   forward Q1.15 scalata 1/n (1/4 per stadio radix-4, 1/2 radix-2):
+ *               nessun overflow negli stadi, saturazione solo nella rotazione
+ *               per ingressi con modulo > 1.
+ *
+ * NEON sugli stadi con L/4 >= 4 (float) / 8 (Q15) e sugli ultimi stadi a
+ * twiddle unitario; _ref = stesso algoritmo scalare (confronto in dsp_fft_bench).
+ */
+
+#define DSP_FFT_LOG2_MIN   2u
+#define DSP_FFT_LOG2_MAX   17u                          // 128k punti = COEF da 512 KiB
+#define DSP_FFT_MAX_N      (1u << DSP_FFT_LOG2_MAX)
+
+/* Precarica le tabelle per n (altrimenti al primo dsp_fft_*) */
+ALT_STATUS_CODE dsp_fft_prepare(uint32_t n);
+
+ALT_STATUS_CODE dsp_fft_f32(float *re, float *im, uint32_t n);
+ALT_STATUS_CODE dsp_fft_f32_ref(float *re, float *im, uint32_t n);
+ALT_STATUS_CODE dsp_ifft_f32(float *re, float *im, uint32_t n);
+
+ALT_STATUS_CODE dsp_fft_q15(int16_t *re, int16_t *im, uint32_t n);
+ALT_STATUS_CODE dsp_fft_q15_ref(int16_t *re, int16_t *im, uint32_t n);
+
+/* NEON vs scalare, round trip e Q15 vs float su n punti (Core1, arena DDR) */
+void dsp_fft_bench(uint32_t n);
+/* Tabelle twiddle in memoria */
+void dsp_fft_dump(void);
@@ -1,3 +1,4 @@
+#pragma once
 #include <inttypes.h>
 
 #define IRQ_ID_F2H0_0 51
@@ -14,4 +15,32 @@ void sgdma2_int_callback(uint32_t icciar, void *ctx);
 void sgdma3_int_callback(uint32_t icciar, void *ctx);
 void sgdma4_int_callback(uint32_t icciar, void *ctx);
 void stampa_f2h(void);
+
+/* Stato degli slot del ring OCRAM (indice = valore di BANK_SEL) */
+typedef enum {
+	BANK_FILLING  = 0,   // DMA in corso verso il banco
+	BANK_READY    = 1,   // riempito, non ancora mostrato all'FPGA
+	BANK_CONSUMED = 2,   // letto (o in lettura) dall'FPGA
+} bank_state_t;
+
+typedef struct {
+	uint32_t swaps;          // trigger con banchi pronti
+	uint32_t underruns;      // trigger in cui l'FPGA ha ripetuto il banco
+	uint32_t coef_late;      // ... perché la COEF non era finita
+	uint32_t pulse_late;     // ... perché la PULSE non era finita
+	uint32_t max_run;        // underrun consecutivi massimi
+	uint32_t ahead_min;      // slot pronti in anticipo al momento dello swap (minimo visto)
+	uint32_t rebases;        // ripartenze del ring per cambio canale
+	uint32_t recoveries;     // ripristini dopo uno stallo degli mSGDMA (bank_ring_recover)
+	uint32_t dropped;        // passi accodati e mai mostrati (ripartenza del ring o ripristino)
+	uint32_t depth;          // slot del ring in uso
+} bank_stats_t;
+
+/* Fine transfer dell'engine mSGDMAn (ISR mSGDMA su Core0, solo con IRQ_MSGDMA_ON_CORE1 = 0;
+ * altrimenti il ring viene aggiornato solo dal trigger) */
+void bank_fill_done(uint32_t engine);
+const bank_stats_t *bank_stats(void);
+/* Stallo del flusso: reset di mSGDMA0..4 e ring svuotato, il trigger successivo
+ * lo riempie da capo. Da task (maschera gli IRQ di Core0 per il tempo del reset). */
+void bank_ring_recover(void);
 void stampa_trigger(void);
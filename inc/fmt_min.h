@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+/*
+ * Formatter minimale condiviso Core0/Core1 (solo interi, niente float/malloc).
+ *
+ * Conversioni supportate:
+ *   %c %s %d %i %u %x %X %p %%
+ *   %q  -> virgola fissa decimale: l'argomento (int32) è il valore già scalato
+ *          di 10^precisione, es. fmt_snprintf(b, n, "%.2q", 1234) -> "12.34"
+ * Flag/campi: '-', '0', larghezza (anche '*'), precisione ('.N' o '.*').
+ * Modificatori 'h' 'l' 'z' 't' accettati e ignorati (tutto a 32 bit su A9).
+ * 'll'/'j' NON supportati: viene scritto '?' e la formattazione si ferma.
+ *
+ * Nessuna divisione hardware/libgcc: /10 fatta con moltiplicazione reciproca,
+ * quindi il costo per cifra è costante e limitato.
+ */
+
+#define FMT_MIN_LINE_MAX    160u   // buffer su stack per fmt_printf (troncamento oltre)
+
+/* Scrive al più size-1 caratteri + '\0' in buf. Ritorna i caratteri scritti (senza '\0'). */
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...);
+
+/* Formatta su buffer locale e invia sulla UART di uart_stdio (rientrante). */
+int fmt_vprintf(const char *fmt, va_list ap);
+int fmt_printf(const char *fmt, ...);
+
+/* Confronto tempi fmt_snprintf vs alt_snprintf (global timer), stampa il risultato. */
+void fmt_min_bench(void);
@@ -1,3 +1,6 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
 #include "alt_fpga_manager.h"
 #include "alt_interrupt.h"
 
@@ -14,7 +17,55 @@
 #define GICC_CTLR         (GIC_CPU_IF_BASE + 0x000)
 #define GICD_ICDICFR1     (GIC_DIST_IF_BASE + 0xC04)  /* cfg 16..31 (PPI), 2 bit per ID*/
 #define GICD_ICDISER1     (GIC_DIST_IF_BASE + 0x100)  /* 0..31 (SGI+PPI, banked per CPU) */
+#define GICD_ISENABLER(n) (GIC_DIST_IF_BASE + 0x100u + 4u * ((n) / 32u))  /* 1 bit per ID */
+#define GICD_ICENABLER(n) (GIC_DIST_IF_BASE + 0x180u + 4u * ((n) / 32u))
+#define GICD_ISPENDR(n)   (GIC_DIST_IF_BASE + 0x200u + 4u * ((n) / 32u))
+#define GICD_ICPENDR(n)   (GIC_DIST_IF_BASE + 0x280u + 4u * ((n) / 32u))
+#define GICD_ISACTIVER(n) (GIC_DIST_IF_BASE + 0x300u + 4u * ((n) / 32u))  /* sola lettura su A9 */
+#define GICD_IPRIORITYR(n) (GIC_DIST_IF_BASE + 0x400u + (n))              /* 1 byte per ID */
+#define GICD_ITARGETSR(n) (GIC_DIST_IF_BASE + 0x800u + (n))               /* 1 byte per ID (SPI) */
+#define GICD_ICFGR(n)     (GIC_DIST_IF_BASE + 0xC00u + 4u * ((n) / 16u))  /* 2 bit per ID */
 
+/*
+ * Affinità degli IRQ (ITARGETSR, bit0 = CPU0, bit1 = CPU1).
+ * La tabella in interrupts.c dice su che core gira ogni linea e con che
+ * priorità: Core0 tiene il trigger (F2H0_0) e i propri canali PL330, i
+ * completamenti mSGDMA e i canali PL330 di Core1 vanno a Core1. La UART
+ * (console) è in polling e non compare.
+ * Le PPI (timer privato) sono banked: ogni core programma la propria.
+ * hps_coreN_int_start rifiuta una linea non instradata al core chiamante.
+ */
+#define IRQ_CPU0          0x1u
+#define IRQ_CPU1          0x2u
+#define IRQ_PRIO_DEFAULT  0x80u
+
+/* 1: completamenti mSGDMA0..4 su Core1 (solo ack; il ring li conta dal trigger).
+ * 0: come prima, su Core0 con bank_fill_done. */
+#ifndef IRQ_MSGDMA_ON_CORE1
+#define IRQ_MSGDMA_ON_CORE1  1
+#endif
+#define IRQ_MSGDMA_CPU    (IRQ_MSGDMA_ON_CORE1 ? IRQ_CPU1 : IRQ_CPU0)
+
+typedef struct {
+    uint16_t id;        // ALT_INT_INTERRUPT_t
+    uint8_t  cpu;       // IRQ_CPU0 / IRQ_CPU1
+    uint8_t  prio;      // più basso = più urgente
+    uint8_t  trig;      // ALT_INT_TRIGGER_t; ICFGR delle SPI di Core1 scritto da Core0
+} irq_route_t;
+
+
+/* Sezione critica locale al core: maschera IRQ e restituisce il CPSR precedente */
+static inline uint32_t arm_irq_save(void)
+{
+    uint32_t cpsr;
+    __asm__ volatile("mrs %0, cpsr\n\tcpsid i" : "=r"(cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void arm_irq_restore(uint32_t cpsr)
+{
+    __asm__ volatile("msr cpsr_c, %0" :: "r"(cpsr) : "memory");
+}
 
 /* Initializes and enables the interrupt controller.*/
 void gic_eoi(uint32_t irq_id);
@@ -29,7 +80,43 @@ ALT_STATUS_CODE hps_core0_int_start(ALT_INT_INTERRUPT_t int_id,
 
 void hps_core0_int_stop(ALT_INT_INTERRUPT_t int_id);
 
+/* Core0: priorità e target di tutta la tabella nel distributor (dopo hps_GIC_init),
+ * più il trigger delle SPI di Core1, prima di avviarlo */
+ALT_STATUS_CODE hps_int_routes_apply(void);
+/* Core della linea: per le SPI il target nel distributor (comune ai core),
+ * altrimenti la tabella (IRQ_CPU0 se non elencata) */
+uint32_t hps_int_affinity(ALT_INT_INTERRUPT_t int_id);
+/* Solo Core0 (su Core1 ALT_E_BAD_OPERATION). Dopo core1_on una linea spostata
+ * su Core1 va poi avviata là con hps_core1_int_start. */
+ALT_STATUS_CODE hps_int_affinity_set(ALT_INT_INTERRUPT_t int_id, uint32_t cpu_mask);
+uint32_t hps_int_priority(ALT_INT_INTERRUPT_t int_id);
+void hps_int_routes_dump(void);
+
+/*
+ * Core1: dispatcher a tabella (core1_irq_handler_c, chiamato da core1_irq_entry).
+ * Registra qualunque ID: SGI 0..15 (trigger SOFTWARE), PPI 16..31 (banked),
+ * SPI 32.. (solo se la tabella di routing le dà a CPU1). Priorità iniziale
+ * dalla tabella di routing. Per le SPI il trigger deve coincidere con quello
+ * già scritto da Core0 (ALT_E_BAD_OPERATION altrimenti): Core1 non tocca ICFGR. Con il nesting attivo (default) le callback
+ * girano con IRQ abilitati e possono essere interrotte da linee più urgenti.
+ */
+typedef struct {
+    uint32_t spurious;      // IAR 1020..1023
+    uint32_t unhandled;     // linee arrivate senza callback (vengono spente)
+    uint32_t nest_depth;    // annidamento corrente
+    uint32_t nest_max;
+    uint32_t recovered;     // linee attive chiuse da hps_core1_int_recover
+} core1_irq_stats_t;
+
 ALT_STATUS_CODE hps_core1_int_start(ALT_INT_INTERRUPT_t int_id,
                                        alt_int_callback_t callback,
                                        void *context,
                                        ALT_INT_TRIGGER_t trigger);
+void hps_core1_int_stop(ALT_INT_INTERRUPT_t int_id);
+ALT_STATUS_CODE hps_core1_int_priority_set(ALT_INT_INTERRUPT_t int_id, uint32_t prio);
+void hps_core1_int_nesting_set(bool enable);
+uint32_t hps_core1_int_count(ALT_INT_INTERRUPT_t int_id);
+const core1_irq_stats_t *hps_core1_int_stats(void);
+void hps_core1_int_dump(void);
+/* Core1 dopo un reset (core1_health): EOI delle linee rimaste attive sulla sua CPU interface */
+void hps_core1_int_recover(void);
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "alt_interrupt.h"
+
+/*
+ * Statistiche per ID di interrupt e limitatore di "storm".
+ *
+ * Chiamate dal percorso di dispatch: alt_int_handler_irq (Core0, con
+ * ALT_INT_PROVISION_IRQ_STATS=1) e core1_irq_handler_c (Core1). Ogni core
+ * ha la propria tabella. Tempi in tick del global timer (PERIPHCLK), che è
+ * comune ai due core; il tempo di una callback annidata su Core1 è incluso
+ * in quello della callback interrotta.
+ *
+ * Storm: più di limit IRQ della stessa linea in una finestra di
+ * IRQ_STATS_WINDOW_MS -> linea spenta nel distributor (ICENABLER) e segnalata
+ * da irq_stats_report(). La callback in corso viene comunque eseguita
+ * (deve fare l'ack alla sorgente). Riaccensione esplicita con irq_stats_rearm.
+ * Il trigger (IRQ_ID_F2H0_0) parte senza limite: irq_stats_limit_set per darne uno.
+ */
+
+#define IRQ_STATS_WINDOW_MS      1u
+#define IRQ_STATS_STORM_DEFAULT  200u     // IRQ per finestra (200 kHz sostenuti)
+
+typedef struct {
+    uint32_t count;         // callback eseguite
+    uint32_t t_max;         // tick, callback più lunga
+    uint64_t t_total;       // tick cumulati
+    uint32_t limit;         // IRQ per finestra, 0 = nessun limite
+    uint32_t win_start;
+    uint32_t win_count;
+    uint32_t storms;        // volte in cui la linea è stata spenta
+    uint8_t  masked;        // spenta dal limitatore
+    uint8_t  reported;      // già stampata da irq_stats_report
+} irq_stat_t;
+
+/* Core0: avvia il global timer se serve. Limiti di default su tutte le linee. */
+ALT_STATUS_CODE irq_stats_init(void);
+
+/* Dispatch: enter prima della callback (ritorna il timestamp), exit dopo */
+uint32_t irq_stats_enter(uint32_t int_id);
+void irq_stats_exit(uint32_t int_id, uint32_t t0);
+
+ALT_STATUS_CODE irq_stats_limit_set(ALT_INT_INTERRUPT_t int_id, uint32_t per_window);
+ALT_STATUS_CODE irq_stats_rearm(ALT_INT_INTERRUPT_t int_id);
+const irq_stat_t *irq_stats_get(ALT_INT_INTERRUPT_t int_id);
+void irq_stats_clear(void);
+
+/* Da task: stampa le linee spente dall'ultimo giro (sched periodico) */
+void irq_stats_report(void);
+void irq_stats_dump(void);
@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "alt_interrupt.h"
+#include "shared_ipc.h"
+
+/*
+ * Allocatore statico: arene "bump" per regione di memoria + pool a blocchi fissi.
+ *
+ * - Arena: alloc lineare allineata, nessun free (solo reset). Serve a ritagliare
+ *   i pool all'init e per oggetti che vivono quanto il firmware.
+ * - Pool: blocchi di dimensione fissa con free-list, alloc/free O(1), nessuna
+ *   frammentazione, contatori used/high-water/fail per pool. Un bit per blocco
+ *   (in coda allo storage) segna i blocchi in uso: free di un blocco già libero
+ *   o non del pool -> ALT_E_BAD_ARG, contato in bad_free, free-list intatta.
+ *
+ * Protezione: alloc/free mascherano gli IRQ del core corrente, quindi sono
+ * usabili da ISR. NON c'è lock tra i core: un pool in SHM va usato da un core
+ * solo (tipicamente alloca il produttore, libera lo stesso core).
+ */
+
+#define MEM_POOL_ALIGN          32u          // cache line A9 / L2C-310
+
+// ---- Regioni di default (modifica qui la mappa) ----
+// OCRAM: buffer statico nell'immagine (Core0 gira in OCRAM, 256 KiB totali).
+// Su Core1, che gira dalla DDR, lo stesso buffer sta in DDR (arena "bss1").
+#define MEM_OCR_HEAP_SIZE       (8u * 1024u)
+
+// DDR Core0: finestra libera sotto la DDR privata di Core1 (0x2000_0000)
+#define MEM_DDR0_HEAP_BASE      0x01000000u
+#define MEM_DDR0_HEAP_SIZE      0x01000000u  // 16 MiB
+
+// DDR Core1: usa __heap_start__/__heap_end__ da arria10-core1-ddr.ld
+
+// SHM: oltre il blocco di controllo shm_ctrl_t (inizializzata solo da Core0)
+#define MEM_SHM_HEAP_OFST       0x00100000u
+#define MEM_SHM_HEAP_SIZE       0x00700000u  // 7 MiB (0x3F10_0000..0x3F7F_FFFF)
+
+typedef enum {
+    MEM_REGION_OCR = 0,
+    MEM_REGION_DDR,
+    MEM_REGION_SHM,
+    MEM_REGION_QTY
+} mem_region_t;
+
+typedef struct {
+    const char *name;
+    uint8_t    *base;
+    size_t      size;
+    size_t      off;          // prossimo byte libero
+    size_t      high_water;   // massimo off raggiunto
+} mem_arena_t;
+
+typedef struct mem_pool_blk_s {
+    struct mem_pool_blk_s *next;
+} mem_pool_blk_t;
+
+typedef struct {
+    const char     *name;
+    uint8_t        *base;
+    uint32_t        block_size;   // arrotondata a MEM_POOL_ALIGN
+    uint32_t        block_count;
+    mem_pool_blk_t *free_head;
+    uint32_t        used;
+    uint32_t        high_water;   // massimo numero di blocchi in uso
+    uint32_t        fail_count;   // alloc fallite (pool esaurito)
+    uint32_t       *in_use;       // bitmap dei blocchi allocati (dopo l'ultimo blocco)
+    uint32_t        bad_free;     // free rifiutate: doppie o blocco estraneo
+} mem_pool_t;
+
+// Byte di storage oltre ai blocchi per la bitmap in_use
+#define MEM_POOL_MAP_BYTES(count)   ((((count) + 31u) / 32u) * sizeof(uint32_t))
+
+// Pool di sistema (tabella in mem_pool.c)
+typedef enum {
+    MEM_POOL_OCR_SMALL = 0,   // 64 B   - descrittori, piccoli nodi (in DDR su Core1)
+    MEM_POOL_DDR_MSG,         // 1 KiB  - messaggi
+    MEM_POOL_DDR_PAGE,        // 4 KiB  - pagine di log / buffer
+    MEM_POOL_SHM_MSG,         // 256 B  - messaggi inter-core (solo Core0)
+    MEM_POOL_QTY
+} mem_pool_id_t;
+
+// Arene
+ALT_STATUS_CODE mem_arena_init(mem_arena_t *a, const char *name, void *base, size_t size);
+void *mem_arena_alloc(mem_arena_t *a, size_t bytes, size_t align);
+void  mem_arena_reset(mem_arena_t *a);
+
+// Pool generici
+ALT_STATUS_CODE mem_pool_init(mem_pool_t *p, const char *name, void *storage,
+                              size_t storage_size, size_t block_size);
+ALT_STATUS_CODE mem_pool_create(mem_pool_t *p, const char *name, mem_arena_t *a,
+                                size_t block_size, uint32_t block_count);
+void *mem_pool_alloc(mem_pool_t *p);
+ALT_STATUS_CODE mem_pool_free(mem_pool_t *p, void *blk);
+bool  mem_pool_owns(const mem_pool_t *p, const void *blk);
+
+// Pool/arene di sistema
+ALT_STATUS_CODE mem_pool_sys_init(void);
+mem_pool_t  *mem_pool_get(mem_pool_id_t id);
+mem_arena_t *mem_arena_get(mem_region_t region);
+void *mem_alloc(mem_pool_id_t id);
+ALT_STATUS_CODE mem_free(mem_pool_id_t id, void *blk);
+void mem_pool_dump(void);
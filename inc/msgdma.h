@@ -1,3 +1,4 @@
+#pragma once
 /* Scarter Gather DMA*/
 
 #define MSGDMA0_DESC_OFST (MSGDMA0_DESC_BASE - MSGDMA0_CSR_BASE)
@@ -215,7 +216,48 @@ descriptor to the dispatcher */
 
 ALT_STATUS_CODE init_mSGDMA(volatile uint32_t *msgdma_csr_add);
 void start_mSGDMA(volatile uint32_t *msgdma_csr_add, uint32_t id);
+/* Reset di mSGDMA0..4 senza stampe (ripristino del flusso): descrittori in coda persi */
+void msgdma_stream_reset(void);
 int msgdma_is_idle(volatile uint32_t *msgdma_csr_add);
 void stampa_sgdma_int(void);
 
+/* ---------------------------------------------------------------------------- */
+/* Split della COEF su più engine: mSGDMA0..3 possono scrivere la OCRAM COEF
+ * (se l'FPGA li instrada lì), mSGDMA4 resta alla PULSE. Una COEF grande viene
+ * divisa in parti contigue, una per engine, con quote proporzionali al
+ * throughput misurato; il trigger successivo attende che siano tutti liberi.
+ * Con le lunghezze di prova di coef_len_for_channel (4 KiB per canale) si resta
+ * sotto MSGDMA_SPLIT_MIN_BYTES: lo split è inattivo finché non tornano le COEF
+ * reali (64..512 KiB); la calibrazione gira comunque al boot. */
+#define MSGDMA_COEF_ENGINES      4u
+#define MSGDMA_PULSE_ENGINE      4u             // mSGDMA4
+#ifndef MSGDMA_COEF_ROUTE_MASK
+#define MSGDMA_COEF_ROUTE_MASK   0xFu           // bit n = mSGDMAn scrive nella OCRAM COEF
+#endif
+#define MSGDMA_SPLIT_MIN_BYTES   (64u * 1024u)  // sotto: un engine solo, lo split non ripaga
+#define MSGDMA_SPLIT_ALIGN       1024u          // confine delle parti (burst interi)
+#define MSGDMA_SPLIT_GAIN_PCT    5u             // un engine in più solo se il tempo scende almeno del 5%
+#define MSGDMA_CAL_BYTES         DDR3_CAL_BYTES
+#define MSGDMA_CAL_SRC           DDR3_PLAN_END  // riservata: dma_layout_plan si ferma prima
+#define MSGDMA_CAL_SPINS         10000000u
+
+typedef struct {
+    uint32_t route_mask;                        // engine che hanno superato la calibrazione
+    uint32_t n;                                 // split factor scelto (1..MSGDMA_COEF_ENGINES)
+    uint8_t  eng[MSGDMA_COEF_ENGINES];          // engine in ordine di throughput
+    uint32_t t_alone[MSGDMA_COEF_ENGINES];      // tick del transfer di prova da solo (indice = mSGDMAn)
+    uint32_t t_split[MSGDMA_COEF_ENGINES];      // tick con i primi k+1 engine di eng[]
+} msgdma_split_info_t;
+
+/* Da chiamare dopo start_mSGDMA e prima di abilitare il trigger (usa la OCRAM COEF) */
+ALT_STATUS_CODE msgdma_coef_calibrate(uint32_t route_mask);
+/* Divide len in parti (max max_parts): ritorna il numero di parti, part_eng = mSGDMA da usare */
+uint32_t msgdma_coef_split(uint32_t len, uint32_t part_len[], uint8_t part_eng[], uint32_t max_parts);
+/* Join: tutti gli engine COEF instradati sono liberi */
+int msgdma_coef_idle(void);
+/* Descrittori non ancora completati sull'engine n (0..4): in coda + in esecuzione */
+uint32_t msgdma_in_flight(uint32_t engine);
+const msgdma_split_info_t *msgdma_coef_split_info(void);
+void msgdma_coef_split_dump(void);
+
 
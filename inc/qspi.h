@@ -14,7 +14,7 @@
 #define SCU_CTRL_ADDR            0xFFFFC000u               /* SCU Control Register (bit0=EN) */
 
 #define CORE1_DDR_BASE           0x20000000u  /* tuo indirizzo fisico */
-#define CORE1_IMAGE_SIZE         0x00020000u  /* es. 128 KiB */
+#define CORE1_IMAGE_SIZE         0x00020000u  /* 128 KiB; stesso limite in ASSERT di arria10-core1-ddr.ld */
 #define CORE1_QSPI_SRC			 0x00B00000u
 
 #define L2_AF_START   0xFFFFFC00u  // L2C-310 Address Filtering Start (A10)
@@ -75,8 +75,12 @@ static inline void core1_set_start_addr(uint32_t phys_entry)
 
 /* Funzioni */
 void core1_on(void);
+void core1_hold_reset(void);
+int  core1_restart(void);
 void check_core1(void);
 int  core1_boot_from_ddr(void);
 int core1_boot_minimal_probe(void);
 ALT_STATUS_CODE qspi_read(uint8_t *dst1024, size_t len, uint32_t addr);
+/* Init del controller per letture ripetute con alt_qspi_read (chiudi con alt_qspi_uninit) */
+ALT_STATUS_CODE qspi_open(void);
 
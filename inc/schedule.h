@@ -26,3 +26,4 @@ int sched_find_func(int core, void (*func)(void));
 int sched_delete(int core, int slot);
 int sched_del_all_func(int core);
 unsigned long get_Time(int core);
+void (*sched_current(int core))(void);
@@ -3,6 +3,7 @@
 
 #define SHM_MAGIC_BOOT   0xC0DE1DEAu
 #define SHM_MAGIC_READY  0xC0DEBEEFu
+#define SHM_DB_CHAN_MAX  16u
 
 typedef struct __attribute__((packed))
 {
@@ -13,7 +14,20 @@ typedef struct __attribute__((packed))
     volatile uint32_t core1_timer;   // contatore “esempio”
     volatile uint32_t log_head;     // per eventuale ring buffer log
     volatile uint32_t log_tail;
-    volatile uint32_t reserved[58]; // padding a 256 byte (se vuoi allineare)
+    volatile uint32_t db_ring[SHM_DB_CHAN_MAX];  // doorbell: suonate per canale (scrive solo il mittente)
+    volatile uint32_t db_pend[2];   // doorbell: SGI già in volo verso Core0/Core1
+    volatile uint32_t hb_count;     // heartbeat Core1 (task del suo scheduler, vedi core1_health.h)
+    volatile uint32_t hb_ticks;     // core1_ticks, dal timer di Core1
+    volatile uint32_t hb_pc;        // ultimo PC interrotto dal timer di Core1
+    volatile uint32_t hb_task;      // task dello scheduler di Core1 in esecuzione (0 = nessuno)
+    volatile uint32_t fault_type;   // core1_fault_t, 0 = nessuno
+    volatile uint32_t fault_pc;
+    volatile uint32_t fault_psr;
+    volatile uint32_t fault_fsr;
+    volatile uint32_t fault_far;
+    volatile uint32_t pl330_want[2]; // lock PL330 tra i core (dma_copy.c, Peterson): 1 = core N lo vuole
+    volatile uint32_t pl330_turn;   // core che cede in caso di contesa
+    volatile uint32_t reserved[28]; // padding a 256 byte (se vuoi allineare)
     // ... spazio a piacere (comandi, parametri, mailboxes, ecc.)
 } shm_ctrl_t;
 
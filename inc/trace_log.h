@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "hwlib.h"
+
+/*
+ * Traccia eventi leggera, un ring per core in RAM privata.
+ *
+ * trace_log() costa una lettura del global timer e tre store con IRQ
+ * mascherati: si può chiamare da ISR. Serve a ricostruire "cosa stava
+ * succedendo" prima di un fault: crash_dump copia le ultime voci nel record
+ * persistente. Gli id sono comuni ai due core (stessa tabella di nomi).
+ */
+
+#define TRACE_LOG_DEPTH     64u     // potenza di 2
+
+typedef enum {
+    TRACE_NONE = 0,
+    TRACE_BOOT,             // arg: core
+    TRACE_IRQ_STORM,        // arg: ID spento dal limitatore
+    TRACE_DMA_FAULT,        // arg: canale PL330 in FAULTING
+    TRACE_WPREP_SUBMIT,     // arg: seq (Core0)
+    TRACE_WPREP_DONE,       // arg: seq, status nei 16 bit alti
+    TRACE_WPREP_CMD,        // arg: seq (Core1, inizio comando)
+    TRACE_C1_STALL,         // arg: motivo (core1_diag_t.reason)
+    TRACE_C1_RESTART,       // arg: numero ripristino
+    TRACE_WDOG_MISS,        // arg: controlli falliti (bit = indice di registrazione)
+    TRACE_WDOG_WARN,        // arg: idem, al preallarme del watchdog
+    TRACE_STREAM_RECOVER,   // arg: ripristini del flusso consecutivi
+    TRACE_TRIG_REARM,       // arg: riaccensioni della linea trigger
+    TRACE_ID_QTY
+} trace_id_t;
+
+typedef struct {
+    uint32_t t;             // global timer, 32 bit bassi
+    uint16_t id;            // trace_id_t
+    uint16_t seq;           // progressivo (buchi = voci perse nel ring)
+    uint32_t arg;
+} trace_ent_t;
+
+void trace_log(trace_id_t id, uint32_t arg);
+/* Copia le ultime (al più max) voci, dalla più vecchia; ritorna quante */
+uint32_t trace_log_copy(trace_ent_t *dst, uint32_t max);
+const char *trace_log_name(uint32_t id);
+void trace_log_print(const trace_ent_t *e, uint32_t n);
+void trace_log_dump(void);
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include "alt_16550_uart.h"
 #include "alt_clock_manager.h"
 #include "alt_bridge_manager.h"
@@ -21,4 +22,7 @@ ALT_STATUS_CODE uart_stdio_write_string(const char *str);
 /* Scrive un valore a 32 bit in formato esadecimale (otto cifre, maiuscole). */
 ALT_STATUS_CODE uart_stdio_write_hex32(uint32_t value);
 
+/* Legge esattamente len byte dalla RX FIFO; ALT_E_TMO se per timeout_spins giri non arriva nulla. */
+ALT_STATUS_CODE uart_stdio_read(void *buf, size_t len, uint32_t timeout_spins);
+
 
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "wave_loader.h"
+
+/*
+ * Hot-update di singole entry COEF/PULSE con lo streaming in corso.
+ *
+ * Ogni entry logica punta a uno slot fisico in DDR: all'inizio il suo slot
+ * "di casa" del layout, più WAVE_HOT_SPARES slot di riserva per tipo dopo
+ * l'area PULSE (stesso schema di banchi di dma_layout_plan). Un update:
+ *   1) prende uno slot libero (mai uno che la sequenza attiva può leggere),
+ *   2) verifica la CRC dei dati e li copia nello slot col PL330,
+ *   3) ridirige la sequenza allo slot nuovo (seq_config_redirect: vale dal
+ *      prossimo trigger, il cursore della sequenza non riparte),
+ *   4) mette il vecchio slot in quarantena finché la ridirezione è attiva e
+ *      sono stati accodati SEQ_RING_MAX+1 passi (l'ultimo DMA che lo leggeva è finito).
+ * Ogni entry ha un numero di versione incrementato ad ogni update riuscito.
+ */
+
+#define WAVE_HOT_SPARES    8u     // slot di riserva per tipo
+
+/* Chiamata dal loader a inizio load: tutte le entry tornano allo slot di casa */
+ALT_STATUS_CODE wave_hot_reset(uint32_t channel, uint32_t coef_count, uint32_t pulse_count);
+
+/* crc = CRC32 attesa dei dati (wave_crc32). Se gen != NULL riceve la generazione
+ * di config che rende attiva l'entry (vedi seq_config_is_live). */
+ALT_STATUS_CODE wave_hot_update(wave_type_t type, uint32_t index,
+                                const void *data, uint32_t len, uint32_t crc, uint32_t *gen);
+
+/* Libera gli slot in quarantena non più letti (chiamata anche da wave_hot_update) */
+void wave_hot_poll(void);
+
+uint32_t wave_hot_version(wave_type_t type, uint32_t index);
+uint32_t wave_hot_addr(wave_type_t type, uint32_t index);
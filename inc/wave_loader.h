@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hwlib.h"
+
+/*
+ * Loader della libreria forme d'onda (COEF/PULSE) nel layout DDR di dma_layout.
+ *
+ * Formato dello stream (little endian):
+ *   wave_lib_hdr_t                      una volta
+ *   { wave_entry_hdr_t, payload[len] }  entry_count volte
+ *
+ * Ogni entry va alla sua coppia nel layout (pair_*_source_addr_cfg della config
+ * descritta dall'header). La trasport legge in un buffer di staging, il PL330
+ * (dma_copy) copia in DDR mentre arriva il chunk successivo. La CRC32 di ogni
+ * entry è calcolata in ricezione e confrontata con quella dell'header.
+ *
+ * L'indice (wave_index) segna quali entry sono valide e viene pubblicato
+ * (ready=1, gen++) solo a caricamento finito. Durante il load ready=0.
+ * Caricare con il trigger fermo o su un layout diverso da quello attivo:
+ * la sostituzione di entry con lo streaming in corso è compito degli hot-update.
+ */
+
+#define WAVE_LIB_MAGIC      0x42494C57u     // "WLIB"
+#define WAVE_LIB_VERSION    1u
+#define WAVE_LOADER_CHUNK   4096u           // = blocco di MEM_POOL_DDR_PAGE
+#define WAVE_LIB_QSPI_OFST  0x00C00000u     // default in flash, dopo l'immagine di Core1
+
+typedef enum {
+    WAVE_COEF  = 0,
+    WAVE_PULSE = 1,
+    WAVE_TYPE_QTY
+} wave_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t channel;       // 0..3 (fissa size e stride delle entry)
+    uint16_t coef_count;    // 1..1024
+    uint16_t pulse_count;   // 1..1024
+    uint32_t entry_count;
+    uint32_t hdr_crc;       // CRC32 dei campi precedenti
+} wave_lib_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t type;          // wave_type_t
+    uint16_t index;         // < coef_count / pulse_count
+    uint32_t len;           // = g_coef_pair_bytes / g_pulse_pair_bytes del canale
+    uint32_t crc;           // CRC32 del payload
+} wave_entry_hdr_t;
+
+/* Trasporto: read deve restituire esattamente len byte (bloccante, con timeout) */
+typedef struct {
+    const char *name;
+    ALT_STATUS_CODE (*open)(void *ctx);
+    ALT_STATUS_CODE (*read)(void *ctx, void *buf, size_t len);
+    void (*close)(void *ctx);
+    void *ctx;
+} wave_transport_t;
+
+typedef struct {
+    volatile uint32_t ready;    // 1 = indice coerente con la DDR
+    uint32_t gen;               // incrementata ad ogni load completato
+    uint32_t channel;
+    uint32_t coef_count;
+    uint32_t pulse_count;
+    uint32_t loaded;            // entry scritte e verificate
+    uint32_t errors;            // entry scartate (CRC, range, size)
+    uint32_t crc[WAVE_TYPE_QTY][1024];
+    uint32_t valid[WAVE_TYPE_QTY][1024 / 32];
+} wave_index_t;
+
+/* Trasporti forniti (Ethernet: nessuno stack IP nel firmware, si aggancia
+ * riempiendo un wave_transport_t con le proprie open/read/close). */
+const wave_transport_t *wave_transport_uart(void);
+const wave_transport_t *wave_transport_qspi(uint32_t qspi_ofs);
+
+ALT_STATUS_CODE wave_loader_load(const wave_transport_t *t);
+
+const wave_index_t *wave_index(void);
+bool wave_entry_ready(wave_type_t type, uint32_t index);
+/* Aggiorna CRC/valid di una entry già caricata (hot-update) */
+void wave_index_set_entry(wave_type_t type, uint32_t index, uint32_t crc);
+/* Entry riscritta a metà (comando interrotto): non più valida */
+void wave_index_clear_entry(wave_type_t type, uint32_t index);
+
+uint32_t wave_crc32(uint32_t crc, const void *buf, size_t len);
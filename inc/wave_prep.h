@@ -0,0 +1,151 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+#include "shared_ipc.h"
+#include "wave_loader.h"
+
+/*
+ * Preparazione delle forme d'onda su Core1 (co-processore).
+ *
+ * Core0 accoda un comando in SHM e suona DB_CMD_TO_CORE1; Core1 (dal proprio
+ * loop, doorbell_poll) legge i campioni sorgente, li converte, applica
+ * guadagno e finestra, scrive l'entry finita nel formato dell'FPGA e
+ * risponde con la CRC (DB_RSP_TO_CORE0). Core0 chiude il comando nel suo
+ * loop: niente lavoro sui dati nel core real-time, a parte la verifica CRC
+ * dell'hot-update.
+ *
+ * Destinazione:
+ *   WAVE_PREP_DST_LAYOUT  slot attuale dell'entry nel layout DDR (wave_hot_addr):
+ *                         costruzione della libreria, con la sequenza ferma o
+ *                         entry non in uso (wave_prep_submit lo verifica: trigger
+ *                         acceso ed entry sorgente di una config -> BAD_OPERATION).
+ *                         A fine comando l'indice la segna valida; se nel frattempo
+ *                         il trigger è stato acceso e l'entry è in sequenza la
+ *                         invalida e risponde BAD_OPERATION.
+ *   WAVE_PREP_DST_HOT     buffer di staging in SHM, poi wave_hot_update su Core0
+ *                         (slot di riserva + ridirezione al trigger, streaming attivo).
+ *
+ * Operazioni:
+ *   WAVE_PREP_OP_BUILD    sorgente -> guadagno/finestra -> Q1.15 (entry nel dominio del tempo)
+ *   WAVE_PREP_OP_COEF     COEF di filtro adattato da una PULSE: sorgente (finestrata)
+ *                         con zero padding a n = dst_len/4 punti (potenza di 2),
+ *                         COEF = gain * conj(FFT(pulse)) (dsp_fft, float su Core1).
+ *                         Basta trasferire le PULSE: le COEF si derivano a bordo.
+ *
+ * Formato FPGA: campioni complessi interleaved Re,Im int16 Q1.15 (4 byte).
+ * Sorgente: interi Q1.15 / float con fondo scala 1.0. Campioni sorgente meno di
+ * quelli dell'entry -> coda a zero (la finestra copre solo i campioni sorgente).
+ *
+ * Coda: un produttore (Core0) e un consumatore (Core1) per direzione, indici
+ * liberi in SHM (non-cacheable), nessun lock.
+ */
+
+#define WAVE_PREP_SHM_OFST       0x00001000u          // dopo shm_ctrl_t, prima dell'heap SHM
+#define WAVE_PREP_QDEPTH         16u                  // potenza di 2
+#define WAVE_PREP_STAGE_OFST     0x00800000u          // staging HOT: oltre l'heap SHM
+#define WAVE_PREP_STAGE_SLOTS    2u
+#define WAVE_PREP_STAGE_BYTES    (512u * 1024u)       // = COEF più grande
+#define WAVE_PREP_SAMPLE_BYTES   4u                   // Re+Im int16
+
+typedef enum {
+    WAVE_PREP_FMT_S16_IQ = 0,   // int16 Re,Im interleaved
+    WAVE_PREP_FMT_S16_PLANAR,   // int16 Re[n] poi Im[n]
+    WAVE_PREP_FMT_F32_IQ,       // float Re,Im interleaved
+    WAVE_PREP_FMT_F32_PLANAR,   // float Re[n] poi Im[n]
+    WAVE_PREP_FMT_QTY
+} wave_prep_fmt_t;
+
+/* stesso ordine di dsp_win_type_t (dsp_cplx.h) */
+typedef enum {
+    WAVE_PREP_WIN_NONE = 0,
+    WAVE_PREP_WIN_HANN,
+    WAVE_PREP_WIN_HAMMING,
+    WAVE_PREP_WIN_BLACKMAN,
+    WAVE_PREP_WIN_QTY
+} wave_prep_win_t;
+
+typedef enum {
+    WAVE_PREP_DST_LAYOUT = 0,
+    WAVE_PREP_DST_HOT,
+} wave_prep_dst_t;
+
+typedef enum {
+    WAVE_PREP_OP_BUILD = 1,     // converte + guadagno + finestra -> entry
+    WAVE_PREP_OP_COEF  = 2,     // conj(FFT) della sorgente con zero padding -> COEF
+} wave_prep_op_t;
+
+typedef struct {
+    uint32_t seq;
+    uint16_t op;            // wave_prep_op_t
+    uint16_t fmt;           // wave_prep_fmt_t
+    uint16_t window;        // wave_prep_win_t
+    uint16_t type;          // wave_type_t (solo per log)
+    uint32_t index;
+    uint32_t src_addr;      // campioni sorgente (SHM o finestra DDR), visibili a Core1
+    uint32_t src_count;     // campioni complessi
+    float    gain;
+    uint32_t dst_addr;      // scelto da Core0 (layout o staging)
+    uint32_t dst_len;       // byte dell'entry (g_coef/g_pulse_pair_bytes del canale)
+} wave_prep_cmd_t;
+
+typedef struct {
+    uint32_t seq;
+    int32_t  status;        // ALT_STATUS_CODE
+    uint32_t crc;           // CRC32 dell'entry scritta
+    uint32_t clipped;       // campioni saturati
+    uint32_t ticks;         // durata su Core1 (global timer)
+} wave_prep_rsp_t;
+
+typedef struct {
+    volatile uint32_t cmd_head;     // scrive Core0
+    volatile uint32_t cmd_tail;     // scrive Core1
+    wave_prep_cmd_t   cmd[WAVE_PREP_QDEPTH];
+    volatile uint32_t rsp_head;     // scrive Core1
+    volatile uint32_t rsp_tail;     // scrive Core0
+    wave_prep_rsp_t   rsp[WAVE_PREP_QDEPTH];
+} wave_prep_shm_t;
+
+#define WAVE_PREP_SHM   ((wave_prep_shm_t *)(uintptr_t)(SHM_BASE + WAVE_PREP_SHM_OFST))
+#define WAVE_PREP_STAGE(i) (SHM_BASE + WAVE_PREP_STAGE_OFST + (uint32_t)(i) * WAVE_PREP_STAGE_BYTES)
+
+// ---------------------------
+// Core0: client
+// ---------------------------
+typedef void (*wave_prep_done_t)(wave_type_t type, uint32_t index, const wave_prep_rsp_t *rsp, void *ctx);
+
+typedef struct {
+    wave_prep_op_t   op;        // 0 = WAVE_PREP_OP_BUILD
+    wave_type_t      type;
+    uint32_t         index;
+    wave_prep_fmt_t  fmt;
+    wave_prep_win_t  window;
+    wave_prep_dst_t  dst;
+    const void      *src;
+    uint32_t         src_count;
+    float            gain;
+    wave_prep_done_t done;      // opzionale, dal loop di Core0
+    void            *ctx;
+} wave_prep_req_t;
+
+/* Core0, prima di core1_on: coda vuota + doorbell delle risposte */
+ALT_STATUS_CODE wave_prep_init(void);
+/* Accoda (non blocca). ALT_E_RESERVED: coda o staging pieni, riprovare. */
+ALT_STATUS_CODE wave_prep_submit(const wave_prep_req_t *req, uint32_t *seq);
+/* COEF coef_idx = gain * conj(FFT(PULSE pulse_idx)) dalla PULSE già in DDR.
+ * gain <= 0: 1/campioni PULSE (nessuna saturazione). */
+ALT_STATUS_CODE wave_prep_coef_from_pulse(uint32_t coef_idx, uint32_t pulse_idx, float gain,
+                                          wave_prep_dst_t dst, wave_prep_done_t done, void *ctx,
+                                          uint32_t *seq);
+uint32_t wave_prep_pending(void);
+/* Core1 fermo (core1_health): coda azzerata, comandi aperti chiusi con status.
+ * Le entry LAYOUT in costruzione diventano non valide. */
+void wave_prep_abort(ALT_STATUS_CODE status);
+void wave_prep_dump(void);
+
+// ---------------------------
+// Core1: server
+// ---------------------------
+ALT_STATUS_CODE wave_prep_server_init(void);
+/* Esegue i comandi in coda (anche da doorbell). Ritorna quanti ne ha chiusi. */
+uint32_t wave_prep_server_poll(void);
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hwlib.h"
+
+/*
+ * Watchdog L4 (WDOG0) servito in base alla salute del sistema.
+ *
+ * wdog_mgr_service (scheduler di Core0, WDOG_MGR_KICK_MS) valuta tutti i
+ * controlli registrati e fa il kick solo se passano tutti: un main loop
+ * bloccato, IRQ di Core0 spenti o un controllo che fallisce di continuo
+ * lasciano scadere il contatore. Controlli di serie:
+ *   trigger - la linea F2H0_0 non resta pendente senza essere servita; se il
+ *             limitatore di irq_stats l'ha spenta viene riaccesa (al più
+ *             WDOG_MGR_REARM_MAX volte di fila); frequenza minima opzionale
+ *   stream  - underrun con swap fermi per WDOG_MGR_STREAM_STALL_MS: reset
+ *             degli mSGDMA e ring svuotato (bank_ring_recover); fallisce dopo
+ *             WDOG_MGR_RECOVER_MAX ripristini senza swap
+ *   core1   - core1_health non in STALLED (i ripristini li fa già lui)
+ *
+ * Preallarme: WDOG0 in ALT_WDOG_INT_THEN_RESET. Al primo timeout arriva
+ * l'IRQ: crash_dump_soft (record CRASH_WDOG in SHM), stato dei controlli e
+ * trace sulla console, poi niente più kick; al secondo timeout il reset
+ * (SDRAM in self-refresh, il record resta per crash_dump_report).
+ * Il timeout effettivo fino al reset è quindi circa 2 x timeout_ms.
+ */
+
+#define WDOG_MGR_TIMEOUT_MS         1000u   // default per wdog_mgr_init
+#define WDOG_MGR_KICK_MS            100u
+#define WDOG_MGR_CHECKS_MAX         8u
+#define WDOG_MGR_STREAM_STALL_MS    300u
+#define WDOG_MGR_RECOVER_MAX        3u
+#define WDOG_MGR_REARM_MAX          3u
+
+#ifndef WDOG_MGR_ENABLE
+#define WDOG_MGR_ENABLE             1       // 0: controlli attivi, WDOG0 fermo (debugger)
+#endif
+
+/* true = sano. Chiamato dal task, con IRQ abilitati. */
+typedef bool (*wdog_check_t)(void *ctx);
+
+/* Core0, dopo core1_health_init: controlli di serie, task e WDOG0 avviato */
+ALT_STATUS_CODE wdog_mgr_init(uint32_t timeout_ms);
+/* Bit i di fail_mask = i-esimo controllo registrato (di serie: 0 trigger, 1 stream, 2 core1) */
+ALT_STATUS_CODE wdog_mgr_register(const char *name, wdog_check_t fn, void *ctx);
+/* Frequenza minima del trigger (0 = solo linea servita: il trigger può mancare) */
+void wdog_mgr_trigger_rate_set(uint32_t min_hz);
+void wdog_mgr_service(void);
+uint32_t wdog_mgr_fail_mask(void);
+void wdog_mgr_dump(void);
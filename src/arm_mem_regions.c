@@ -1,8 +1,11 @@
-// MMU setup minimale per Arria 10 HPS (Cortex-A9), con diagnostica integrata.
-// - DDR 0x00000000–0x3FFFFFFF : Normal WBWA, Shareable, XN=off (eseguibile) [1 GB]
-// - HPS/Bridge 0xFF000000–0xFFFFFFFF : Device, Shareable, XN=on [16 MB]
-// - 0x40000000–0x7FFFFFFF : NON mappato (1 GB riservato alla FPGA)
-// VA == PA. Solo granulosità da 1 MB (Section). Nessuna sotto-mappa sub-MB.
+// MMU setup per Arria 10 HPS (Cortex-A9), con diagnostica integrata.
+// Core1: mappa dichiarativa (vedi create_va_space_core1_ddr), VA == PA:
+// - DDR 0x00000000–0x00FFFFFF : condivisa, Normal WBWA, Shareable
+// - DDR 0x20000000–0x3EFFFFFF : privata Core1, codice/dati/DMA/guard/stack
+// - SHM 0x3F000000–0x3FFFFFFF : Normal non-cacheable, Shareable, XN
+// - DDR3 0x40000000–0x7FFFFFFF : libreria forme d'onda (GB FPGA), supersection
+// - HPS/Bridge 0xFF000000–0xFFFFFFFF : Device, Shareable, XN [16 MB]
+// Granularità scelta da HWLIB: 4 KiB / 64 KiB / 1 MiB / 16 MiB.
 
 #include "arm_mem_regions.h"
 #include "alt_bridge_manager.h"
@@ -14,6 +17,8 @@
 #include "alt_printf.h"
 #include "shared_ipc.h"
 #include "alt_mmu.h"
+#include "alt_cache.h"
+#include "fmt_min.h"
 
 
 #ifndef A9_SCU_BASE
@@ -86,7 +91,7 @@ void arm_enable_smp_and_scu(void)
 // ---------------------------
 // MMU: storage per le tabelle
 // ---------------------------
-/* 64 KiB bastano per 4 regioni (L1 + alcune L2) */
+/* 64 KiB = L1 (16 KiB) + fino a 48 page table L2 (ne servono poche: solo i MiB con confini sub-MB) */
 static uint8_t s_ttb_storage[64 * 1024] __attribute__((aligned(16384)));
 
 typedef struct {
@@ -129,9 +134,56 @@ static void *mmu_aux_alloc_v1(const unsigned int bytes, void *user)
 }
 
 
-// VA space per CORE1: Shared low DDR + DDR privata core1 + SHM non-cache + periferiche HPS.
+// ---------------------------
+// Mappa dichiarativa CORE1
+// ---------------------------
+// 1 = codice in sola lettura (attenzione: i breakpoint software del debugger scrivono nel codice)
+#ifndef ARM_MMU_CODE_READ_ONLY
+#define ARM_MMU_CODE_READ_ONLY 0
+#endif
+
+#define ARM_MMU_RGN_MAX 16u
+
+typedef struct {
+    ALT_MMU_AP_t         access;
+    ALT_MMU_ATTR_t       attributes;
+    ALT_MMU_TTB_S_t      shareable;
+    ALT_MMU_TTB_XN_t     execute;
+} arm_mmu_rgn_attr_t;
+
+static const arm_mmu_rgn_attr_t s_mmu_rgn_attr[ARM_MMU_RGN_QTY] = {
+    [ARM_MMU_RGN_SHARED] = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_WBA,    ALT_MMU_TTB_S_SHAREABLE,     ALT_MMU_TTB_XN_DISABLE },
+#if ARM_MMU_CODE_READ_ONLY
+    [ARM_MMU_RGN_CODE]   = { ALT_MMU_AP_PRIV_READ_ONLY, ALT_MMU_ATTR_WBA, ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_DISABLE },
+#else
+    [ARM_MMU_RGN_CODE]   = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_WBA,    ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_DISABLE },
+#endif
+    [ARM_MMU_RGN_DATA]   = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_WBA,    ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_STACK]  = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_WBA,    ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_SHM]    = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_NC,     ALT_MMU_TTB_S_SHAREABLE,     ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_DMA]    = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_NC,     ALT_MMU_TTB_S_SHAREABLE,     ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_WAVE]   = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_WBA,    ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_DEVICE] = { ALT_MMU_AP_FULL_ACCESS, ALT_MMU_ATTR_DEVICE, ALT_MMU_TTB_S_SHAREABLE,     ALT_MMU_TTB_XN_ENABLE  },
+    [ARM_MMU_RGN_GUARD]  = { ALT_MMU_AP_NO_ACCESS,   ALT_MMU_ATTR_FAULT,  ALT_MMU_TTB_S_NON_SHAREABLE, ALT_MMU_TTB_XN_ENABLE  },
+};
+
+static const char * const s_mmu_rgn_type_name[ARM_MMU_RGN_QTY] = {
+    "SHARED", "CODE", "DATA", "STACK", "SHM", "DMA", "WAVE", "DEVICE", "GUARD"
+};
+
+static arm_mmu_rgn_t s_core1_rgn[ARM_MMU_RGN_MAX];
+static uint32_t      s_core1_rgn_count = 0;
+
+#define LDSYM(s)  ((uint32_t)(uintptr_t)&(s))
+
+// VA space per CORE1: Shared low DDR + DDR privata core1 (codice/dati/DMA/guard/stack)
+// + SHM non-cache + GB FPGA + periferiche HPS.
 static ALT_STATUS_CODE create_va_space_core1_ddr(uint32_t **ttb_out)
 {
+    extern uint8_t __image_base__, __code_end__;
+    extern uint8_t __dma_start__, __dma_end__;
+    extern uint8_t __stack_guard__, __stack_limit__, __stack_top__;
+
     ALT_STATUS_CODE s = alt_mmu_init();
     if (s != ALT_E_SUCCESS) return s;
 
@@ -139,58 +191,44 @@ static ALT_STATUS_CODE create_va_space_core1_ddr(uint32_t **ttb_out)
     s_mmu_pool.off = 0;
     s_mmu_pool.first_done = 0;
 
-    ALT_MMU_MEM_REGION_t regions[] = {
-        /* 0x0000_0000 – 0x00FF_FFFF (16 MiB), WBWA, shareable */
-        {
-            .va         = (void*)0x00000000u,
-            .pa         = (void*)0x00000000u,
-            .size       = 0x01000000u,
-            .access     = ALT_MMU_AP_FULL_ACCESS,
-            .attributes = ALT_MMU_ATTR_WBA,
-            .shareable  = ALT_MMU_TTB_S_SHAREABLE,
-            .execute    = ALT_MMU_TTB_XN_DISABLE,
-            .security   = ALT_MMU_TTB_NS_SECURE
-        },
-        /* 0x2000_0000 – 0x3EFF_FFFF (496 MiB), WBWA, non-shareable */
-        {
-            .va         = (void*)0x20000000u,
-            .pa         = (void*)0x20000000u,
-            .size       = 0x1F000000u,
-            .access     = ALT_MMU_AP_FULL_ACCESS,
-            .attributes = ALT_MMU_ATTR_WBA,
-            .shareable  = ALT_MMU_TTB_S_NON_SHAREABLE,
-            .execute    = ALT_MMU_TTB_XN_DISABLE,
-            .security   = ALT_MMU_TTB_NS_SECURE
-        },
-        /* SHM 0x3F00_0000 – 0x3FFF_FFFF (16 MiB), Device */
-        {
-            .va         = (void*)SHM_BASE,
-            .pa         = (void*)SHM_BASE,
-            .size       = SHM_SIZE,
-            .access     = ALT_MMU_AP_FULL_ACCESS,
-            .attributes = ALT_MMU_ATTR_DEVICE,
-            .shareable  = ALT_MMU_TTB_S_SHAREABLE,
-            .execute    = ALT_MMU_TTB_XN_DISABLE, /* o ENABLE se vuoi NX */
-            .security   = ALT_MMU_TTB_NS_SECURE
-        },
-        /* Periferiche 0xFF00_0000 – 0xFFFF_FFFF (16 MiB), Device, XN */
-        {
-            .va         = (void*)0xFF000000u,
-            .pa         = (void*)0xFF000000u,
-            .size       = 0x01000000u,
-            .access     = ALT_MMU_AP_FULL_ACCESS,
-            .attributes = ALT_MMU_ATTR_DEVICE,
-            .shareable  = ALT_MMU_TTB_S_SHAREABLE,
-            .execute    = ALT_MMU_TTB_XN_ENABLE,
-            .security   = ALT_MMU_TTB_NS_SECURE
-        }
+    /* Tabella dichiarativa: una riga per regione, niente sovrapposizioni */
+    const arm_mmu_rgn_t rgn[] = {
+        { "ddr_low", 0x00000000u,          0x01000000u,                                  ARM_MMU_RGN_SHARED },
+        { "code",    LDSYM(__image_base__), LDSYM(__code_end__)    - LDSYM(__image_base__),  ARM_MMU_RGN_CODE   },
+        { "data",    LDSYM(__code_end__),   LDSYM(__dma_start__)   - LDSYM(__code_end__),    ARM_MMU_RGN_DATA   },
+        { "dma",     LDSYM(__dma_start__),  LDSYM(__dma_end__)     - LDSYM(__dma_start__),   ARM_MMU_RGN_DMA    },
+        { "guard",   LDSYM(__stack_guard__), LDSYM(__stack_limit__) - LDSYM(__stack_guard__), ARM_MMU_RGN_GUARD  },
+        { "stack",   LDSYM(__stack_limit__), LDSYM(__stack_top__)   - LDSYM(__stack_limit__), ARM_MMU_RGN_STACK  },
+        { "shm",     SHM_BASE,             SHM_SIZE,                                     ARM_MMU_RGN_SHM    },
+        { "wave",    DDR3_BASE,            DDR3_SIZE,                                    ARM_MMU_RGN_WAVE   },
+        { "periph",  0xFF000000u,          0x01000000u,                                  ARM_MMU_RGN_DEVICE },
     };
+    const size_t region_count = sizeof(rgn) / sizeof(rgn[0]);
+
+    if (region_count > ARM_MMU_RGN_MAX) return ALT_E_BAD_ARG;
 
-    const size_t region_count = sizeof(regions) / sizeof(regions[0]);
+    ALT_MMU_MEM_REGION_t regions[ARM_MMU_RGN_MAX];
+    for (size_t i = 0; i < region_count; ++i) {
+        const arm_mmu_rgn_attr_t *a = &s_mmu_rgn_attr[rgn[i].type];
+
+        if (((rgn[i].base | rgn[i].size) & (ALT_MMU_SMALL_PAGE_SIZE - 1u)) != 0u) return ALT_E_BAD_ARG;
+
+        regions[i].va         = (void *)(uintptr_t)rgn[i].base;
+        regions[i].pa         = (void *)(uintptr_t)rgn[i].base;
+        regions[i].size       = rgn[i].size;
+        regions[i].access     = a->access;
+        regions[i].attributes = a->attributes;
+        regions[i].shareable  = a->shareable;
+        regions[i].execute    = a->execute;
+        regions[i].security   = ALT_MMU_TTB_NS_SECURE;
+
+        s_core1_rgn[i] = rgn[i];
+    }
+    s_core1_rgn_count = (uint32_t)region_count;
 
     /* Verifica spazio richiesto (facoltativo ma utile in debug) */
     size_t need = alt_mmu_va_space_storage_required(regions, region_count);
-    if (need > sizeof(s_ttb_storage)) {
+    if (need == 0 || need > sizeof(s_ttb_storage)) {
         /* Se non basta, aumenta s_ttb_storage sopra */
         return ALT_E_BAD_ARG;
     }
@@ -214,6 +252,134 @@ static ALT_STATUS_CODE create_va_space_core1_ddr(uint32_t **ttb_out)
     return ALT_E_SUCCESS;
 }
 
+const arm_mmu_rgn_t *arm_mmu_core1_regions(uint32_t *count)
+{
+    if (count) *count = s_core1_rgn_count;
+    return s_core1_rgn;
+}
+
+void arm_mmu_core1_dma_window(uintptr_t *base, size_t *size)
+{
+    for (uint32_t i = 0; i < s_core1_rgn_count; ++i) {
+        if (s_core1_rgn[i].type == ARM_MMU_RGN_DMA) {
+            if (base) *base = s_core1_rgn[i].base;
+            if (size) *size = s_core1_rgn[i].size;
+            return;
+        }
+    }
+    if (base) *base = 0u;
+    if (size) *size = 0u;
+}
+
+// ---------------------------
+// Dump MMU (tabella + walk di TTBR0)
+// ---------------------------
+enum { MMU_K_FAULT = 0, MMU_K_SUPER, MMU_K_SECT, MMU_K_LARGE, MMU_K_SMALL };
+static const char * const s_mmu_kind_name[] = { "FAULT", "16M", "1M", "64K", "4K" };
+
+typedef struct {
+    uint32_t va, pa, end;      // end = VA esclusivo (0 = wrap a 4 GiB)
+    uint32_t kind, key;
+    bool     open;
+} mmu_run_t;
+
+// key = TEX[2:0] C B AP[2:0] XN S normalizzati tra i vari formati di descrittore
+static inline uint32_t mmu_key(uint32_t tex, uint32_t c, uint32_t b, uint32_t ap, uint32_t xn, uint32_t sh)
+{
+    return (tex << 8) | (c << 7) | (b << 6) | (ap << 3) | (xn << 2) | (sh << 1);
+}
+
+static void mmu_run_flush(const mmu_run_t *r)
+{
+    if (!r->open) return;
+    if (r->kind == MMU_K_FAULT) {
+        fmt_printf("\r\n  VA 0x%08X-0x%08X  FAULT", r->va, r->end - 1u);
+        return;
+    }
+    fmt_printf("\r\n  VA 0x%08X-0x%08X  PA 0x%08X  %-3s TEX=%u C=%u B=%u AP=%u XN=%u S=%u",
+               r->va, r->end - 1u, r->pa, s_mmu_kind_name[r->kind],
+               (r->key >> 8) & 7u, (r->key >> 7) & 1u, (r->key >> 6) & 1u,
+               (r->key >> 3) & 7u, (r->key >> 2) & 1u, (r->key >> 1) & 1u);
+}
+
+static void mmu_run_add(mmu_run_t *r, uint32_t va, uint32_t pa, uint32_t len, uint32_t kind, uint32_t key)
+{
+    if (r->open && r->kind == kind && r->key == key && r->end == va &&
+        (kind == MMU_K_FAULT || (r->pa + (va - r->va)) == pa)) {
+        r->end = va + len;
+        return;
+    }
+    mmu_run_flush(r);
+    r->va = va; r->pa = pa; r->end = va + len;
+    r->kind = kind; r->key = key; r->open = true;
+}
+
+void arm_mmu_dump(void)
+{
+    uint32_t i;
+
+    fmt_printf("\r\nMMU regions (%u):", s_core1_rgn_count);
+    for (i = 0; i < s_core1_rgn_count; ++i) {
+        const arm_mmu_rgn_t *r = &s_core1_rgn[i];
+        fmt_printf("\r\n  %-8s 0x%08X +0x%08X  %s", r->name, r->base, r->size, s_mmu_rgn_type_name[r->type]);
+    }
+
+    uint32_t sctlr, ttbr0;
+    __asm__ volatile("mrc p15, 0, %0, c1, c0, 0" : "=r"(sctlr));
+    __asm__ volatile("mrc p15, 0, %0, c2, c0, 0" : "=r"(ttbr0));
+    if ((sctlr & 1u) == 0u) {
+        fmt_printf("\r\nMMU off (SCTLR=0x%08X)", sctlr);
+        return;
+    }
+
+    const uint32_t *ttb1 = (const uint32_t *)(uintptr_t)(ttbr0 & ~0x3FFFu);
+    mmu_run_t run = { 0 };
+
+    fmt_printf("\r\nMMU translations (TTBR0=0x%08X):", ttbr0);
+    for (i = 0; i < 4096u; ++i) {
+        uint32_t d  = ttb1[i];
+        uint32_t va = i << 20;
+
+        switch (d & 3u) {
+        case 1u: {  // page table
+            const uint32_t *pt = (const uint32_t *)(uintptr_t)(d & ALT_MMU_TTB1_PAGE_TBL_BASE_ADDR_MASK);
+            for (uint32_t j = 0; j < 256u; ++j) {
+                uint32_t p   = pt[j];
+                uint32_t pva = va + (j << 12);
+                if ((p & 3u) == 0u) {
+                    mmu_run_add(&run, pva, 0u, 0x1000u, MMU_K_FAULT, 0u);
+                } else if ((p & 2u) != 0u) {   // small page
+                    uint32_t ap = ((p >> 4) & 3u) | (((p >> 9) & 1u) << 2);
+                    mmu_run_add(&run, pva, p & 0xFFFFF000u, 0x1000u, MMU_K_SMALL,
+                                mmu_key((p >> 6) & 7u, (p >> 3) & 1u, (p >> 2) & 1u, ap, p & 1u, (p >> 10) & 1u));
+                } else {                       // large page (replicata 16 volte)
+                    uint32_t ap = ((p >> 4) & 3u) | (((p >> 9) & 1u) << 2);
+                    mmu_run_add(&run, pva, (p & 0xFFFF0000u) | (pva & 0xF000u), 0x1000u, MMU_K_LARGE,
+                                mmu_key((p >> 12) & 7u, (p >> 3) & 1u, (p >> 2) & 1u, ap, (p >> 15) & 1u, (p >> 10) & 1u));
+                }
+            }
+            break;
+        }
+        case 2u:
+        case 3u: {  // section / supersection
+            uint32_t ap  = ((d >> 10) & 3u) | (((d >> 15) & 1u) << 2);
+            uint32_t key = mmu_key((d >> 12) & 7u, (d >> 3) & 1u, (d >> 2) & 1u, ap, (d >> 4) & 1u, (d >> 16) & 1u);
+            if (d & (1u << 18))
+                mmu_run_add(&run, va, (d & 0xFF000000u) | (va & 0x00F00000u), 0x00100000u, MMU_K_SUPER, key);
+            else
+                mmu_run_add(&run, va, d & 0xFFF00000u, 0x00100000u, MMU_K_SECT, key);
+            break;
+        }
+        default:
+            mmu_run_add(&run, va, 0u, 0x00100000u, MMU_K_FAULT, 0u);
+            break;
+        }
+    }
+    mmu_run_flush(&run);
+
+    fmt_printf("\r\nTTB storage: %u/%u byte", (uint32_t)s_mmu_pool.off, (uint32_t)s_mmu_pool.size);
+}
+
 // Core0 → mappa [C0]
 ALT_STATUS_CODE arm_mmu_setup_core0(void)
 {
@@ -293,6 +459,87 @@ void arm_dcache_clean_invalidate_all(void)
     dsb(); // assicurati che la writeback sia completata
 }
 
+// ===== Manutenzione per range =====
+typedef enum { CACHE_OP_CLEAN, CACHE_OP_INVALIDATE, CACHE_OP_PURGE } cache_op_t;
+
+static ALT_STATUS_CODE arm_cache_full(cache_op_t op, bool l1_on, bool l2_on)
+{
+    ALT_STATUS_CODE s = ALT_E_SUCCESS;
+
+    if (op == CACHE_OP_CLEAN) {
+        if (l1_on && s == ALT_E_SUCCESS) s = alt_cache_l1_data_clean_all();
+        dsb();
+        if (l2_on && s == ALT_E_SUCCESS) s = alt_cache_l2_clean_all();
+    } else {
+        // invalidate completo = purge: non si possono buttare linee sporche di altri
+        if (l1_on && s == ALT_E_SUCCESS) s = alt_cache_l1_data_purge_all();
+        dsb();
+        if (l2_on && s == ALT_E_SUCCESS) s = alt_cache_l2_purge_all();
+    }
+    if (l2_on && s == ALT_E_SUCCESS) s = alt_cache_l2_sync();
+    dsb();
+    return s;
+}
+
+static ALT_STATUS_CODE arm_cache_range(cache_op_t op, void *addr, size_t len)
+{
+    if (len == 0u) return ALT_E_SUCCESS;
+
+    uint32_t sctlr;
+    __asm__ volatile("mrc p15, 0, %0, c1, c0, 0" : "=r"(sctlr));
+    const bool l1_on = (sctlr & (1u << 2)) != 0u;
+    const bool l2_on = alt_cache_l2_is_enabled();
+
+    // Cache spente: la memoria è già coerente (caso attuale di Core0)
+    if (!l1_on && !l2_on) return ALT_E_SUCCESS;
+
+    const uintptr_t lo    = (uintptr_t)addr;
+    const uintptr_t start = lo & ~(uintptr_t)(ALT_CACHE_LINE_SIZE - 1u);
+    const uintptr_t end   = (lo + len + (ALT_CACHE_LINE_SIZE - 1u)) & ~(uintptr_t)(ALT_CACHE_LINE_SIZE - 1u);
+    const size_t    size  = (size_t)(end - start);
+
+    if (size >= ARM_CACHE_FULL_THRESHOLD) return arm_cache_full(op, l1_on, l2_on);
+
+    switch (op) {
+    case CACHE_OP_CLEAN:
+        return alt_cache_system_clean((void *)start, size);
+    case CACHE_OP_PURGE:
+        return alt_cache_system_purge((void *)start, size);
+    case CACHE_OP_INVALIDATE:
+    default: {
+        ALT_STATUS_CODE s = ALT_E_SUCCESS;
+        uintptr_t in_lo = start, in_hi = end;
+        // linee di bordo condivise con altri dati: purge invece di invalidate
+        if (start != lo) {
+            s = alt_cache_system_purge((void *)start, ALT_CACHE_LINE_SIZE);
+            in_lo += ALT_CACHE_LINE_SIZE;
+        }
+        if ((s == ALT_E_SUCCESS) && (end != lo + len) && (in_hi > in_lo)) {
+            s = alt_cache_system_purge((void *)(end - ALT_CACHE_LINE_SIZE), ALT_CACHE_LINE_SIZE);
+            in_hi -= ALT_CACHE_LINE_SIZE;
+        }
+        if ((s == ALT_E_SUCCESS) && (in_hi > in_lo))
+            s = alt_cache_system_invalidate((void *)in_lo, (size_t)(in_hi - in_lo));
+        return s;
+    }
+    }
+}
+
+ALT_STATUS_CODE arm_cache_clean_range(const void *addr, size_t len)
+{
+    return arm_cache_range(CACHE_OP_CLEAN, (void *)(uintptr_t)addr, len);
+}
+
+ALT_STATUS_CODE arm_cache_invalidate_range(void *addr, size_t len)
+{
+    return arm_cache_range(CACHE_OP_INVALIDATE, addr, len);
+}
+
+ALT_STATUS_CODE arm_cache_flush_range(void *addr, size_t len)
+{
+    return arm_cache_range(CACHE_OP_PURGE, addr, len);
+}
+
 // Abilita/Disabilita Branch Predictor, I-Cache, D-Cache
 static inline void arm_set_cache_bits(bool enable)
 {
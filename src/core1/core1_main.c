@@ -21,7 +21,16 @@
 #include <stdio.h>
 #include "arm_mem_regions.h"
 #include "shared_ipc.h"
+#include "mem_pool.h"
+#include "dma_copy.h"
 #include "socal/socal.h"
+#include "irq_stats.h"
+#include "doorbell.h"
+#include "wave_prep.h"
+#include "dsp_cplx.h"
+#include "dsp_fft.h"
+#include "core1_health.h"
+#include "trace_log.h"
 
 extern volatile uint32_t *g_arm_pio_data;
 
@@ -44,6 +53,43 @@ static inline void zero_bss(void)
     for (uint8_t *p = &__bss_start__; p < &__bss_end__; ++p) *p = 0;
 }
 
+/* Completamenti mSGDMA instradati a Core1: solo ack e conteggio. Lo stato del
+ * ring OCRAM è di Core0, che lo aggiorna dal trigger leggendo i fill level. */
+static volatile uint32_t s_msgdma_irqs[5];
+
+static void core1_msgdma_isr(uint32_t icciar, void *ctx)
+{
+    volatile uint32_t *csr = (volatile uint32_t *)ctx;
+    uint32_t n = (icciar & 0x3FFu) - IRQ_ID_F2H0_1;
+
+    alt_write_word((void *)(csr + CSR_STATUS_REG), CSR_IRQ_SET_MASK);
+    if (n < 5u) s_msgdma_irqs[n]++;
+}
+
+static ALT_STATUS_CODE core1_msgdma_irq_start(void)
+{
+    static const uint32_t csr[5] = {
+        MSGDMA0_CSR_BASE, MSGDMA1_CSR_BASE, MSGDMA2_CSR_BASE, MSGDMA3_CSR_BASE, MSGDMA4_CSR_BASE
+    };
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+
+    for (uint32_t i = 0; (status == ALT_E_SUCCESS) && (i < 5u); ++i) {
+        ALT_INT_INTERRUPT_t id = (ALT_INT_INTERRUPT_t)(IRQ_ID_F2H0_1 + i);
+        if (!(hps_int_affinity(id) & IRQ_CPU1)) continue;     // restano a Core0
+        status = hps_core1_int_start(id, core1_msgdma_isr,
+                                     (void *)(uintptr_t)csr[i], ALT_INT_TRIGGER_LEVEL);
+    }
+    return status;
+}
+
+static volatile bool s_core0_ready;
+
+static void core0_ready_db(doorbell_ch_t ch, uint32_t rings, void *ctx)
+{
+    (void)ch; (void)rings; (void)ctx;
+    s_core0_ready = true;
+}
+
 void core1_main(void)
 {
 	ALT_STATUS_CODE status = ALT_E_SUCCESS;
@@ -53,9 +99,14 @@ void core1_main(void)
 
     (void)uart_stdio_init_uart1(115200);
 
-    // MMU di Core1 (crea le regioni: DDR WBWA + SHM NON-CACHEABLE + Device)
+    // MMU di Core1 (tabella regioni: codice/dati/stack WBWA, DMA+SHM non-cacheable, guard, GB FPGA, Device)
     if (status == ALT_E_SUCCESS) status = arm_mmu_setup_core1();
+    //arm_mmu_dump();              // stampa regioni + traduzioni effettive
     if (status == ALT_E_SUCCESS) status = arm_core1_mm_open();
+    if (status == ALT_E_SUCCESS) status = mem_pool_sys_init();   // pool in DDR privata Core1
+    if (status == ALT_E_SUCCESS) status = irq_stats_init();      // prima di registrare gli IRQ
+    if (status == ALT_E_SUCCESS) status = dma_copy_init();       // canali PL330 4..7 (DMA_IRQ4..7)
+    hps_core1_int_recover();                                      // linee lasciate attive prima di un ripristino
 
     printf("\r\n[CORE1] PIO OK, addr="); uart_stdio_write_hex32((uint32_t)g_arm_pio_data);
 
@@ -64,27 +115,41 @@ void core1_main(void)
 															 NULL,
 															 ALT_INT_TRIGGER_LEVEL);
     if (status == ALT_E_SUCCESS) status = hps_timer_start(ALT_GPT_CPU_PRIVATE_TMR, 1);
+    if (status == ALT_E_SUCCESS) status = core1_msgdma_irq_start();
+
+    if (status == ALT_E_SUCCESS) status = doorbell_init();
+    if (status == ALT_E_SUCCESS) status = doorbell_register(DB_CORE0_READY, core0_ready_db, NULL, DOORBELL_ISR);
+    if (status == ALT_E_SUCCESS) status = wave_prep_server_init();   // comandi dal loop (doorbell_poll)
+    //dsp_bench();                 // kernel complessi NEON vs scalare
+    //dsp_fft_bench(16384u);       // FFT NEON vs scalare, Q15 vs float
 
    __asm__ volatile("cpsie i");
 
-    // Attendi che Core0 abbia inizializzato tutto e “aperto” l’handshake
-    while (SHM_CTRL->magic != SHM_MAGIC_BOOT) { /* spin */ }
-    while (SHM_CTRL->core0_ready != 1u)        { /* spin */ }
+    // Attendi il doorbell di Core0 (init finita): niente spin su SHM, si dorme fino all'SGI
+    while (!s_core0_ready) { __asm__ volatile("wfi"); }
+    __asm__ volatile("dmb sy" ::: "memory");   // SHM di Core0 letta dopo core0_ready
 
     // Saluta e dichiara “ready”
 
     printf("\n\rHello from HPS - Core 1. SHM @ 0x");
     (void)uart_stdio_write_hex32((uint32_t)SHM_BASE);
     printf(" - Now it's ready.");
+    __asm__ volatile("dmb sy" ::: "memory");   // init di Core1 in SHM prima del flag
     SHM_CTRL->core1_ready = 1u;
     __asm__ volatile("dmb sy" ::: "memory");
+    (void)doorbell_ring(DB_CORE1_READY);
 
     sched_insert(CORE1,SCHED_PERIODIC,ledsys_core1,300);
+    sched_insert(CORE1,SCHED_PERIODIC,irq_stats_report,1000);
+    if (status == ALT_E_SUCCESS) status = core1_health_start();   // heartbeat in SHM per Core0
+    trace_log(TRACE_BOOT, 1u);
 
     if (status == ALT_E_SUCCESS) {
     	while (1) {
     		SHM_CTRL->trig_count++;
     		sched_manager(CORE1);
+    		(void)dma_copy_poll();
+    		(void)doorbell_poll();
     	}
     }
 }
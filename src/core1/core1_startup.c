@@ -41,6 +41,22 @@ static inline void icache_invalidate_all(void)
     __asm__ volatile ("isb");
 }
 
+/* Accesso pieno a CP10/CP11 (CPACR) e FPEXC.EN: alt_base.c (che lo fa su Core0)
+ * non è nel build di Core1. Senza, il primo vmrs/vpush di core1_irq_entry o il
+ * primo kernel NEON (wave_prep, dsp_cplx, dsp_fft) finisce in Undefined. */
+static inline void vfp_neon_enable(void)
+{
+    uint32_t r;
+    __asm__ volatile(
+        "mrc  p15,0,%0,c1,c0,2  \n\t"
+        "orr  %0,%0,#(0xF<<20)  \n\t"   /* cp10/cp11 = 0b11 (PL0 e PL1) */
+        "mcr  p15,0,%0,c1,c0,2  \n\t"
+        "isb                    \n\t"
+        "mov  %0,#0x40000000    \n\t"   /* FPEXC.EN */
+        "vmsr fpexc,%0          \n\t"
+        : "=&r"(r) :: "memory");
+}
+
 /* Inizializza TUTTI gli stack delle modalità bancate (SVC/IRQ/FIQ/ABT/UND/SYS) */
 static inline void init_all_mode_stacks(uintptr_t sp_top)
 {
@@ -110,6 +126,9 @@ core1_startup_body(void)
     cpsid_if();
     set_low_vectors_and_vbar((void *)__core1_vectors);
 
+    /* VFP/NEON prima di qualunque IRQ (l'ingresso IRQ salva d0-d31/FPSCR) */
+    vfp_neon_enable();
+
     /* 1) Inizializza tutti gli stack bancati in DDR */
     init_all_mode_stacks((uintptr_t)&__stack_top__);
 
@@ -0,0 +1,210 @@
+// core1_wave_prep.c
+// Core1: esecuzione dei comandi di preparazione COEF/PULSE (coda in SHM, vedi wave_prep.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "alt_globaltmr.h"
+#include "wave_prep.h"
+#include "wave_loader.h"
+#include "doorbell.h"
+#include "dsp_cplx.h"
+#include "dsp_fft.h"
+#include "mem_pool.h"
+#include "arm_mem_regions.h"
+#include "trace_log.h"
+
+// ---------------------------
+// Conversione (a blocchi, kernel dsp_cplx)
+// ---------------------------
+static float s_re[DSP_BLOCK], s_im[DSP_BLOCK], s_w[DSP_BLOCK];
+
+/* Campioni [i, i+m) della sorgente in piani float; F32_PLANAR si usa in place */
+static void wp_load(const wave_prep_cmd_t *c, uint32_t i, uint32_t m, const float **re, const float **im)
+{
+    const uint32_t n = c->src_count;
+    *re = s_re;
+    *im = s_im;
+    switch (c->fmt) {
+        case WAVE_PREP_FMT_S16_IQ:
+            dsp_deint_s16((const int16_t *)(uintptr_t)c->src_addr + 2u * i, s_re, s_im, m, 1.0f / 32768.0f);
+            break;
+        case WAVE_PREP_FMT_S16_PLANAR: {
+            const int16_t *p = (const int16_t *)(uintptr_t)c->src_addr;
+            dsp_s16_f32(p + i,     s_re, m, 1.0f / 32768.0f);
+            dsp_s16_f32(p + n + i, s_im, m, 1.0f / 32768.0f);
+        } break;
+        case WAVE_PREP_FMT_F32_IQ:
+            dsp_deint_f32((const float *)(uintptr_t)c->src_addr + 2u * i, s_re, s_im, m);
+            break;
+        default: {
+            const float *p = (const float *)(uintptr_t)c->src_addr;
+            *re = p + i;
+            *im = p + n + i;
+        } break;
+    }
+}
+
+static uint32_t src_bytes(const wave_prep_cmd_t *c)
+{
+    uint32_t b = (c->fmt <= WAVE_PREP_FMT_S16_PLANAR) ? 2u : 4u;
+    return c->src_count * 2u * b;
+}
+
+static bool in_range(uint32_t a, uint32_t len, uint32_t lo, uint32_t size)
+{
+    return (a >= lo) && (len <= size) && (a - lo <= size - len);
+}
+
+static ALT_STATUS_CODE cmd_check(const wave_prep_cmd_t *c)
+{
+    if (c->op != WAVE_PREP_OP_BUILD && c->op != WAVE_PREP_OP_COEF) return ALT_E_BAD_ARG;
+    if (c->fmt >= WAVE_PREP_FMT_QTY || c->window >= WAVE_PREP_WIN_QTY) return ALT_E_BAD_ARG;
+    if (c->dst_len == 0u || (c->dst_len % WAVE_PREP_SAMPLE_BYTES) || (c->dst_addr & 3u)) return ALT_E_ARG_RANGE;
+    if (c->src_count == 0u || c->src_count > c->dst_len / WAVE_PREP_SAMPLE_BYTES) return ALT_E_ARG_RANGE;
+
+    // scrive solo nella libreria DDR o nello staging; legge solo SHM o libreria
+    bool dst_ok = in_range(c->dst_addr, c->dst_len, DDR3_BASE, DDR3_SIZE) ||
+                  in_range(c->dst_addr, c->dst_len, WAVE_PREP_STAGE(0),
+                           WAVE_PREP_STAGE_SLOTS * WAVE_PREP_STAGE_BYTES);
+    bool src_ok = in_range(c->src_addr, src_bytes(c), SHM_BASE, SHM_SIZE) ||
+                  in_range(c->src_addr, src_bytes(c), DDR3_BASE, DDR3_SIZE);
+    return (dst_ok && src_ok) ? ALT_E_SUCCESS : ALT_E_BAD_ARG;
+}
+
+static ALT_STATUS_CODE cmd_build(const wave_prep_cmd_t *c, wave_prep_rsp_t *r)
+{
+    ALT_STATUS_CODE s = cmd_check(c);
+    if (s != ALT_E_SUCCESS) return s;
+
+    // sorgente scritta da altri (PL330, Core0): niente linee vecchie in cache
+    (void)arm_cache_invalidate_range((void *)(uintptr_t)c->src_addr, src_bytes(c));
+
+    uint32_t *dst = (uint32_t *)(uintptr_t)c->dst_addr;
+    const uint32_t n_out = c->dst_len / WAVE_PREP_SAMPLE_BYTES;
+    uint32_t clip = 0u;
+    dsp_win_t w;
+    dsp_win_init(&w, (dsp_win_type_t)c->window, c->src_count);
+
+    for (uint32_t i = 0; i < c->src_count; i += DSP_BLOCK) {
+        uint32_t m = c->src_count - i;
+        if (m > DSP_BLOCK) m = DSP_BLOCK;
+
+        const float *re, *im;
+        wp_load(c, i, m, &re, &im);
+        if (c->window != WAVE_PREP_WIN_NONE) {
+            dsp_win_block(&w, s_w, m);
+            dsp_window_f32(re, im, s_w, s_re, s_im, m);
+            re = s_re;
+            im = s_im;
+        }
+        clip += dsp_q15_iq(re, im, c->gain, (int16_t *)(dst + i), m);
+    }
+    for (uint32_t i = c->src_count; i < n_out; ++i) dst[i] = 0u;   // coda a zero
+
+    // l'entry la leggono i DMA (mSGDMA/PL330): fuori dalla D-cache
+    (void)arm_cache_clean_range(dst, c->dst_len);
+
+    r->crc     = wave_crc32(0u, dst, c->dst_len);
+    r->clipped = clip;
+    return ALT_E_SUCCESS;
+}
+
+/* COEF = gain * conj(FFT(sorgente finestrata, zero padding a dst_len/4 punti)) */
+static float *s_fre, *s_fim;        // DSP_FFT_MAX_N punti, dall'arena DDR al primo uso
+
+static ALT_STATUS_CODE cmd_coef(const wave_prep_cmd_t *c, wave_prep_rsp_t *r)
+{
+    ALT_STATUS_CODE s = cmd_check(c);
+    if (s != ALT_E_SUCCESS) return s;
+
+    const uint32_t n = c->dst_len / WAVE_PREP_SAMPLE_BYTES;
+    if ((n & (n - 1u)) || n > DSP_FFT_MAX_N) return ALT_E_ARG_RANGE;
+
+    if (!s_fre) {
+        mem_arena_t *a = mem_arena_get(MEM_REGION_DDR);
+        float *re = (float *)mem_arena_alloc(a, DSP_FFT_MAX_N * sizeof(float), MEM_POOL_ALIGN);
+        float *im = (float *)mem_arena_alloc(a, DSP_FFT_MAX_N * sizeof(float), MEM_POOL_ALIGN);
+        if (!re || !im) return ALT_E_ERROR;
+        s_fre = re;
+        s_fim = im;
+    }
+
+    (void)arm_cache_invalidate_range((void *)(uintptr_t)c->src_addr, src_bytes(c));
+
+    dsp_win_t w;
+    dsp_win_init(&w, (dsp_win_type_t)c->window, c->src_count);
+    for (uint32_t i = 0; i < c->src_count; i += DSP_BLOCK) {
+        uint32_t m = c->src_count - i;
+        if (m > DSP_BLOCK) m = DSP_BLOCK;
+
+        const float *re, *im;
+        wp_load(c, i, m, &re, &im);
+        if (c->window != WAVE_PREP_WIN_NONE) {
+            dsp_win_block(&w, s_w, m);
+            dsp_window_f32(re, im, s_w, s_fre + i, s_fim + i, m);
+        } else {
+            memcpy(s_fre + i, re, m * sizeof(float));
+            memcpy(s_fim + i, im, m * sizeof(float));
+        }
+    }
+    memset(s_fre + c->src_count, 0, (n - c->src_count) * sizeof(float));
+    memset(s_fim + c->src_count, 0, (n - c->src_count) * sizeof(float));
+
+    s = dsp_fft_f32(s_fre, s_fim, n);
+    if (s != ALT_E_SUCCESS) return s;
+
+    uint32_t *dst = (uint32_t *)(uintptr_t)c->dst_addr;
+    dsp_scale_f32(s_fim, s_fim, n, -1.0f);                         // coniugato
+    r->clipped = dsp_q15_iq(s_fre, s_fim, c->gain, (int16_t *)dst, n);
+
+    (void)arm_cache_clean_range(dst, c->dst_len);
+    r->crc = wave_crc32(0u, dst, c->dst_len);
+    return ALT_E_SUCCESS;
+}
+
+// ---------------------------
+// Coda
+// ---------------------------
+uint32_t wave_prep_server_poll(void)
+{
+    wave_prep_shm_t *q = WAVE_PREP_SHM;
+    uint32_t n = 0u;
+
+    while (q->cmd_tail != q->cmd_head) {
+        __asm__ volatile("dmb sy" ::: "memory");   // indice letto prima del comando
+        wave_prep_cmd_t c = q->cmd[q->cmd_tail & (WAVE_PREP_QDEPTH - 1u)];
+
+        wave_prep_rsp_t r = { .seq = c.seq };
+        trace_log(TRACE_WPREP_CMD, c.seq);
+        uint32_t t0 = alt_globaltmr_counter_get_low32();
+        r.status = (c.op == WAVE_PREP_OP_COEF) ? cmd_coef(&c, &r) : cmd_build(&c, &r);
+        r.ticks  = alt_globaltmr_counter_get_low32() - t0;
+
+        // Core0 non ha più di WAVE_PREP_QDEPTH comandi aperti: la coda risposte non si riempie
+        q->rsp[q->rsp_head & (WAVE_PREP_QDEPTH - 1u)] = r;
+        __asm__ volatile("dmb sy" ::: "memory");
+        q->rsp_head = q->rsp_head + 1u;
+        q->cmd_tail = q->cmd_tail + 1u;
+        n++;
+    }
+
+    if (n) (void)doorbell_ring(DB_RSP_TO_CORE0);   // una sola suonata per il lotto
+    return n;
+}
+
+static void cmd_db(doorbell_ch_t ch, uint32_t rings, void *ctx)
+{
+    (void)ch; (void)rings; (void)ctx;
+    (void)wave_prep_server_poll();
+}
+
+ALT_STATUS_CODE wave_prep_server_init(void)
+{
+    // comandi in coda prima della registrazione: li consegna doorbell_register,
+    // quelli accodati durante un ripristino (suonate azzerate) li prende il poll
+    ALT_STATUS_CODE s = doorbell_register(DB_CMD_TO_CORE1, cmd_db, NULL, DOORBELL_TASK);
+    if (s == ALT_E_SUCCESS) (void)wave_prep_server_poll();
+    return s;
+}
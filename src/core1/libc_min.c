@@ -5,6 +5,7 @@
 #include <stdarg.h>
 
 #include "alt_printf.h"
+#include "fmt_min.h"
 
 #undef printf
 #undef vprintf
@@ -38,16 +39,17 @@ void *memmove(void *dst, const void *src, size_t n)
 }
 
 
+/* printf di Core1 -> fmt_min (solo interi, niente divisioni 64 bit di alt_vfprintf) */
 int vprintf(const char *format, va_list args)
 {
-    return alt_vfprintf(DEFAULT_TERM, format, args);
+    return fmt_vprintf(format, args);
 }
 
 int printf(const char *format, ...)
 {
     va_list args;
     va_start(args, format);
-    int rc = alt_vfprintf(DEFAULT_TERM, format, args);
+    int rc = fmt_vprintf(format, args);
     va_end(args);
     return rc;
 }
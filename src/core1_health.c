@@ -0,0 +1,211 @@
+// core1_health.c
+// Heartbeat di Core1 in SHM, controllo e ripristino da Core0 (reset CPU1 + core1_boot_from_ddr).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "core1_health.h"
+#include "fmt_min.h"
+
+extern volatile unsigned long core1_ticks;
+
+// schedule.h definisce CORE0/CORE1 come indici: va incluso dopo il test sul build
+#if defined(CORE1)
+
+#include "schedule.h"
+
+volatile uint32_t core1_irq_pc;     // scritto da core1_irq_entry (core1_vectors.S)
+
+static void core1_health_beat(void)
+{
+    SHM_CTRL->hb_count = SHM_CTRL->hb_count + 1u;
+}
+
+ALT_STATUS_CODE core1_health_start(void)
+{
+    SHM_CTRL->fault_type = CORE1_FAULT_NONE;
+    return sched_insert(CORE1, SCHED_PERIODIC, core1_health_beat, CORE1_HEALTH_BEAT_MS) ? ALT_E_SUCCESS : ALT_E_ERROR;
+}
+
+void core1_health_tick(void)
+{
+    SHM_CTRL->hb_pc    = core1_irq_pc;
+    SHM_CTRL->hb_task  = (uint32_t)(uintptr_t)sched_current(CORE1);
+    SHM_CTRL->hb_ticks = (uint32_t)core1_ticks;
+}
+
+/* Da crash_dump_c, dopo il record persistente: fault in SHM per core1_health */
+void core1_fault_publish(uint32_t type, uint32_t pc, uint32_t psr, uint32_t fsr, uint32_t far)
+{
+    SHM_CTRL->fault_pc  = pc;
+    SHM_CTRL->fault_psr = psr;
+    SHM_CTRL->fault_fsr = fsr;
+    SHM_CTRL->fault_far = far;
+    __asm__ volatile("dmb sy" ::: "memory");
+    SHM_CTRL->fault_type = type;                   // per ultimo: il resto è valido
+    __asm__ volatile("dsb sy" ::: "memory");
+}
+
+#else   /* Core0 */
+
+#include "qspi.h"
+#include "dma_copy.h"
+#include "wave_prep.h"
+#include "crash_dump.h"
+#include "trace_log.h"
+#include "schedule.h"
+
+typedef struct {
+    core1_health_state_t state;
+    bool         auto_restart;
+    uint32_t     timeout_ms;
+    uint32_t     since;             // core0_ticks: inizio boot / ultimo cambio di hb
+    uint32_t     last_hb;
+    uint32_t     last_ticks;        // hb_ticks all'ultimo cambio
+    uint32_t     stalls;
+    uint32_t     restarts;
+    uint32_t     consecutive;       // ripristini senza tornare OK
+    core1_diag_t diag;
+} core1_health_t;
+
+static core1_health_t s_h = { .auto_restart = true, .timeout_ms = CORE1_HEALTH_TIMEOUT_MS };
+
+static const char *const s_reason[] = { "heartbeat", "fault", "boot" };
+static const char *const s_fault[]  = { "-", "undef", "pabt", "dabt" };
+
+static void health_capture(uint32_t now, uint32_t reason)
+{
+    core1_diag_t *d = &s_h.diag;
+    d->when       = now;
+    d->reason     = reason;
+    d->hb         = SHM_CTRL->hb_count;
+    d->stalled_ms = now - s_h.since;
+    d->pc         = SHM_CTRL->hb_pc;
+    d->task       = SHM_CTRL->hb_task;
+    d->ticks      = SHM_CTRL->hb_ticks - s_h.last_ticks;
+    d->fault_type = SHM_CTRL->fault_type;
+    d->fault_pc   = SHM_CTRL->fault_pc;
+    d->fault_psr  = SHM_CTRL->fault_psr;
+    d->fault_fsr  = SHM_CTRL->fault_fsr;
+    d->fault_far  = SHM_CTRL->fault_far;
+    s_h.stalls++;
+}
+
+static void health_print(const core1_diag_t *d)
+{
+    fmt_printf("\r\nCORE1 %s: hb %u fermo da %u ms, pc 0x%08X task 0x%08X tick %u",
+               s_reason[d->reason & 3u], d->hb, d->stalled_ms, d->pc, d->task, d->ticks);
+    if (d->fault_type)
+        fmt_printf("\r\nCORE1 fault %s: pc 0x%08X psr 0x%08X fsr 0x%08X far 0x%08X",
+                   s_fault[d->fault_type & 3u], d->fault_pc, d->fault_psr, d->fault_fsr, d->fault_far);
+}
+
+static void health_stall(uint32_t now, uint32_t reason)
+{
+    health_capture(now, reason);
+    health_print(&s_h.diag);
+    if (reason == 1u) (void)crash_dump_report();   // record completo di Core1 in SHM
+    trace_log(TRACE_C1_STALL, reason);
+
+    if (!s_h.auto_restart || s_h.consecutive >= CORE1_HEALTH_MAX_RESTARTS) {
+        s_h.state = CORE1_HEALTH_STALLED;
+        fmt_printf("\r\nCORE1: nessun ripristino automatico (%u tentativi)", s_h.consecutive);
+        return;
+    }
+    (void)core1_health_restart();
+}
+
+ALT_STATUS_CODE core1_health_restart(void)
+{
+    core1_hold_reset();             // da qui Core1 non tocca più SHM, PL330 e DDR
+    dma_copy_stop_peer();           // transfer PL330 4..7 lasciati a metà
+    wave_prep_abort(ALT_E_TMO);     // comandi aperti chiusi con errore
+
+    s_h.restarts++;
+    trace_log(TRACE_C1_RESTART, s_h.restarts);
+    s_h.consecutive++;
+    s_h.state = CORE1_HEALTH_BOOTING;
+    s_h.since = (uint32_t)get_Time(CORE0);
+
+    int r = core1_restart();        // SHM + doorbell, QSPI -> DDR, CPU1 fuori dal reset
+    fmt_printf("\r\nCORE1: ripristino %u (%s)", s_h.restarts, (r == 0) ? "avviato" : "fallito");
+    return (r == 0) ? ALT_E_SUCCESS : ALT_E_ERROR;
+}
+
+void core1_health_check(void)
+{
+    const uint32_t now = (uint32_t)get_Time(CORE0);
+
+    switch (s_h.state) {
+        case CORE1_HEALTH_BOOTING:
+            if (SHM_CTRL->fault_type != CORE1_FAULT_NONE) {
+                health_stall(now, 1u);
+            } else if (SHM_CTRL->core1_ready == 1u) {
+                __asm__ volatile("dmb sy" ::: "memory");   // heartbeat letto dopo il flag
+                s_h.state       = CORE1_HEALTH_OK;
+                s_h.consecutive = 0u;
+                s_h.last_hb     = SHM_CTRL->hb_count;
+                s_h.last_ticks  = SHM_CTRL->hb_ticks;
+                s_h.since       = now;
+            } else if (now - s_h.since >= CORE1_HEALTH_BOOT_MS) {
+                health_stall(now, 2u);
+            }
+            break;
+
+        case CORE1_HEALTH_OK: {
+            uint32_t hb = SHM_CTRL->hb_count;
+            if (SHM_CTRL->fault_type != CORE1_FAULT_NONE) {
+                health_stall(now, 1u);
+            } else if (hb != s_h.last_hb) {
+                s_h.last_hb    = hb;
+                s_h.last_ticks = SHM_CTRL->hb_ticks;
+                s_h.since      = now;
+            } else if (now - s_h.since >= s_h.timeout_ms) {
+                health_stall(now, 0u);
+            }
+        } break;
+
+        default:
+            break;
+    }
+}
+
+ALT_STATUS_CODE core1_health_init(uint32_t timeout_ms)
+{
+    core1_health_timeout_set(timeout_ms);
+    s_h.state = CORE1_HEALTH_BOOTING;       // core1_on appena chiamata
+    s_h.since = (uint32_t)get_Time(CORE0);
+    return sched_insert(CORE0, SCHED_PERIODIC, core1_health_check, CORE1_HEALTH_CHECK_MS) ? ALT_E_SUCCESS : ALT_E_ERROR;
+}
+
+void core1_health_timeout_set(uint32_t timeout_ms)
+{
+    // 0 o pochi battiti persi: default (un task lento di Core1 non è un blocco)
+    s_h.timeout_ms = (timeout_ms < 4u * CORE1_HEALTH_BEAT_MS) ? CORE1_HEALTH_TIMEOUT_MS : timeout_ms;
+}
+
+void core1_health_auto_restart(bool enable)
+{
+    s_h.auto_restart = enable;
+    if (enable && s_h.state == CORE1_HEALTH_STALLED) s_h.consecutive = 0u;
+}
+
+core1_health_state_t core1_health_state(void)
+{
+    return s_h.state;
+}
+
+const core1_diag_t *core1_health_last(void)
+{
+    return s_h.stalls ? &s_h.diag : NULL;
+}
+
+void core1_health_dump(void)
+{
+    static const char *const st[] = { "off", "boot", "ok", "bloccato" };
+    fmt_printf("\r\nCORE1 health: %s hb %u timeout %u ms stalli %u ripristini %u auto %u",
+               st[s_h.state & 3u], SHM_CTRL->hb_count, s_h.timeout_ms, s_h.stalls, s_h.restarts,
+               (uint32_t)s_h.auto_restart);
+    if (s_h.stalls) health_print(&s_h.diag);
+}
+
+#endif
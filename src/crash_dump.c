@@ -0,0 +1,254 @@
+// crash_dump.c
+// Record di fault persistente in SHM (registri, FSR/FAR, stack, trace) e report al boot.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "crash_dump.h"
+#include "trace_log.h"
+#include "wave_loader.h"
+#include "fmt_min.h"
+#include "interrupts.h"
+
+#if defined(CORE1)
+#include "core1_health.h"
+#define CRASH_CORE          1u
+extern volatile unsigned long core1_ticks;
+#define CRASH_UPTIME()      ((uint32_t)core1_ticks)
+// stack unico per tutte le modalità (arria10-core1-ddr.ld); sotto c'è la guard page
+extern uint8_t __stack_limit__;
+extern uint8_t __stack_top__;
+#define CRASH_STACK_LO      ((uint32_t)(uintptr_t)&__stack_limit__)
+#define CRASH_STACK_HI      ((uint32_t)(uintptr_t)&__stack_top__)
+#else
+#include "alt_reset_manager.h"
+#define CRASH_CORE          0u
+extern unsigned long core0_ticks;
+#define CRASH_UPTIME()      ((uint32_t)core0_ticks)
+// immagine e stack di Core0 in OCRAM (arria10-core0-ocr.ld)
+#define CRASH_STACK_LO      0xFFE00000u
+#define CRASH_STACK_HI      0xFFE40000u
+#endif
+
+_Static_assert(sizeof(crash_rec_t) <= CRASH_DUMP_SLOT_BYTES, "crash_rec_t oltre lo slot");
+
+extern uint32_t crash_regs[13];     // crash_entry.S
+
+#define CRASH_CRC_OFS       offsetof(crash_rec_t, core)
+
+static const char *const s_type[CRASH_TYPE_QTY] = { "-", "undef", "pabt", "dabt", "watchdog" };
+
+// ---------------------------
+// Cattura (modo UND/ABT, IRQ/FIQ mascherati dall'eccezione)
+// ---------------------------
+
+/* sp/lr bancati del modo interrotto; USR li condivide con SYS */
+static void banked_sp_lr(uint32_t mode, uint32_t *sp, uint32_t *lr)
+{
+    uint32_t cur, tmp, s, l;
+    if (mode == 0x10u) mode = 0x1Fu;
+
+    __asm__ volatile("mrs %0, cpsr" : "=r"(cur));
+    if ((cur & 0x1Fu) == mode) {        // fault nel gestore stesso: sp/lr già riscritti
+        *sp = 0u;
+        *lr = 0u;
+        return;
+    }
+
+    tmp = (cur & ~0x1Fu) | mode;
+    __asm__ volatile(
+        "msr    cpsr_c, %2      \n\t"
+        "mov    %0, sp          \n\t"
+        "mov    %1, lr          \n\t"
+        "msr    cpsr_c, %3      \n\t"
+        : "=&r"(s), "=&r"(l)
+        : "r"(tmp), "r"(cur)
+        : "memory");
+    *sp = s;
+    *lr = l;
+}
+
+static void crash_park(void) __attribute__((noreturn));
+static void crash_park(void)
+{
+    __asm__ volatile("cpsid if" ::: "memory");
+    for (;;) __asm__ volatile("wfi");
+}
+
+static void crash_finish(void) __attribute__((noreturn));
+static void crash_finish(void)
+{
+#if !defined(CORE1) && CRASH_DUMP_RESET_CORE0
+    // SDRAM in self-refresh durante il reset: il record in SHM resta
+    (void)alt_reset_warm_reset(0x80u, 0x800u, true, false, false, false);
+#endif
+    crash_park();
+}
+
+/* Riempie lo slot del core: registri già in r->r/sp/lr, il resto qui. magic per ultimo. */
+static void crash_commit(crash_rec_t *r, uint32_t count, uint32_t type, uint32_t pc, uint32_t cpsr,
+                         uint32_t fsr, uint32_t far, uint32_t info)
+{
+    r->core      = CRASH_CORE;
+    r->type      = type;
+    r->count     = count + 1u;
+    r->uptime_ms = CRASH_UPTIME();
+    r->pc   = pc;
+    r->cpsr = cpsr;
+    r->fsr  = fsr;
+    r->far  = far;
+    r->info = info;
+
+    // stack solo dentro la finestra nota: uno sp corrotto non deve causare un altro abort
+    uint32_t sp = r->sp & ~3u, n = 0u;
+    if (sp >= CRASH_STACK_LO && sp < CRASH_STACK_HI) {
+        n = (CRASH_STACK_HI - sp) / 4u;
+        if (n > CRASH_DUMP_STACK_WORDS) n = CRASH_DUMP_STACK_WORDS;
+        for (uint32_t i = 0; i < n; ++i) r->stack[i] = ((const volatile uint32_t *)(uintptr_t)sp)[i];
+    }
+    r->stack_words = n;
+
+    r->trace_n = trace_log_copy(r->trace, CRASH_DUMP_TRACE);
+
+    r->crc      = wave_crc32(0u, (const uint8_t *)r + CRASH_CRC_OFS, sizeof(*r) - CRASH_CRC_OFS);
+    r->reported = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
+    r->magic = CRASH_DUMP_MAGIC;            // per ultimo: il resto è valido
+    __asm__ volatile("dsb sy" ::: "memory");
+}
+
+/* Slot del core invalidato durante la scrittura; ritorna i fault già contati */
+static uint32_t crash_open(crash_rec_t *r)
+{
+    uint32_t count = (crash_dump_get(CRASH_CORE) != NULL) ? r->count : 0u;
+    r->magic = 0u;
+    return count;
+}
+
+void crash_dump_c(uint32_t type, uint32_t lr, uint32_t spsr)
+{
+    static volatile uint32_t s_busy;
+    if (s_busy++) crash_finish();       // fault durante il dump: il record resta invalido
+
+    crash_rec_t *r = CRASH_DUMP_SLOT(CRASH_CORE);
+    uint32_t count = crash_open(r);
+
+    // pc dell'istruzione: lr = pc+4 (undef ARM), +2 (undef Thumb), +4 (pabt), +8 (dabt)
+    bool thumb = (spsr & (1u << 5)) != 0u;
+    uint32_t pc = lr - ((type == CRASH_DABT) ? 8u : (type == CRASH_UNDEF && thumb) ? 2u : 4u);
+
+    uint32_t fsr = 0u, far = 0u;
+    if (type == CRASH_DABT) {
+        __asm__ volatile("mrc p15, 0, %0, c5, c0, 0" : "=r"(fsr));   // DFSR
+        __asm__ volatile("mrc p15, 0, %0, c6, c0, 0" : "=r"(far));   // DFAR
+    } else if (type == CRASH_PABT) {
+        __asm__ volatile("mrc p15, 0, %0, c5, c0, 1" : "=r"(fsr));   // IFSR
+        __asm__ volatile("mrc p15, 0, %0, c6, c0, 2" : "=r"(far));   // IFAR
+    }
+
+    for (uint32_t i = 0; i < 13u; ++i) r->r[i] = crash_regs[i];
+    banked_sp_lr(spsr & 0x1Fu, &r->sp, &r->lr);
+    crash_commit(r, count, type, pc, spsr, fsr, far, 0u);
+
+#if defined(CORE1)
+    core1_fault_publish(type, pc, spsr, fsr, far);
+#endif
+    crash_finish();
+}
+
+void crash_dump_soft(uint32_t type, uint32_t info)
+{
+    uint32_t cpsr = arm_irq_save();
+    crash_rec_t *r = CRASH_DUMP_SLOT(CRASH_CORE);
+    uint32_t count = crash_open(r);
+
+    uint32_t sp, psr;
+    __asm__ volatile("mov %0, sp" : "=r"(sp));
+    __asm__ volatile("mrs %0, cpsr" : "=r"(psr));
+    for (uint32_t i = 0; i < 13u; ++i) r->r[i] = 0u;    // contesto C: nessun registro significativo
+    r->sp = sp;
+    r->lr = 0u;
+    crash_commit(r, count, type, (uint32_t)(uintptr_t)__builtin_return_address(0), psr, 0u, 0u, info);
+
+    arm_irq_restore(cpsr);
+}
+
+// ---------------------------
+// Lettura / report
+// ---------------------------
+const crash_rec_t *crash_dump_get(uint32_t core)
+{
+    if (core > 1u) return NULL;
+    const crash_rec_t *r = CRASH_DUMP_SLOT(core);
+    if (r->magic != CRASH_DUMP_MAGIC || r->core != core) return NULL;
+    if (wave_crc32(0u, (const uint8_t *)r + CRASH_CRC_OFS, sizeof(*r) - CRASH_CRC_OFS) != r->crc) return NULL;
+    return r;
+}
+
+void crash_dump_clear(uint32_t core)
+{
+    if (core > 1u) return;
+    CRASH_DUMP_SLOT(core)->magic = 0u;
+}
+
+/* Stato di FSR[10,3:0] (short descriptor, ARMv7-A) */
+static const char *fsr_name(uint32_t fsr)
+{
+    switch (((fsr >> 6) & 0x10u) | (fsr & 0x0Fu)) {
+        case 0x01: return "allineamento";
+        case 0x02: return "debug";
+        case 0x03: return "access flag (section)";
+        case 0x06: return "access flag (page)";
+        case 0x05: return "traduzione (section)";
+        case 0x07: return "traduzione (page)";
+        case 0x09: return "dominio (section)";
+        case 0x0B: return "dominio (page)";
+        case 0x0D: return "permessi (section)";
+        case 0x0F: return "permessi (page)";
+        case 0x08: return "external abort sincrono";
+        case 0x16: return "external abort asincrono";
+        case 0x0C:
+        case 0x0E: return "external abort su table walk";
+        default:   return "?";
+    }
+}
+
+void crash_dump_print(const crash_rec_t *r)
+{
+    if (!r) return;
+
+    fmt_printf("\r\nCRASH core%u: %s a pc 0x%08X (n. %u, uptime %u ms)",
+               r->core, s_type[r->type < CRASH_TYPE_QTY ? r->type : 0u], r->pc, r->count, r->uptime_ms);
+    if (r->type == CRASH_DABT || r->type == CRASH_PABT)
+        fmt_printf("\r\n  fsr 0x%08X (%s%s) far 0x%08X", r->fsr, fsr_name(r->fsr),
+                   (r->type == CRASH_DABT && (r->fsr & (1u << 11))) ? ", scrittura" : "", r->far);
+    if (r->type == CRASH_WDOG)
+        fmt_printf("\r\n  controlli falliti 0x%08X (bit = ordine di wdog_mgr_register)", r->info);
+    fmt_printf("\r\n  cpsr 0x%08X sp 0x%08X lr 0x%08X", r->cpsr, r->sp, r->lr);
+    for (uint32_t i = 0; i < 13u; i += 4u) {
+        fmt_printf("\r\n  r%-2u 0x%08X", i, r->r[i]);
+        for (uint32_t k = i + 1u; k < i + 4u && k < 13u; ++k) fmt_printf("  r%-2u 0x%08X", k, r->r[k]);
+    }
+
+    if (r->stack_words == 0u) fmt_printf("\r\n  stack: sp fuori dalla finestra dello stack");
+    for (uint32_t i = 0; i < r->stack_words && i < CRASH_DUMP_STACK_WORDS; i += 4u) {
+        fmt_printf("\r\n  [sp+0x%03X]", i * 4u);
+        for (uint32_t k = i; k < i + 4u && k < r->stack_words; ++k) fmt_printf(" %08X", r->stack[k]);
+    }
+
+    fmt_printf("\r\n  trace (%u voci, tick global timer prima dell'ultima):", r->trace_n);
+    trace_log_print(r->trace, (r->trace_n < CRASH_DUMP_TRACE) ? r->trace_n : CRASH_DUMP_TRACE);
+}
+
+uint32_t crash_dump_report(void)
+{
+    uint32_t n = 0u;
+    for (uint32_t core = 0; core < 2u; ++core) {
+        crash_rec_t *r = (crash_rec_t *)crash_dump_get(core);
+        if (!r || r->reported) continue;
+        crash_dump_print(r);
+        r->reported = 1u;                   // fuori CRC: il record resta valido
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,393 @@
+// dma_copy.c
+// Copia/azzeramento memoria asincroni su PL330 con pool di canali per core,
+// callback di completamento (IRQ DMA o polling) e fallback CPU sincrono.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "alt_dma.h"
+#include "alt_interrupt.h"
+#include "dma_copy.h"
+#include "interrupts.h"
+#include "arm_mem_regions.h"
+#include "trace_log.h"
+#include "shared_ipc.h"
+#include "socal/socal.h"
+#include "socal/hps.h"
+
+#if defined(CORE1)
+#define DMA_COPY_CH_BASE   4u      // thread/eventi 4..7
+#define DMA_COPY_CORE      1u
+#else
+#define DMA_COPY_CH_BASE   0u      // thread/eventi 0..3
+#define DMA_COPY_CORE      0u
+#endif
+
+#define PL330_DBGSTATUS    ((uintptr_t)ALT_DMA_SCTL_ADDR + 0xD00u)    // bit0: debug instruction in corso
+
+typedef struct {
+    ALT_DMA_CHANNEL_t  ch;
+    ALT_DMA_EVENT_t    evt;
+    bool               alloc;
+    volatile bool      busy;
+    dma_copy_cb_t      cb;
+    void              *ctx;
+    void              *dst;
+    size_t             len;
+    ALT_DMA_PROGRAM_t  pgm;        // deve vivere per tutta la durata del transfer
+} dma_slot_t;
+
+static dma_slot_t       s_slot[DMA_COPY_CH_PER_CORE];
+static bool             s_ready;
+static dma_copy_stats_t s_stats;
+
+// ---------------------------
+// Lock PL330 tra i core
+// ---------------------------
+/*
+ * Ogni core ha la sua istanza di alt_dma, ma l'interfaccia di debug
+ * (DBGINST0/1 + DBGCMD: DMAGO, DMAKILL) e INTEN (read-modify-write in
+ * alt_dma_event_int_select) sono uniche. Tutto ciò che le tocca passa da qui.
+ * Peterson a due core su SHM invece di ldrex/strex: la SHM è Normal-NC e le
+ * esclusive su memoria non cacheable dipendono dal monitor globale
+ * dell'interconnessione. Preso con IRQ mascherati (anche ISR e poll lo usano).
+ */
+static uint32_t pl330_lock(void)
+{
+    const uint32_t me = DMA_COPY_CORE, peer = 1u - DMA_COPY_CORE;
+    uint32_t cpsr = arm_irq_save();
+
+    SHM_CTRL->pl330_want[me] = 1u;
+    __asm__ volatile("dmb sy" ::: "memory");
+    SHM_CTRL->pl330_turn = peer;
+    __asm__ volatile("dmb sy" ::: "memory");
+    while (SHM_CTRL->pl330_want[peer] && SHM_CTRL->pl330_turn == peer) { }
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    // il DBGCMD dell'altro core può essere ancora in esecuzione
+    while (alt_read_word(PL330_DBGSTATUS) & 1u) { }
+    return cpsr;
+}
+
+static void pl330_unlock(uint32_t cpsr)
+{
+    __asm__ volatile("dmb sy" ::: "memory");
+    SHM_CTRL->pl330_want[DMA_COPY_CORE] = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
+    arm_irq_restore(cpsr);
+}
+
+// ---------------------------
+// Gestione slot
+// ---------------------------
+static dma_slot_t *slot_take(void)
+{
+    dma_slot_t *ret = NULL;
+    uint32_t cpsr = arm_irq_save();
+
+    for (uint32_t i = 0; i < DMA_COPY_CH_PER_CORE; ++i) {
+        if (s_slot[i].alloc && !s_slot[i].busy) {
+            s_slot[i].busy = true;
+            ret = &s_slot[i];
+            break;
+        }
+    }
+
+    arm_irq_restore(cpsr);
+    return ret;
+}
+
+/* Chiusura transfer: chiamare con IRQ mascherati (ISR o sezione critica) */
+static void slot_finish(dma_slot_t *s, ALT_STATUS_CODE st, dma_copy_cb_t *cb, void **ctx)
+{
+    (void)alt_dma_int_clear(s->evt);
+
+    // i dati sono in memoria: butta eventuali linee caricate durante il transfer
+    if (st == ALT_E_SUCCESS) (void)arm_cache_invalidate_range(s->dst, s->len);
+
+    *cb  = s->cb;
+    *ctx = s->ctx;
+    s->cb  = NULL;
+    s->ctx = NULL;
+    __asm__ volatile("dmb sy" ::: "memory");
+    s->busy = false;
+}
+
+static void dma_copy_isr(uint32_t icciar, void *context)
+{
+    (void)icciar;
+    dma_slot_t *s = (dma_slot_t *)context;
+    dma_copy_cb_t cb;
+    void *ctx;
+
+    if (!s->busy) { (void)alt_dma_int_clear(s->evt); return; }
+
+    slot_finish(s, ALT_E_SUCCESS, &cb, &ctx);
+    if (cb) cb(ALT_E_SUCCESS, ctx);
+}
+
+// ---------------------------
+// Init
+// ---------------------------
+ALT_STATUS_CODE dma_copy_init(void)
+{
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+
+#if !defined(CORE1)
+    // Il PL330 è uno solo: lo inizializza Core0 (prima di liberare Core1)
+    ALT_DMA_CFG_t cfg;
+    memset(&cfg, 0, sizeof(cfg));   // tutto DEFAULT: secure, mux di reset
+    if (status == ALT_E_SUCCESS) status = alt_dma_init(&cfg);
+#endif
+
+    for (uint32_t i = 0; (status == ALT_E_SUCCESS) && (i < DMA_COPY_CH_PER_CORE); ++i) {
+        dma_slot_t *s = &s_slot[i];
+        s->ch   = (ALT_DMA_CHANNEL_t)(DMA_COPY_CH_BASE + i);
+        s->evt  = (ALT_DMA_EVENT_t)(DMA_COPY_CH_BASE + i);
+        s->busy = false;
+
+        if (status == ALT_E_SUCCESS) status = alt_dma_channel_alloc(s->ch);
+        if (status == ALT_E_SUCCESS) {
+            uint32_t lk = pl330_lock();
+            status = alt_dma_event_int_select(s->evt, ALT_DMA_EVENT_SELECT_SIG_IRQ);
+            pl330_unlock(lk);
+        }
+        if (status == ALT_E_SUCCESS) status = alt_dma_int_clear(s->evt);
+#if !defined(CORE1)
+        if (status == ALT_E_SUCCESS)
+            status = hps_core0_int_start((ALT_INT_INTERRUPT_t)(ALT_INT_INTERRUPT_DMA_IRQ0 + s->evt),
+                                         dma_copy_isr,
+                                         s,
+                                         ALT_INT_TRIGGER_LEVEL);
+#else
+        if (status == ALT_E_SUCCESS)
+            status = hps_core1_int_start((ALT_INT_INTERRUPT_t)(ALT_INT_INTERRUPT_DMA_IRQ0 + s->evt),
+                                         dma_copy_isr,
+                                         s,
+                                         ALT_INT_TRIGGER_LEVEL);
+#endif
+        if (status == ALT_E_SUCCESS) s->alloc = true;
+    }
+
+    s_ready = (status == ALT_E_SUCCESS);
+    return status;
+}
+
+bool dma_copy_is_ready(void)
+{
+    return s_ready;
+}
+
+// ---------------------------
+// Fallback CPU
+// ---------------------------
+static ALT_STATUS_CODE cpu_op(void *dst, const void *src, size_t len,
+                              dma_copy_cb_t cb, void *ctx)
+{
+    if (src) memmove(dst, src, len);
+    else     memset(dst, 0, len);
+
+    // stessa semantica del DMA: a fine operazione i dati sono in memoria
+    (void)arm_cache_clean_range(dst, len);
+
+    s_stats.cpu_ops++;
+    if (cb) cb(ALT_E_SUCCESS, ctx);
+    return ALT_E_SUCCESS;
+}
+
+// ---------------------------
+// Avvio transfer
+// ---------------------------
+static ALT_STATUS_CODE dma_start(void *dst, const void *src, size_t len,
+                                 dma_copy_cb_t cb, void *ctx)
+{
+    if (!dst || (len && (uintptr_t)dst + len < (uintptr_t)dst)) return ALT_E_BAD_ARG;
+    if (len == 0u) { if (cb) cb(ALT_E_SUCCESS, ctx); return ALT_E_SUCCESS; }
+
+    if (!s_ready || len < DMA_COPY_MIN_BYTES) return cpu_op(dst, src, len, cb, ctx);
+
+    dma_slot_t *s = slot_take();
+    if (!s) {
+        s_stats.no_channel++;
+        return cpu_op(dst, src, len, cb, ctx);
+    }
+
+    if (src) (void)arm_cache_clean_range(src, len);
+    (void)arm_cache_invalidate_range(dst, len);
+
+    s->cb  = cb;
+    s->ctx = ctx;
+    s->dst = dst;
+    s->len = len;
+
+    ALT_STATUS_CODE status;
+    uint32_t lk = pl330_lock();
+    if (src) status = alt_dma_memory_to_memory(s->ch, &s->pgm, dst, src, len, true, s->evt);
+    else     status = alt_dma_zero_to_memory(s->ch, &s->pgm, dst, len, true, s->evt);
+    pl330_unlock(lk);
+
+    if (status != ALT_E_SUCCESS) {
+        // programma non generabile (es. sovrapposizione): lo fa la CPU
+        s->cb   = NULL;
+        s->ctx  = NULL;
+        s->busy = false;
+        return cpu_op(dst, src, len, cb, ctx);
+    }
+
+    s_stats.dma_ops++;
+    s_stats.dma_bytes += (uint32_t)len;
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE dma_copy_memcpy_async(void *dst, const void *src, size_t len,
+                                      dma_copy_cb_t cb, void *ctx)
+{
+    if (!src) return ALT_E_BAD_ARG;
+    return dma_start(dst, src, len, cb, ctx);
+}
+
+ALT_STATUS_CODE dma_copy_zero_async(void *dst, size_t len,
+                                    dma_copy_cb_t cb, void *ctx)
+{
+    return dma_start(dst, NULL, len, cb, ctx);
+}
+
+// ---------------------------
+// Polling / attesa
+// ---------------------------
+uint32_t dma_copy_poll(void)
+{
+    uint32_t done = 0;
+
+    for (uint32_t i = 0; i < DMA_COPY_CH_PER_CORE; ++i) {
+        dma_slot_t *s = &s_slot[i];
+        dma_copy_cb_t cb = NULL;
+        void *ctx = NULL;
+        ALT_STATUS_CODE st = ALT_E_SUCCESS;
+        bool fin = false;
+
+        uint32_t cpsr = arm_irq_save();
+        if (s->busy) {
+            ALT_DMA_CHANNEL_STATE_t state;
+            if (alt_dma_int_status_get(s->evt) == ALT_E_TRUE) {
+                fin = true;
+            } else if ((alt_dma_channel_state_get(s->ch, &state) == ALT_E_SUCCESS) &&
+                       (state == ALT_DMA_CHANNEL_STATE_FAULTING)) {
+                uint32_t lk = pl330_lock();
+                (void)alt_dma_channel_kill(s->ch);
+                pl330_unlock(lk);
+                s_stats.faults++;
+                trace_log(TRACE_DMA_FAULT, (uint32_t)s->ch);
+                st  = ALT_E_ERROR;
+                fin = true;
+            }
+            if (fin) slot_finish(s, st, &cb, &ctx);
+        }
+        arm_irq_restore(cpsr);
+
+        if (fin) {
+            done++;
+            if (cb) cb(st, ctx);
+        }
+    }
+    return done;
+}
+
+static bool any_busy(void)
+{
+    for (uint32_t i = 0; i < DMA_COPY_CH_PER_CORE; ++i)
+        if (s_slot[i].busy) return true;
+    return false;
+}
+
+ALT_STATUS_CODE dma_copy_wait_all(void)
+{
+    for (uint32_t spin = 0; spin < DMA_COPY_WAIT_SPINS; ++spin) {
+        (void)dma_copy_poll();
+        if (!any_busy()) return ALT_E_SUCCESS;
+    }
+    return ALT_E_TMO;
+}
+
+// ---------------------------
+// Versioni sincrone
+// ---------------------------
+typedef struct {
+    volatile bool            done;
+    volatile ALT_STATUS_CODE status;
+} dma_sync_t;
+
+static void sync_done(ALT_STATUS_CODE status, void *ctx)
+{
+    dma_sync_t *w = (dma_sync_t *)ctx;
+    w->status = status;
+    w->done   = true;
+}
+
+static ALT_STATUS_CODE sync_wait(dma_sync_t *w)
+{
+    for (uint32_t spin = 0; spin < DMA_COPY_WAIT_SPINS; ++spin) {
+        if (w->done) return w->status;
+        (void)dma_copy_poll();
+    }
+
+    // timeout: ferma il canale prima che la callback punti a uno stack non più valido
+    uint32_t cpsr = arm_irq_save();
+    for (uint32_t i = 0; i < DMA_COPY_CH_PER_CORE; ++i) {
+        dma_slot_t *s = &s_slot[i];
+        if (s->busy && s->ctx == w) {
+            uint32_t lk = pl330_lock();
+            (void)alt_dma_channel_kill(s->ch);
+            pl330_unlock(lk);
+            (void)alt_dma_int_clear(s->evt);
+            s->cb   = NULL;
+            s->ctx  = NULL;
+            s->busy = false;
+        }
+    }
+    arm_irq_restore(cpsr);
+
+    return w->done ? w->status : ALT_E_TMO;
+}
+
+ALT_STATUS_CODE dma_copy_memcpy(void *dst, const void *src, size_t len)
+{
+    dma_sync_t w = { .done = false, .status = ALT_E_ERROR };
+    ALT_STATUS_CODE status = dma_copy_memcpy_async(dst, src, len, sync_done, &w);
+    if (status == ALT_E_SUCCESS) status = sync_wait(&w);
+    return status;
+}
+
+ALT_STATUS_CODE dma_copy_zero(void *dst, size_t len)
+{
+    dma_sync_t w = { .done = false, .status = ALT_E_ERROR };
+    ALT_STATUS_CODE status = dma_copy_zero_async(dst, len, sync_done, &w);
+    if (status == ALT_E_SUCCESS) status = sync_wait(&w);
+    return status;
+}
+
+const dma_copy_stats_t *dma_copy_stats(void)
+{
+    return &s_stats;
+}
+
+#if !defined(CORE1)
+void dma_copy_stop_peer(void)
+{
+    // Core1 in reset: se teneva il lock del PL330 non lo rilascerà più
+    SHM_CTRL->pl330_want[1] = 0u;
+
+    // alt_dma di Core0 non conosce i canali di Core1: li prende il tempo del DMAKILL
+    for (uint32_t i = 0; i < DMA_COPY_CH_PER_CORE; ++i) {
+        ALT_DMA_CHANNEL_t ch = (ALT_DMA_CHANNEL_t)(4u + i);
+        if (alt_dma_channel_alloc(ch) == ALT_E_SUCCESS) {
+            uint32_t lk = pl330_lock();
+            (void)alt_dma_channel_kill(ch);
+            pl330_unlock(lk);
+            (void)alt_dma_channel_free(ch);
+        }
+        (void)alt_dma_int_clear((ALT_DMA_EVENT_t)(4u + i));
+    }
+}
+#endif
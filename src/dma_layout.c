@@ -4,6 +4,9 @@
 #include "arm_pio.h"
 #include "schedule.h"
 #include "f2h_interrupts.h"
+#include "msgdma.h"
+#include "mem_pool.h"
+#include "fmt_min.h"
 
 extern volatile uint32_t *g_bank_coef_sel;
 extern volatile uint32_t *g_bank_pulse_sel;
@@ -13,63 +16,514 @@ volatile uint32_t g_channel   = 0;
 volatile uint32_t g_coef_count = 1024;  // default: usa tutte
 volatile uint32_t g_pulse_count = 1024;
 
+// Doppio buffer: s_cfg[s_cfg_active] è letta dalla ISR, l'altra è lo shadow.
+// Publisher (scheduler) e ISR girano entrambi su Core0: la ISR interrompe il
+// publisher e non viceversa, quindi basta il flag s_cfg_pending come "commit".
+static seq_config_t s_cfg[2] = {
+    { .channel = 0u, .coef_count = 1024u, .pulse_count = 1024u, .prf = 4000u },
+    { .channel = 0u, .coef_count = 1024u, .pulse_count = 1024u, .prf = 4000u },
+};
+// Ogni slot ha la sua tabella compilata, letta dalla ISR. 2 x 16 KiB: stanno
+// nell'arena DDR (seq_config_init), non nel .bss dell'immagine in OCRAM.
+static seq_step_t *s_steps[2];
+// Cursore della sequenza attiva: lo tocca solo la ISR del trigger
+static uint32_t s_seq_pos = 0;
+static uint32_t s_seq_rep = 0;
+static volatile uint32_t s_cfg_active  = 0;
+static volatile uint32_t s_cfg_pending = 0;
+static volatile uint32_t s_cfg_live_gen = 0;
+static volatile uint32_t s_trig_count = 0;
+static volatile uint32_t s_cfg_live_trig = 0;
+static uint32_t s_cfg_gen = 0;
+static uint32_t s_prf_pending = 0;      // PRF della config appena attivata, va col primo passo
+static volatile seq_config_notify_t s_cfg_notify = NULL;
 
-static inline uint32_t mask_pow2(uint32_t n)
+// Ridirezioni attive (hot-update): poche entry, ricerca lineare solo in compilazione
+typedef struct {
+    uint16_t type;
+    uint16_t index;
+    uint32_t addr;
+} seq_redirect_t;
+
+static seq_redirect_t s_redir[SEQ_REDIRECT_MAX];
+static uint32_t s_redir_n = 0;
+static uint32_t s_redir_lay[3] = { 0xFFFFFFFFu, 0u, 0u };   // channel, coef_count, pulse_count
+
+
+// Indice fuori range -> riportato nel ciclo. Mai usata nel percorso del trigger:
+// lì l'avanzamento è a confronto e reset sulla tabella compilata.
+static inline uint32_t seq_wrap(uint32_t idx, uint32_t n)
+{
+    return (idx < n) ? idx : (idx % n);
+}
+
+static uint32_t seq_gcd(uint32_t a, uint32_t b)
+{
+    while (b) { uint32_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+static ALT_STATUS_CODE seq_validate(const seq_config_t *c, const seq_program_t *prog)
+{
+    // numero opzioni qualsiasi 1..1024: niente più arrotondamento silenzioso a 1024
+    if (c->channel > 3u) return ALT_E_ARG_RANGE;
+    if (c->coef_count  == 0u || c->coef_count  > COEF_NUM_PAIRS)  return ALT_E_ARG_RANGE;
+    if (c->pulse_count == 0u || c->pulse_count > PULSE_NUM_PAIRS) return ALT_E_ARG_RANGE;
+
+    // il layout pianificato deve stare nella finestra DDR letta dall'FPGA
+    dma_plan_t plan;
+    if (dma_layout_plan(c->channel, c->coef_count, c->pulse_count, &plan) != ALT_E_SUCCESS) return ALT_E_ARG_RANGE;
+
+    if (!prog) return ALT_E_SUCCESS;
+    if (!prog->entries || prog->count == 0u || prog->count > SEQ_MAX_STEPS) return ALT_E_BAD_ARG;
+    if (prog->loop_start >= prog->count) return ALT_E_BAD_ARG;
+
+    for (uint32_t i = 0; i < prog->count; ++i) {
+        if (prog->entries[i].coef_idx  >= c->coef_count)  return ALT_E_ARG_RANGE;
+        if (prog->entries[i].pulse_idx >= c->pulse_count) return ALT_E_ARG_RANGE;
+    }
+    return ALT_E_SUCCESS;
+}
+
+/* Descrittori per banco: tutto quello che in ISR dipendeva da switch/tabelle per canale */
+static void seq_build_desc(seq_config_t *sh)
+{
+    // split calcolato una volta per config: la ISR scorre solo le parti
+    uint32_t plen[SEQ_COEF_PARTS];
+    sh->coef_parts = msgdma_coef_split(coef_len_for_channel(sh->channel), plen, sh->coef_eng, SEQ_COEF_PARTS);
+    sh->coef_eng_mask = 0u;
+    for (uint32_t k = 0; k < sh->coef_parts; ++k) sh->coef_eng_mask |= (1u << sh->coef_eng[k]);
+
+    sh->ring_depth = seq_ring_depth(sh->channel);
+    for (uint32_t bank = 0; bank < sh->ring_depth; ++bank) {
+        uint32_t ofs = 0u;
+        for (uint32_t k = 0; k < sh->coef_parts; ++k) {
+            sh->coef_desc[bank][k].src  = ofs;
+            sh->coef_desc[bank][k].dst  = COEF_DEST_BASE + coef_slot_dst_off(bank, sh->channel) + ofs;
+            sh->coef_desc[bank][k].len  = plen[k];
+            sh->coef_desc[bank][k].ctrl = START_MSGDMA_MASK;
+            ofs += plen[k];
+        }
+
+        sh->pulse_desc[bank].src  = 0u;
+        sh->pulse_desc[bank].dst  = PULSE_DEST_BASE + pulse_slot_dst_off(bank, sh->channel);
+        sh->pulse_desc[bank].len  = pulse_len_for_channel(sh->channel);
+        sh->pulse_desc[bank].ctrl = START_MSGDMA_MASK;
+    }
+}
+
+static uint32_t seq_src(const seq_config_t *c, uint32_t type, uint32_t idx)
+{
+    if (s_redir_n && c->channel == s_redir_lay[0] &&
+        c->coef_count == s_redir_lay[1] && c->pulse_count == s_redir_lay[2]) {
+        for (uint32_t i = 0; i < s_redir_n; ++i)
+            if (s_redir[i].type == type && s_redir[i].index == idx) return s_redir[i].addr;
+    }
+    return (type == 0u) ? pair_coef_source_addr_cfg(c, idx) : pair_pulse_source_addr_cfg(c, idx);
+}
+
+/* Compila config + playlist nella tabella dello slot sh (già non visibile alla ISR) */
+static void seq_compile(seq_config_t *sh, seq_step_t *out, const seq_program_t *prog)
+{
+    (void)seq_config_plan(sh);      // una volta per config: seq_src non ripianifica a ogni passo
+    seq_build_desc(sh);
+
+    if (!prog) {
+        // sweep: COEF e PULSE ciclano ognuno sul proprio numero di opzioni.
+        // Il ciclo completo è mcm(coef,pulse); se non sta in tabella si usa
+        // max(coef,pulse) e il più corto riparte insieme all'altro.
+        const uint32_t cc = sh->coef_count, pc = sh->pulse_count;
+        const uint32_t lcm = (cc / seq_gcd(cc, pc)) * pc;
+        const uint32_t n = (lcm <= SEQ_MAX_STEPS) ? lcm : ((cc > pc) ? cc : pc);
+        uint32_t ci = 0u, pi = 0u;
+        for (uint32_t i = 0; i < n; ++i) {
+            out[i].coef_src  = seq_src(sh, 0u, ci);
+            out[i].pulse_src = seq_src(sh, 1u, pi);
+            out[i].prf       = 0u;
+            out[i].repeat    = 1u;
+            if (++ci == cc) ci = 0u;
+            if (++pi == pc) pi = 0u;
+        }
+        sh->n_steps    = n;
+        sh->loop_start = 0u;
+    } else {
+        const uint32_t n = prog->count;
+        uint32_t p = prog->stagger % n;   // solo qui, fuori dalla ISR
+        for (uint32_t i = 0; i < n; ++i) {
+            const seq_entry_t *e = &prog->entries[i];
+            out[i].coef_src  = seq_src(sh, 0u, e->coef_idx);
+            out[i].pulse_src = seq_src(sh, 1u, prog->entries[p].pulse_idx);
+            out[i].prf       = e->prf;
+            out[i].repeat    = (e->repeat == 0u) ? 1u : e->repeat;
+            if (++p == n) p = 0u;
+        }
+        sh->n_steps    = n;
+        sh->loop_start = prog->loop_start;
+    }
+    sh->steps = out;
+}
+
+ALT_STATUS_CODE seq_config_publish(const seq_config_t *cfg, const seq_program_t *prog, uint32_t *gen)
+{
+    if (!cfg) return ALT_E_BAD_ARG;
+
+    seq_config_t c = {
+        .channel     = cfg->channel,
+        .coef_count  = cfg->coef_count,
+        .pulse_count = cfg->pulse_count,
+        .prf         = cfg->prf,
+    };
+    ALT_STATUS_CODE status = seq_validate(&c, prog);
+    if (status != ALT_E_SUCCESS) return status;   // lo shadow pubblicato (se c'è) resta valido
+    if (!s_steps[0]) return ALT_E_BAD_OPERATION;  // prima di seq_config_init
+
+    // 1) ritira un eventuale shadow non ancora latchato: da qui la ISR non scambia
+    s_cfg_pending = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    // 2) scrivi e compila lo shadow
+    const uint32_t slot = s_cfg_active ^ 1u;
+    seq_config_t *sh = &s_cfg[slot];
+    *sh = c;
+    seq_compile(sh, s_steps[slot], prog);
+    sh->gen = ++s_cfg_gen;
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    // 3) commit
+    s_cfg_pending = 1u;
+    if (gen) *gen = sh->gen;
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE seq_config_init(void)
+{
+    // trigger ancora spento: si compila direttamente lo slot attivo
+    const uint32_t slot = s_cfg_active;
+    seq_config_t *c = &s_cfg[slot];
+
+    // dopo mem_pool_sys_init
+    mem_arena_t *a = mem_arena_get(MEM_REGION_DDR);
+    for (uint32_t k = 0; k < 2u; ++k) {
+        if (!s_steps[k]) s_steps[k] = (seq_step_t *)mem_arena_alloc(a, SEQ_MAX_STEPS * sizeof(seq_step_t), MEM_POOL_ALIGN);
+        if (!s_steps[k]) return ALT_E_ERROR;
+    }
+
+    c->prf = prf_setting(c->channel);
+    seq_compile(c, s_steps[slot], NULL);
+    arm_pio_write(g_arm_prf_counter, c->prf);
+    s_seq_pos = 0u;
+    s_seq_rep = 0u;
+    return ALT_E_SUCCESS;
+}
+
+const seq_config_t *seq_config_latch(void)
+{
+    if (s_cfg_pending) {
+        s_cfg_pending = 0u;
+        s_cfg_active ^= 1u;
+
+        const seq_config_t *c = &s_cfg[s_cfg_active];
+        g_channel     = c->channel;
+        g_coef_count  = c->coef_count;
+        g_pulse_count = c->pulse_count;
+        s_prf_pending = c->prf;     // la PRF cambia quando il primo slot della nuova config va in lettura
+
+        if (!c->keep_cursor || s_seq_pos >= c->n_steps) {
+            s_seq_pos = 0u;                          // la nuova sequenza parte dal primo passo
+            s_seq_rep = 0u;
+        }
+
+        // "live" solo quando il primo slot riempito con c va in lettura: seq_config_shown
+    }
+    return &s_cfg[s_cfg_active];
+}
+
+void seq_config_shown(uint32_t gen)
+{
+    if ((int32_t)(gen - s_cfg_live_gen) <= 0) return;     // slot di una config già annunciata
+
+    s_cfg_live_gen  = gen;
+    s_cfg_live_trig = s_trig_count;
+    seq_config_notify_t cb = s_cfg_notify;
+    if (cb) cb(gen);
+}
+
+const seq_config_t *seq_config_active(void)
+{
+    return &s_cfg[s_cfg_active];
+}
+
+bool seq_config_uses_src(uint32_t type, uint32_t addr)
+{
+    // attiva, shadow pubblicato e (dopo il latch) quella precedente, che può avere ancora slot nel ring
+    for (uint32_t k = 0; k < 2u; ++k) {
+        const seq_config_t *c = &s_cfg[k];
+        for (uint32_t i = 0; i < c->n_steps; ++i) {
+            uint32_t src = (type == 0u) ? c->steps[i].coef_src : c->steps[i].pulse_src;
+            if (src == addr) return true;
+        }
+    }
+    return false;
+}
+
+const seq_step_t *seq_config_step(const seq_config_t *cfg, uint32_t *prf)
+{
+    if (cfg->n_steps == 0u) return NULL;
+
+    const seq_step_t *st = &cfg->steps[s_seq_pos];
+    s_trig_count++;
+
+    // il passo viene mostrato qualche trigger dopo (ring): la PRF la scrive chi lo mostra
+    *prf = (s_seq_rep == 0u && st->prf) ? st->prf : s_prf_pending;
+    s_prf_pending = 0u;
+
+    // avanzamento a confronto e reset (nessuna divisione)
+    if (++s_seq_rep >= st->repeat) {
+        s_seq_rep = 0u;
+        if (++s_seq_pos >= cfg->n_steps) s_seq_pos = cfg->loop_start;
+    }
+    return st;
+}
+
+uint32_t seq_config_live_gen(void)
+{
+    return s_cfg_live_gen;
+}
+
+void seq_config_set_notify(seq_config_notify_t cb)
+{
+    s_cfg_notify = cb;
+}
+
+uint32_t seq_trigger_count(void)
+{
+    return s_trig_count;
+}
+
+uint32_t seq_config_live_trigger(void)
+{
+    return s_cfg_live_trig;
+}
+
+void seq_redirect_reset(uint32_t channel, uint32_t coef_count, uint32_t pulse_count)
+{
+    s_redir_n = 0u;
+    s_redir_lay[0] = channel;
+    s_redir_lay[1] = coef_count;
+    s_redir_lay[2] = pulse_count;
+}
+
+ALT_STATUS_CODE seq_redirect_set(uint32_t type, uint32_t index, uint32_t addr)
 {
-    // n ∈ {1,2,4,...,1024} -> restituisce n-1; se fuori, fallback 1024-1
-    switch (n) {
-    case 1u: case 2u: case 4u: case 8u: case 16u: case 32u: case 64u:
-    case 128u: case 256u: case 512u: case 1024u: return n - 1u;
-    default: return 1024u - 1u;
+    if (type > 1u || index >= 1024u) return ALT_E_BAD_ARG;
+
+    for (uint32_t i = 0; i < s_redir_n; ++i) {
+        if (s_redir[i].type != type || s_redir[i].index != index) continue;
+        if (addr) s_redir[i].addr = addr;
+        else      s_redir[i] = s_redir[--s_redir_n];   // di nuovo lo slot di casa
+        return ALT_E_SUCCESS;
     }
+    if (!addr) return ALT_E_SUCCESS;
+    if (s_redir_n >= SEQ_REDIRECT_MAX) return ALT_E_BUF_OVF;
+
+    s_redir[s_redir_n++] = (seq_redirect_t){ (uint16_t)type, (uint16_t)index, addr };
+    return ALT_E_SUCCESS;
 }
 
-void seq_config_set_channel(uint32_t channel, uint32_t coef_count_pow2, uint32_t pulse_count_pow2)
+ALT_STATUS_CODE seq_config_redirect(uint32_t type, uint32_t old_src, uint32_t new_src, uint32_t *gen)
 {
-    if (channel > 4u) channel = 4u;
+    if (type > 1u) return ALT_E_BAD_ARG;
+    if (!s_steps[0]) return ALT_E_BAD_OPERATION;
 
-    g_channel = channel;
+    // stessa logica di publish: dopo aver ritirato il pending la ISR non scambia
+    const uint32_t was_pending = s_cfg_pending;
+    s_cfg_pending = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
 
-    g_coef_count   = (coef_count_pow2   == 0u) ? 1024u : coef_count_pow2;
-    g_pulse_count = (pulse_count_pow2 == 0u) ? 1024u : pulse_count_pow2;
+    const uint32_t slot = s_cfg_active ^ 1u;
+    seq_config_t *sh = &s_cfg[slot];
+    seq_step_t  *out = s_steps[slot];
 
-    arm_pio_write(g_arm_prf_counter,prf_setting(channel));
+    if (!was_pending) {
+        // base = config attiva: copia config e tabella nello shadow
+        const seq_config_t *a = &s_cfg[s_cfg_active];
+        *sh = *a;
+        for (uint32_t i = 0; i < a->n_steps; ++i) out[i] = a->steps[i];
+        sh->steps = out;
+        sh->keep_cursor = 1u;
+    }
+    // (se c'era un pending lo si ritocca: resta la sua politica di cursore)
+
+    for (uint32_t i = 0; i < sh->n_steps; ++i) {
+        if (type == 0u) { if (out[i].coef_src  == old_src) out[i].coef_src  = new_src; }
+        else            { if (out[i].pulse_src == old_src) out[i].pulse_src = new_src; }
+    }
+    sh->gen = ++s_cfg_gen;
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    s_cfg_pending = 1u;
+    if (gen) *gen = sh->gen;
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE seq_config_set_channel(uint32_t channel, uint32_t coef_count, uint32_t pulse_count)
+{
+    if (channel > 3u) return ALT_E_ARG_RANGE;
 
-    // opzionale: potresti assertare che le size non superino la metà OCRAM
     // COEF OCRAM half = 512 KiB; PULSE OCRAM half = 64 KiB
     // (g_coef_pair_bytes[channel] <= 512KiB, g_pulse_pair_bytes[channel] <= 64KiB) -> già vero con le tabelle scelte
+    seq_config_t cfg = {
+        .channel     = channel,
+        .coef_count  = coef_count,
+        .pulse_count = pulse_count,
+        .prf         = prf_setting(channel),
+    };
+    return seq_config_publish(&cfg, NULL, NULL);
 }
 
-uint32_t pair_coef_source_addr(uint32_t idx)
+// ---------------------------
+// Planner layout DDR
+// ---------------------------
+static inline uint32_t plan_align(uint32_t v, uint32_t a)
 {
-    // cicla su g_coef_count (power of 2 → usa mask)
-    uint32_t i = idx & mask_pow2(g_coef_count);
-    uint32_t stride = g_coef_stride_bytes[g_channel];
+    return ((v + a - 1u) / a) * a;
+}
 
-    // Allineato per evitare crossing 4KiB e favorire burst lunghi
-    return COEF_AREA_BASE + i * stride;
+static inline uint32_t plan_bank(uint32_t addr)
+{
+    return (addr / DDR_PAGE_BYTES) % DDR_NUM_BANKS;
+}
+
+ALT_STATUS_CODE dma_layout_plan(uint32_t channel, uint32_t coef_count, uint32_t pulse_count, dma_plan_t *p)
+{
+    if (!p) return ALT_E_BAD_ARG;
+    ALT_STATUS_CODE s = ALT_E_SUCCESS;
+    if (channel > 3u) { s = ALT_E_ARG_RANGE; channel = 0u; }
+    if (coef_count  == 0u || coef_count  > COEF_NUM_PAIRS)  { s = ALT_E_ARG_RANGE; coef_count  = 1u; }
+    if (pulse_count == 0u || pulse_count > PULSE_NUM_PAIRS) { s = ALT_E_ARG_RANGE; pulse_count = 1u; }
+
+    const uint32_t csz = g_coef_pair_bytes[channel];
+    const uint32_t psz = g_pulse_pair_bytes[channel];
+    const uint32_t pp  = plan_align(psz, DDR_PAGE_BYTES) / DDR_PAGE_BYTES;   // pagine per PULSE
+
+    // COEF: tutte partono dal banco 0 (size già multiple di DDR_BANK_SPAN: niente spreco)
+    p->coef_base   = COEF_AREA_BASE;
+    p->coef_stride = plan_align(csz, DDR_BANK_SPAN);
+
+    uint32_t area = plan_align(p->coef_base + coef_count * p->coef_stride, DDR_BANK_SPAN);
+    p->pulse_pages = pp;
+
+#if DDR_PLAN_STAGGER
+    const uint32_t half = DDR_NUM_BANKS / 2u;
+    p->pulse_base = area + half * DDR_PAGE_BYTES;
+    if (pp <= half) {
+        // PULSE piccole: impaccate nella metà alta dei banchi di ogni gruppo
+        p->pulse_stride       = pp * DDR_PAGE_BYTES;
+        p->pulse_per_group    = half / pp;
+        p->pulse_group_stride = DDR_BANK_SPAN;
+    } else {
+        // PULSE grandi: una per gruppo, sempre con partenza a metà dei banchi
+        p->pulse_stride       = plan_align(psz, DDR_BANK_SPAN);
+        p->pulse_per_group    = 1u;
+        p->pulse_group_stride = p->pulse_stride;
+    }
+#else
+    p->pulse_base         = area;
+    p->pulse_stride       = pp * DDR_PAGE_BYTES;
+    p->pulse_per_group    = 1u;
+    p->pulse_group_stride = p->pulse_stride;
+#endif
+
+    uint64_t end = (uint64_t)dma_plan_pulse_addr(p, pulse_count - 1u) + psz;
+    if (end > (uint64_t)DDR3_PLAN_END) { s = ALT_E_ARG_RANGE; end = (uint64_t)DDR3_PLAN_END; }   // sopra: calibrazione mSGDMA
+
+    p->end          = (uint32_t)end;
+    p->payload      = coef_count * csz + pulse_count * psz;
+    p->footprint    = p->end - p->coef_base;
+    p->eff_permille = (uint32_t)(((uint64_t)p->payload * 1000u) / p->footprint);
+
+    // conflitti: letture partite insieme allo stesso ritmo, COEF dal banco 0
+    p->conflict_pages = 0u;
+    for (uint32_t j = 0; j < p->pulse_per_group; ++j) {
+        uint32_t n = 0u, pa = dma_plan_pulse_addr(p, j);
+        for (uint32_t k = 0; k < pp; ++k)
+            if (plan_bank(pa + k * DDR_PAGE_BYTES) == plan_bank(p->coef_base + k * DDR_PAGE_BYTES)) n++;
+        if (n > p->conflict_pages) p->conflict_pages = n;
+    }
+    return s;
+}
+
+uint32_t dma_plan_coef_addr(const dma_plan_t *p, uint32_t idx)
+{
+    return p->coef_base + idx * p->coef_stride;
+}
+
+uint32_t dma_plan_pulse_addr(const dma_plan_t *p, uint32_t idx)
+{
+    return p->pulse_base + (idx / p->pulse_per_group) * p->pulse_group_stride
+                         + (idx % p->pulse_per_group) * p->pulse_stride;
+}
+
+void dma_layout_plan_dump(uint32_t channel, uint32_t coef_count, uint32_t pulse_count)
+{
+    dma_plan_t p;
+    ALT_STATUS_CODE s = dma_layout_plan(channel, coef_count, pulse_count, &p);
+
+    fmt_printf("\r\nDDR plan ch %u: %u COEF x %u KiB @0x%08X stride %u KiB, %u PULSE x %u KiB @0x%08X (%u/gruppo, %u KiB)",
+               channel, coef_count, g_coef_pair_bytes[channel & 3u] / 1024u, p.coef_base, p.coef_stride / 1024u,
+               pulse_count, g_pulse_pair_bytes[channel & 3u] / 1024u, p.pulse_base,
+               p.pulse_per_group, p.pulse_group_stride / 1024u);
+    fmt_printf("\r\nDDR plan: footprint %u KiB, utili %u KiB, efficienza %.1q%%, conflitti banco %u/%u pagine%s",
+               p.footprint / 1024u, p.payload / 1024u, p.eff_permille, p.conflict_pages, p.pulse_pages,
+               (s == ALT_E_SUCCESS) ? "" : " [NON ENTRA IN DDR]");
+}
+
+ALT_STATUS_CODE seq_config_plan(seq_config_t *cfg)
+{
+    return dma_layout_plan(cfg->channel, cfg->coef_count, cfg->pulse_count, &cfg->plan);
+}
+
+uint32_t pair_coef_source_addr_cfg(const seq_config_t *cfg, uint32_t idx)
+{
+    // cicla su coef_count (qualsiasi valore 1..1024)
+    return dma_plan_coef_addr(&cfg->plan, seq_wrap(idx, cfg->coef_count));
+}
+
+uint32_t pair_pulse_source_addr_cfg(const seq_config_t *cfg, uint32_t idx)
+{
+    return dma_plan_pulse_addr(&cfg->plan, seq_wrap(idx, cfg->pulse_count));
+}
+
+uint32_t pair_coef_source_addr(uint32_t idx)
+{
+    return pair_coef_source_addr_cfg(seq_config_active(), idx);
 }
 
 uint32_t pair_pulse_source_addr(uint32_t idx)
 {
-    uint32_t i = idx & mask_pow2(g_pulse_count);
-    uint32_t stride = g_pulse_stride_bytes[g_channel];
+    return pair_pulse_source_addr_cfg(seq_config_active(), idx);
+}
 
-    // PULSE parte dopo l’area COEF completamente allocata (in base al canale e a quante COEF opzioni usi)
-    uint32_t coef_stride = g_coef_stride_bytes[g_channel];
-    uint32_t base_pulse = PULSE_AREA_BASE(g_coef_count, coef_stride);
+uint32_t seq_ring_depth(uint32_t channel)
+{
+    uint32_t d = 1u << BANK_SEL_BITS;
+    uint32_t c = COEF_DEST_SIZE  / g_coef_pair_bytes[channel & 3u];
+    uint32_t p = PULSE_DEST_SIZE / g_pulse_pair_bytes[channel & 3u];
 
-    return base_pulse + i * stride;
+    if (d > SEQ_RING_MAX) d = SEQ_RING_MAX;
+    if (d > c) d = c;
+    if (d > p) d = p;
+    return (d < 2u) ? 2u : d;
 }
 
 void coef_bank_sel(uint32_t bank)
-{ // 0=A, 1=B
-    arm_pio_write(g_bank_coef_sel, (bank & 0x1u));
+{ // slot del ring (0=A, 1=B con BANK_SEL a 1 bit)
+    arm_pio_write(g_bank_coef_sel, (bank & ((1u << BANK_SEL_BITS) - 1u)));
 }
 
 void pulse_bank_sel(uint32_t bank)
-{ // 0=A, 1=B
-    arm_pio_write(g_bank_pulse_sel, (bank & 0x1u));
+{
+    arm_pio_write(g_bank_pulse_sel, (bank & ((1u << BANK_SEL_BITS) - 1u)));
 }
 
 /*uint32_t coef_len_for_channel(uint32_t ch)
@@ -125,13 +579,14 @@ void change_pulse(void)
 	static uint32_t channel = 0;
 	// Esempi:
 	 // channel = 0..3
-	 // coef_count_pow2  = 1,2,4,...,1024
-	 // pulse_count_pow2 = 1,2,4,...,1024
+	 // coef_count  = 1..1024 (qualsiasi)
+	 // pulse_count = 1..1024 (qualsiasi)
 
 	if (channel > 3) channel = 0;
-	seq_config_set_channel(channel, /*coef_count*/ 1024, /*pulse_count*/ 1024);
-	// oppure: channel 1, solo 8 COEF e 16 PULSE
-	// seq_config_set_channel(1, 8, 16);
+	ALT_STATUS_CODE s = seq_config_set_channel(channel, /*coef_count*/ 1024, /*pulse_count*/ 1024);
+	// oppure: channel 1, solo 10 COEF e 12 PULSE
+	// seq_config_set_channel(1, 10, 12);
+	if (s != ALT_E_SUCCESS) fmt_printf("\r\nseq_config_set_channel(%u) fail: %d", channel, (int)s);
 	channel += 1;
 	g_edges=0;
 	sched_insert(CORE0,SCHED_ONETIME,stampa_f2h,500);
@@ -0,0 +1,192 @@
+// doorbell.c
+// Doorbell fra Core0 e Core1: contatori per canale in SHM + un SGI accorpato.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "alt_interrupt.h"
+#include "socal/socal.h"
+#include "doorbell.h"
+#include "interrupts.h"
+#include "fmt_min.h"
+
+#if defined(CORE1)
+#define DB_SELF   1u
+#else
+#define DB_SELF   0u
+#endif
+
+#define GICD_SGIR   (GIC_DIST_IF_BASE + 0xF00u)
+
+typedef struct {
+    const char *name;
+    uint8_t     dest;       // core destinatario
+} doorbell_def_t;
+
+static const doorbell_def_t s_def[DB_QTY] = {
+    [DB_CORE0_READY]  = { "core0_ready", 1u },
+    [DB_CORE1_READY]  = { "core1_ready", 0u },
+    [DB_CMD_TO_CORE1] = { "cmd",         1u },
+    [DB_RSP_TO_CORE0] = { "rsp",         0u },
+};
+
+typedef struct {
+    doorbell_cb_t    cb;
+    void            *ctx;
+    doorbell_mode_t  mode;
+    uint32_t         seen;      // ultimo db_ring consegnato
+    volatile uint32_t deferred; // suonate in attesa di doorbell_poll
+    uint32_t         calls;
+} doorbell_slot_t;
+
+static doorbell_slot_t s_db[DB_QTY];
+static uint32_t        s_irqs;      // SGI ricevuti
+static uint32_t        s_sent;      // SGI mandati (le altre suonate accorpate)
+
+void doorbell_reset(void)
+{
+    for (uint32_t i = 0; i < SHM_DB_CHAN_MAX; ++i) SHM_CTRL->db_ring[i] = 0u;
+    SHM_CTRL->db_pend[0] = 0u;
+    SHM_CTRL->db_pend[1] = 0u;
+    for (uint32_t i = 0; i < DB_QTY; ++i) s_db[i].seen = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
+}
+
+/* Consegna: con IRQ mascherati (ISR o sezione critica) */
+static void doorbell_scan(void)
+{
+    SHM_CTRL->db_pend[DB_SELF] = 0u;               // da qui un nuovo ring rimanda l'SGI
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    for (uint32_t i = 0; i < DB_QTY; ++i) {
+        doorbell_slot_t *d = &s_db[i];
+        if (s_def[i].dest != DB_SELF || !d->cb) continue;
+
+        uint32_t r = SHM_CTRL->db_ring[i];
+        uint32_t n = r - d->seen;
+        if (n == 0u) continue;
+        d->seen = r;
+
+        if (d->mode == DOORBELL_ISR) {
+            d->calls++;
+            d->cb((doorbell_ch_t)i, n, d->ctx);
+        } else {
+            d->deferred += n;
+        }
+    }
+}
+
+static void doorbell_isr(uint32_t icciar, void *context)
+{
+    (void)icciar; (void)context;
+    s_irqs++;
+    doorbell_scan();
+}
+
+ALT_STATUS_CODE doorbell_init(void)
+{
+    ALT_STATUS_CODE status;
+
+#if defined(CORE1)
+    status = hps_core1_int_start(DOORBELL_SGI, doorbell_isr, NULL, ALT_INT_TRIGGER_SOFTWARE);
+#else
+    status = hps_core0_int_start(DOORBELL_SGI, doorbell_isr, NULL, ALT_INT_TRIGGER_SOFTWARE);
+#endif
+
+    if (status == ALT_E_SUCCESS) {
+        uint32_t cpsr = arm_irq_save();
+        doorbell_scan();                           // suonate arrivate prima dell'init
+        arm_irq_restore(cpsr);
+    }
+    return status;
+}
+
+ALT_STATUS_CODE doorbell_register(doorbell_ch_t ch, doorbell_cb_t cb, void *ctx, doorbell_mode_t mode)
+{
+    if (ch >= DB_QTY || !cb) return ALT_E_BAD_ARG;
+    if (s_def[ch].dest != DB_SELF) return ALT_E_BAD_OPERATION;   // canale dell'altro core
+
+    uint32_t cpsr = arm_irq_save();
+    s_db[ch].cb       = cb;
+    s_db[ch].ctx      = ctx;
+    s_db[ch].mode     = mode;
+    s_db[ch].deferred = 0u;
+    doorbell_scan();
+    arm_irq_restore(cpsr);
+    return ALT_E_SUCCESS;
+}
+
+void doorbell_unregister(doorbell_ch_t ch)
+{
+    if (ch >= DB_QTY) return;
+    uint32_t cpsr = arm_irq_save();
+    s_db[ch].cb       = NULL;
+    s_db[ch].ctx      = NULL;
+    s_db[ch].deferred = 0u;
+    arm_irq_restore(cpsr);
+}
+
+ALT_STATUS_CODE doorbell_ring(doorbell_ch_t ch)
+{
+    if (ch >= DB_QTY) return ALT_E_BAD_ARG;
+    const uint32_t dest = s_def[ch].dest;
+    if (dest == DB_SELF) return ALT_E_BAD_OPERATION;
+
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+    uint32_t cpsr = arm_irq_save();                // un solo scrittore per contatore
+
+    SHM_CTRL->db_ring[ch] = SHM_CTRL->db_ring[ch] + 1u;
+    __asm__ volatile("dmb sy" ::: "memory");       // contatore visibile prima di leggere db_pend
+
+    if (SHM_CTRL->db_pend[dest] == 0u) {
+        SHM_CTRL->db_pend[dest] = 1u;
+        __asm__ volatile("dsb sy" ::: "memory");
+#if defined(CORE1)
+        // alt_int_sgi_trigger usa lo stato di alt_int_global_init, che Core1 non ha
+        alt_write_word((void *)(uintptr_t)GICD_SGIR, ((1u << dest) << 16) | (uint32_t)DOORBELL_SGI);
+#else
+        status = alt_int_sgi_trigger(DOORBELL_SGI, ALT_INT_SGI_TARGET_LIST,
+                                     (alt_int_cpu_target_t)(1u << dest), true);
+#endif
+        s_sent++;
+    }
+
+    arm_irq_restore(cpsr);
+    return status;
+}
+
+uint32_t doorbell_poll(void)
+{
+    uint32_t calls = 0u;
+
+    for (uint32_t i = 0; i < DB_QTY; ++i) {
+        doorbell_slot_t *d = &s_db[i];
+        if (!d->deferred) continue;
+
+        uint32_t cpsr = arm_irq_save();
+        uint32_t n = d->deferred;
+        doorbell_cb_t cb = d->cb;
+        void *ctx = d->ctx;
+        d->deferred = 0u;
+        arm_irq_restore(cpsr);
+
+        if (cb && n) {
+            d->calls++;
+            cb((doorbell_ch_t)i, n, ctx);
+            calls++;
+        }
+    }
+    return calls;
+}
+
+const char *doorbell_name(doorbell_ch_t ch)
+{
+    return (ch < DB_QTY) ? s_def[ch].name : "?";
+}
+
+void doorbell_dump(void)
+{
+    fmt_printf("\r\nDOORBELL core%u: sgi rx %u tx %u", DB_SELF, s_irqs, s_sent);
+    for (uint32_t i = 0; i < DB_QTY; ++i)
+        fmt_printf("\r\n  %-12s -> core%u ring %u seen %u calls %u",
+                   s_def[i].name, s_def[i].dest, SHM_CTRL->db_ring[i], s_db[i].seen, s_db[i].calls);
+}
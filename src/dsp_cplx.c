@@ -0,0 +1,412 @@
+// dsp_cplx.c
+// Kernel complessi (NEON + riferimento scalare) per conversione, finestre e quantizzazione Q1.15.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "alt_globaltmr.h"
+#include "dsp_cplx.h"
+#include "mem_pool.h"
+#include "fmt_min.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DSP_NEON  1
+#else
+#define DSP_NEON  0
+#endif
+
+// ---------------------------
+// Finestre
+// ---------------------------
+/* cos/sin di x in [0, 2pi]: Taylor su x/16 e 4 raddoppi (niente libm su Core1) */
+void dsp_cossin(double x, double *c, double *s)
+{
+    double h = x / 16.0, h2 = h * h;
+    double cc = 1.0 - h2 / 2.0 * (1.0 - h2 / 12.0 * (1.0 - h2 / 30.0 * (1.0 - h2 / 56.0)));
+    double ss = h * (1.0 - h2 / 6.0 * (1.0 - h2 / 20.0 * (1.0 - h2 / 42.0 * (1.0 - h2 / 72.0))));
+    for (int k = 0; k < 4; ++k) {
+        double t = 2.0 * ss * cc;
+        cc = cc * cc - ss * ss;
+        ss = t;
+    }
+    *c = cc;
+    *s = ss;
+}
+
+void dsp_win_init(dsp_win_t *w, dsp_win_type_t type, uint32_t n)
+{
+    w->type = type;
+    w->c = 1.0;
+    w->s = 0.0;
+    dsp_cossin((n > 1u) ? (2.0 * 3.14159265358979323846 / (double)(n - 1u)) : 0.0, &w->dc, &w->ds);
+}
+
+void dsp_win_block(dsp_win_t *w, float *out, uint32_t m)
+{
+    double c = w->c, s = w->s;
+    for (uint32_t i = 0; i < m; ++i) {
+        double v;
+        switch (w->type) {
+            case DSP_WIN_HANN:     v = 0.5 - 0.5 * c;                               break;
+            case DSP_WIN_HAMMING:  v = 0.54 - 0.46 * c;                             break;
+            case DSP_WIN_BLACKMAN: v = 0.42 - 0.5 * c + 0.08 * (2.0 * c * c - 1.0); break;
+            default:               v = 1.0;                                         break;
+        }
+        out[i] = (float)v;
+        double nc = c * w->dc - s * w->ds;
+        s = s * w->dc + c * w->ds;
+        c = nc;
+    }
+    w->c = c;
+    w->s = s;
+}
+
+// ---------------------------
+// Riferimenti scalari
+// ---------------------------
+void dsp_deint_s16_ref(const int16_t *iq, float *re, float *im, uint32_t n, float scale)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        re[i] = (float)iq[2u * i]      * scale;
+        im[i] = (float)iq[2u * i + 1u] * scale;
+    }
+}
+
+void dsp_s16_f32_ref(const int16_t *x, float *y, uint32_t n, float scale)
+{
+    for (uint32_t i = 0; i < n; ++i) y[i] = (float)x[i] * scale;
+}
+
+void dsp_deint_f32_ref(const float *iq, float *re, float *im, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        float r = iq[2u * i], q = iq[2u * i + 1u];
+        re[i] = r;
+        im[i] = q;
+    }
+}
+
+void dsp_int_f32_ref(const float *re, const float *im, float *iq, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        float r = re[i], q = im[i];
+        iq[2u * i]      = r;
+        iq[2u * i + 1u] = q;
+    }
+}
+
+void dsp_cmul_f32_ref(const float *ar, const float *ai, const float *br, const float *bi,
+                      float *yr, float *yi, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        float r = ar[i] * br[i] - ai[i] * bi[i];
+        float q = ar[i] * bi[i] + ai[i] * br[i];
+        yr[i] = r;
+        yi[i] = q;
+    }
+}
+
+void dsp_cmul_f32_iq_ref(const float *a, const float *b, float *y, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        float ar = a[2u * i], ai = a[2u * i + 1u];
+        float br = b[2u * i], bi = b[2u * i + 1u];
+        y[2u * i]      = ar * br - ai * bi;
+        y[2u * i + 1u] = ar * bi + ai * br;
+    }
+}
+
+void dsp_scale_f32_ref(const float *x, float *y, uint32_t n, float k)
+{
+    for (uint32_t i = 0; i < n; ++i) y[i] = x[i] * k;
+}
+
+void dsp_window_f32_ref(const float *xr, const float *xi, const float *w,
+                        float *yr, float *yi, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        yr[i] = xr[i] * w[i];
+        yi[i] = xi[i] * w[i];
+    }
+}
+
+static inline int16_t q15_one(float x, uint32_t *clip)
+{
+    if (x > 32767.5f || x < -32768.5f) (*clip)++;
+    x += (x < 0.0f) ? -0.5f : 0.5f;
+    if (x >=  32767.0f) return  32767;
+    if (x <= -32768.0f) return -32768;
+    return (int16_t)x;                              // troncamento verso zero
+}
+
+uint32_t dsp_q15_iq_ref(const float *re, const float *im, float gain, int16_t *iq, uint32_t n)
+{
+    const float k = gain * 32768.0f;
+    uint32_t clip = 0u;
+    for (uint32_t i = 0; i < n; ++i) {
+        iq[2u * i]      = q15_one(re[i] * k, &clip);
+        iq[2u * i + 1u] = q15_one(im[i] * k, &clip);
+    }
+    return clip;
+}
+
+// ---------------------------
+// NEON (coda con i riferimenti)
+// ---------------------------
+#if DSP_NEON
+
+void dsp_deint_s16(const int16_t *iq, float *re, float *im, uint32_t n, float scale)
+{
+    uint32_t i = 0;
+    for (; i + 8u <= n; i += 8u) {
+        int16x8x2_t v = vld2q_s16(iq + 2u * i);
+        vst1q_f32(re + i,      vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v.val[0]))),  scale));
+        vst1q_f32(re + i + 4u, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v.val[0]))), scale));
+        vst1q_f32(im + i,      vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v.val[1]))),  scale));
+        vst1q_f32(im + i + 4u, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v.val[1]))), scale));
+    }
+    dsp_deint_s16_ref(iq + 2u * i, re + i, im + i, n - i, scale);
+}
+
+void dsp_s16_f32(const int16_t *x, float *y, uint32_t n, float scale)
+{
+    uint32_t i = 0;
+    for (; i + 8u <= n; i += 8u) {
+        int16x8_t v = vld1q_s16(x + i);
+        vst1q_f32(y + i,      vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))),  scale));
+        vst1q_f32(y + i + 4u, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    dsp_s16_f32_ref(x + i, y + i, n - i, scale);
+}
+
+void dsp_deint_f32(const float *iq, float *re, float *im, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) {
+        float32x4x2_t v = vld2q_f32(iq + 2u * i);
+        vst1q_f32(re + i, v.val[0]);
+        vst1q_f32(im + i, v.val[1]);
+    }
+    dsp_deint_f32_ref(iq + 2u * i, re + i, im + i, n - i);
+}
+
+void dsp_int_f32(const float *re, const float *im, float *iq, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) {
+        float32x4x2_t v;
+        v.val[0] = vld1q_f32(re + i);
+        v.val[1] = vld1q_f32(im + i);
+        vst2q_f32(iq + 2u * i, v);
+    }
+    dsp_int_f32_ref(re + i, im + i, iq + 2u * i, n - i);
+}
+
+void dsp_cmul_f32(const float *ar, const float *ai, const float *br, const float *bi,
+                  float *yr, float *yi, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) {
+        float32x4_t a_r = vld1q_f32(ar + i), a_i = vld1q_f32(ai + i);
+        float32x4_t b_r = vld1q_f32(br + i), b_i = vld1q_f32(bi + i);
+        vst1q_f32(yr + i, vmlsq_f32(vmulq_f32(a_r, b_r), a_i, b_i));
+        vst1q_f32(yi + i, vmlaq_f32(vmulq_f32(a_r, b_i), a_i, b_r));
+    }
+    dsp_cmul_f32_ref(ar + i, ai + i, br + i, bi + i, yr + i, yi + i, n - i);
+}
+
+void dsp_cmul_f32_iq(const float *a, const float *b, float *y, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) {
+        float32x4x2_t va = vld2q_f32(a + 2u * i);
+        float32x4x2_t vb = vld2q_f32(b + 2u * i);
+        float32x4x2_t vy;
+        vy.val[0] = vmlsq_f32(vmulq_f32(va.val[0], vb.val[0]), va.val[1], vb.val[1]);
+        vy.val[1] = vmlaq_f32(vmulq_f32(va.val[0], vb.val[1]), va.val[1], vb.val[0]);
+        vst2q_f32(y + 2u * i, vy);
+    }
+    dsp_cmul_f32_iq_ref(a + 2u * i, b + 2u * i, y + 2u * i, n - i);
+}
+
+void dsp_scale_f32(const float *x, float *y, uint32_t n, float k)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) vst1q_f32(y + i, vmulq_n_f32(vld1q_f32(x + i), k));
+    dsp_scale_f32_ref(x + i, y + i, n - i, k);
+}
+
+void dsp_window_f32(const float *xr, const float *xi, const float *w,
+                    float *yr, float *yi, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4u <= n; i += 4u) {
+        float32x4_t vw = vld1q_f32(w + i);
+        vst1q_f32(yr + i, vmulq_f32(vld1q_f32(xr + i), vw));
+        vst1q_f32(yi + i, vmulq_f32(vld1q_f32(xi + i), vw));
+    }
+    dsp_window_f32_ref(xr + i, xi + i, w + i, yr + i, yi + i, n - i);
+}
+
+/* 4 campioni -> int32 saturati/arrotondati, conta i fuori scala in *acc */
+static inline int32x4_t q15_quad(float32x4_t x, uint32x4_t *acc)
+{
+    const float32x4_t hi = vdupq_n_f32(32767.5f), lo = vdupq_n_f32(-32768.5f);
+    uint32x4_t m = vorrq_u32(vcgtq_f32(x, hi), vcltq_f32(x, lo));
+    *acc = vsubq_u32(*acc, m);                      // maschera = -1 per lane saturata
+
+    // +-0.5 col segno di x, poi troncamento (come q15_one)
+    uint32x4_t sgn = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000u));
+    float32x4_t h  = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sgn));
+    return vcvtq_s32_f32(vaddq_f32(x, h));
+}
+
+uint32_t dsp_q15_iq(const float *re, const float *im, float gain, int16_t *iq, uint32_t n)
+{
+    const float k = gain * 32768.0f;
+    uint32x4_t acc = vdupq_n_u32(0u);
+    uint32_t i = 0;
+
+    for (; i + 8u <= n; i += 8u) {
+        int32x4_t r0 = q15_quad(vmulq_n_f32(vld1q_f32(re + i),      k), &acc);
+        int32x4_t r1 = q15_quad(vmulq_n_f32(vld1q_f32(re + i + 4u), k), &acc);
+        int32x4_t i0 = q15_quad(vmulq_n_f32(vld1q_f32(im + i),      k), &acc);
+        int32x4_t i1 = q15_quad(vmulq_n_f32(vld1q_f32(im + i + 4u), k), &acc);
+        int16x8x2_t o;
+        o.val[0] = vcombine_s16(vqmovn_s32(r0), vqmovn_s32(r1));
+        o.val[1] = vcombine_s16(vqmovn_s32(i0), vqmovn_s32(i1));
+        vst2q_s16(iq + 2u * i, o);
+    }
+
+    uint32_t clip = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+                    vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    return clip + dsp_q15_iq_ref(re + i, im + i, gain, iq + 2u * i, n - i);
+}
+
+#else   /* senza NEON: solo i riferimenti */
+
+void dsp_deint_s16(const int16_t *iq, float *re, float *im, uint32_t n, float scale) { dsp_deint_s16_ref(iq, re, im, n, scale); }
+void dsp_s16_f32(const int16_t *x, float *y, uint32_t n, float scale)                { dsp_s16_f32_ref(x, y, n, scale); }
+void dsp_deint_f32(const float *iq, float *re, float *im, uint32_t n)                { dsp_deint_f32_ref(iq, re, im, n); }
+void dsp_int_f32(const float *re, const float *im, float *iq, uint32_t n)            { dsp_int_f32_ref(re, im, iq, n); }
+void dsp_cmul_f32(const float *ar, const float *ai, const float *br, const float *bi,
+                  float *yr, float *yi, uint32_t n)                                  { dsp_cmul_f32_ref(ar, ai, br, bi, yr, yi, n); }
+void dsp_cmul_f32_iq(const float *a, const float *b, float *y, uint32_t n)           { dsp_cmul_f32_iq_ref(a, b, y, n); }
+void dsp_scale_f32(const float *x, float *y, uint32_t n, float k)                    { dsp_scale_f32_ref(x, y, n, k); }
+void dsp_window_f32(const float *xr, const float *xi, const float *w,
+                    float *yr, float *yi, uint32_t n)                                { dsp_window_f32_ref(xr, xi, w, yr, yi, n); }
+uint32_t dsp_q15_iq(const float *re, const float *im, float gain, int16_t *iq, uint32_t n)
+{
+    return dsp_q15_iq_ref(re, im, gain, iq, n);
+}
+
+#endif
+
+// ---------------------------
+// Benchmark
+// ---------------------------
+static float *s_b[10];          // 8 piani + 2 interleaved (2N)
+static int16_t *s_q[2];
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed;
+}
+
+/* max |a-b| in milionesimi */
+static uint32_t max_diff_ppm(const float *a, const float *b, uint32_t n)
+{
+    float m = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+        float d = a[i] - b[i];
+        if (d < 0.0f) d = -d;
+        if (d > m) m = d;
+    }
+    return (uint32_t)(m * 1000000.0f);
+}
+
+static void bench_line(const char *name, uint32_t t_ref, uint32_t t_neon, uint32_t err, const char *unit)
+{
+    const uint32_t n = DSP_BENCH_N;
+    fmt_printf("\r\nDSP %-10s ref %u tick (%.2q/camp)  neon %u tick (%.2q/camp)  x%.2q  scarto %u %s",
+               name, t_ref, (t_ref * 100u) / n, t_neon, (t_neon * 100u) / n,
+               t_neon ? (t_ref * 100u) / t_neon : 0u, err, unit);
+}
+
+void dsp_bench(void)
+{
+    const uint32_t n = DSP_BENCH_N;
+
+    if (!s_b[0]) {
+        mem_arena_t *a = mem_arena_get(MEM_REGION_DDR);
+        for (uint32_t i = 0; i < 10u; ++i)
+            s_b[i] = (float *)mem_arena_alloc(a, ((i < 8u) ? n : 2u * n) * sizeof(float), MEM_POOL_ALIGN);
+        for (uint32_t i = 0; i < 2u; ++i)
+            s_q[i] = (int16_t *)mem_arena_alloc(a, 2u * n * sizeof(int16_t), MEM_POOL_ALIGN);
+        for (uint32_t i = 0; i < 10u; ++i) if (!s_b[i]) { fmt_printf("\r\nDSP bench: memoria"); return; }
+        if (!s_q[0] || !s_q[1]) { fmt_printf("\r\nDSP bench: memoria"); return; }
+    }
+
+    float *ar = s_b[0], *ai = s_b[1], *br = s_b[2], *bi = s_b[3];
+    float *y0r = s_b[4], *y0i = s_b[5], *y1r = s_b[6], *y1i = s_b[7];
+    float *iq0 = s_b[8], *iq1 = s_b[9];
+
+    // ingressi in [-1.25, 1.25): una parte satura in Q1.15
+    uint32_t seed = 12345u;
+    for (uint32_t i = 0; i < n; ++i) {
+        ar[i] = ((float)(int32_t)bench_rand(&seed)) * (1.25f / 2147483648.0f);
+        ai[i] = ((float)(int32_t)bench_rand(&seed)) * (1.25f / 2147483648.0f);
+        br[i] = ((float)(int32_t)bench_rand(&seed)) * (1.0f / 2147483648.0f);
+        bi[i] = ((float)(int32_t)bench_rand(&seed)) * (1.0f / 2147483648.0f);
+    }
+    (void)alt_globaltmr_init();
+    uint32_t t0, t1, t2;
+
+    t0 = alt_globaltmr_counter_get_low32(); dsp_cmul_f32_ref(ar, ai, br, bi, y0r, y0i, n);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_cmul_f32(ar, ai, br, bi, y1r, y1i, n);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("cmul", t1 - t0, t2 - t1, max_diff_ppm(y0r, y1r, n) + max_diff_ppm(y0i, y1i, n), "ppm");
+
+    dsp_int_f32_ref(ar, ai, iq0, n);
+    dsp_int_f32_ref(br, bi, iq1, n);
+    t0 = alt_globaltmr_counter_get_low32(); dsp_cmul_f32_iq_ref(iq0, iq1, y0r, n / 2u);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_cmul_f32_iq(iq0, iq1, y1r, n / 2u);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("cmul_iq", (t1 - t0) * 2u, (t2 - t1) * 2u, max_diff_ppm(y0r, y1r, n), "ppm");
+
+    t0 = alt_globaltmr_counter_get_low32(); dsp_int_f32_ref(ar, ai, iq0, n);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_int_f32(ar, ai, iq1, n);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("interleave", t1 - t0, t2 - t1, max_diff_ppm(iq0, iq1, 2u * n), "ppm");
+
+    t0 = alt_globaltmr_counter_get_low32(); dsp_deint_f32_ref(iq0, y0r, y0i, n);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_deint_f32(iq0, y1r, y1i, n);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("deint", t1 - t0, t2 - t1, max_diff_ppm(y0r, y1r, n) + max_diff_ppm(y0i, y1i, n), "ppm");
+
+    dsp_win_t w;
+    dsp_win_init(&w, DSP_WIN_BLACKMAN, n);
+    dsp_win_block(&w, br, n);
+    t0 = alt_globaltmr_counter_get_low32(); dsp_window_f32_ref(ar, ai, br, y0r, y0i, n);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_window_f32(ar, ai, br, y1r, y1i, n);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("window", t1 - t0, t2 - t1, max_diff_ppm(y0r, y1r, n) + max_diff_ppm(y0i, y1i, n), "ppm");
+
+    uint32_t c0, c1, bad = 0u;
+    t0 = alt_globaltmr_counter_get_low32(); c0 = dsp_q15_iq_ref(ar, ai, 1.0f, s_q[0], n);
+    t1 = alt_globaltmr_counter_get_low32(); c1 = dsp_q15_iq(ar, ai, 1.0f, s_q[1], n);
+    t2 = alt_globaltmr_counter_get_low32();
+    for (uint32_t i = 0; i < 2u * n; ++i) if (s_q[0][i] != s_q[1][i]) bad++;
+    if (c0 != c1) bad++;
+    bench_line("q15", t1 - t0, t2 - t1, bad, "diversi");
+
+    dsp_s16_f32_ref(s_q[0], iq0, 2u * n, 1.0f / 32768.0f);
+    t0 = alt_globaltmr_counter_get_low32(); dsp_deint_s16_ref(s_q[0], y0r, y0i, n, 1.0f / 32768.0f);
+    t1 = alt_globaltmr_counter_get_low32(); dsp_deint_s16(s_q[0], y1r, y1i, n, 1.0f / 32768.0f);
+    t2 = alt_globaltmr_counter_get_low32();
+    bench_line("deint_s16", t1 - t0, t2 - t1, max_diff_ppm(y0r, y1r, n) + max_diff_ppm(y0i, y1i, n), "ppm");
+
+    fmt_printf("\r\nDSP bench: %u campioni, %s, saturati %u", n, DSP_NEON ? "NEON" : "solo scalare", c0);
+}
@@ -0,0 +1,534 @@
+// dsp_fft.c
+// FFT radix-4 DIF in place (float e Q1.15), twiddle per lunghezza di stadio in cache nell'arena DDR.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "alt_globaltmr.h"
+#include "dsp_fft.h"
+#include "dsp_cplx.h"
+#include "mem_pool.h"
+#include "fmt_min.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FFT_NEON  1
+#else
+#define FFT_NEON  0
+#endif
+
+// ---------------------------
+// Twiddle
+// ---------------------------
+/* Stadio di lunghezza L = 2^lg, q = L/4: [w1r|w1i|w2r|w2i|w3r|w3i], q valori ciascuno,
+ * w^k = e^-j2pi k/L. */
+typedef struct {
+    float   *f;
+    int16_t *q;
+} fft_tw_t;
+
+static fft_tw_t s_tw[DSP_FFT_LOG2_MAX + 1u];
+static uint32_t s_tw_bytes;
+
+static inline int16_t tw_q15(float x)
+{
+    float v = x * 32768.0f;
+    v += (v < 0.0f) ? -0.5f : 0.5f;
+    if (v >=  32767.0f) return  32767;
+    if (v <= -32768.0f) return -32768;
+    return (int16_t)v;
+}
+
+static ALT_STATUS_CODE tw_build(uint32_t lg)
+{
+    fft_tw_t *t = &s_tw[lg];
+    if (t->f) return ALT_E_SUCCESS;
+
+    const uint32_t q = (1u << lg) >> 2;
+    mem_arena_t *a = mem_arena_get(MEM_REGION_DDR);
+    float   *f  = (float *)mem_arena_alloc(a, 6u * q * sizeof(float), MEM_POOL_ALIGN);
+    int16_t *qq = (int16_t *)mem_arena_alloc(a, 6u * q * sizeof(int16_t), MEM_POOL_ALIGN);
+    if (!f || !qq) return ALT_E_ERROR;     // arena esaurita (il parziale resta perso, come ogni arena)
+
+    // w^k per k = 0..3(q-1) con rotazione incrementale in double
+    double c = 1.0, s = 0.0, dc, ds;
+    dsp_cossin(2.0 * 3.14159265358979323846 / (double)(1u << lg), &dc, &ds);
+    for (uint32_t k = 0; k <= 3u * (q - 1u); ++k) {
+        float wr = (float)c, wi = (float)-s;
+        if (k < q)                        { f[k]              = wr; f[q + k]          = wi; }
+        if (!(k & 1u) && ((k >> 1) < q))  { f[2u * q + k / 2u] = wr; f[3u * q + k / 2u] = wi; }
+        if ((k % 3u) == 0u)               { f[4u * q + k / 3u] = wr; f[5u * q + k / 3u] = wi; }
+        double nc = c * dc - s * ds;
+        s = s * dc + c * ds;
+        c = nc;
+    }
+    for (uint32_t i = 0; i < 6u * q; ++i) qq[i] = tw_q15(f[i]);
+
+    s_tw_bytes += 6u * q * (uint32_t)(sizeof(float) + sizeof(int16_t));
+    t->q = qq;
+    t->f = f;
+    return ALT_E_SUCCESS;
+}
+
+static ALT_STATUS_CODE fft_log2(uint32_t n, uint32_t *lg)
+{
+    if (n == 0u || (n & (n - 1u))) return ALT_E_ARG_RANGE;
+    uint32_t l = 0u;
+    while ((1u << l) < n) l++;
+    if (l < DSP_FFT_LOG2_MIN || l > DSP_FFT_LOG2_MAX) return ALT_E_ARG_RANGE;
+    *lg = l;
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE dsp_fft_prepare(uint32_t n)
+{
+    uint32_t lg = 0u;
+    ALT_STATUS_CODE s = fft_log2(n, &lg);
+    for (uint32_t l = lg; (s == ALT_E_SUCCESS) && (l >= 2u); l -= 2u) s = tw_build(l);
+    return s;
+}
+
+// ---------------------------
+// Stadi float (scalari)
+// ---------------------------
+/* Radix-4 DIF: y0 -> q0, y2 -> q1, y1 -> q2, y3 -> q3 (ordine bit-reversed binario,
+ * così radix-4 e radix-2 si mescolano con una sola permutazione finale). */
+static void r4_f32_ref(float *re, float *im, uint32_t n, uint32_t lg)
+{
+    const uint32_t L = 1u << lg, q = L >> 2;
+    const float *w = s_tw[lg].f;
+
+    for (uint32_t b = 0; b < n; b += L) {
+        for (uint32_t j = 0; j < q; ++j) {
+            const uint32_t i0 = b + j, i1 = i0 + q, i2 = i1 + q, i3 = i2 + q;
+            float t0r = re[i0] + re[i2], t0i = im[i0] + im[i2];
+            float t1r = re[i0] - re[i2], t1i = im[i0] - im[i2];
+            float t2r = re[i1] + re[i3], t2i = im[i1] + im[i3];
+            float t3r = re[i1] - re[i3], t3i = im[i1] - im[i3];
+
+            float y2r = t0r - t2r, y2i = t0i - t2i;
+            float y1r = t1r + t3i, y1i = t1i - t3r;        // t1 - j t3
+            float y3r = t1r - t3i, y3i = t1i + t3r;        // t1 + j t3
+
+            re[i0] = t0r + t2r;
+            im[i0] = t0i + t2i;
+            re[i1] = y2r * w[2u * q + j] - y2i * w[3u * q + j];
+            im[i1] = y2r * w[3u * q + j] + y2i * w[2u * q + j];
+            re[i2] = y1r * w[j]          - y1i * w[q + j];
+            im[i2] = y1r * w[q + j]      + y1i * w[j];
+            re[i3] = y3r * w[4u * q + j] - y3i * w[5u * q + j];
+            im[i3] = y3r * w[5u * q + j] + y3i * w[4u * q + j];
+        }
+    }
+}
+
+static void r2_f32_ref(float *re, float *im, uint32_t n)
+{
+    for (uint32_t b = 0; b < n; b += 2u) {
+        float ar = re[b], ai = im[b], br = re[b + 1u], bi = im[b + 1u];
+        re[b] = ar + br;  im[b] = ai + bi;
+        re[b + 1u] = ar - br;  im[b + 1u] = ai - bi;
+    }
+}
+
+static void bitrev_f32(float *re, float *im, uint32_t n)
+{
+    for (uint32_t i = 0, j = 0; i < n; ++i) {
+        if (i < j) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+        uint32_t m = n >> 1;
+        while (j & m) { j ^= m; m >>= 1; }
+        j |= m;
+    }
+}
+
+// ---------------------------
+// Stadi Q1.15 (scalari, stessa aritmetica delle istruzioni NEON)
+// ---------------------------
+static inline int16_t q_sat(int32_t x)   { return (int16_t)((x > 32767) ? 32767 : (x < -32768) ? -32768 : x); }
+static inline int16_t q_hadd(int16_t a, int16_t b) { return (int16_t)(((int32_t)a + b) >> 1); }   // vhadd
+static inline int16_t q_hsub(int16_t a, int16_t b) { return (int16_t)(((int32_t)a - b) >> 1); }   // vhsub
+static inline int16_t q_mul(int16_t a, int16_t b)                                                  // vqrdmulh
+{
+    return q_sat((int32_t)((2 * (int64_t)a * b + 0x8000) >> 16));
+}
+
+static void r4_q15_ref(int16_t *re, int16_t *im, uint32_t n, uint32_t lg)
+{
+    const uint32_t L = 1u << lg, q = L >> 2;
+    const int16_t *w = s_tw[lg].q;
+
+    for (uint32_t b = 0; b < n; b += L) {
+        for (uint32_t j = 0; j < q; ++j) {
+            const uint32_t i0 = b + j, i1 = i0 + q, i2 = i1 + q, i3 = i2 + q;
+            int16_t t0r = q_hadd(re[i0], re[i2]), t0i = q_hadd(im[i0], im[i2]);
+            int16_t t1r = q_hsub(re[i0], re[i2]), t1i = q_hsub(im[i0], im[i2]);
+            int16_t t2r = q_hadd(re[i1], re[i3]), t2i = q_hadd(im[i1], im[i3]);
+            int16_t t3r = q_hsub(re[i1], re[i3]), t3i = q_hsub(im[i1], im[i3]);
+
+            int16_t y2r = q_hsub(t0r, t2r), y2i = q_hsub(t0i, t2i);
+            int16_t y1r = q_hadd(t1r, t3i), y1i = q_hsub(t1i, t3r);
+            int16_t y3r = q_hsub(t1r, t3i), y3i = q_hadd(t1i, t3r);
+
+            re[i0] = q_hadd(t0r, t2r);
+            im[i0] = q_hadd(t0i, t2i);
+            re[i1] = q_sat((int32_t)q_mul(y2r, w[2u * q + j]) - q_mul(y2i, w[3u * q + j]));
+            im[i1] = q_sat((int32_t)q_mul(y2r, w[3u * q + j]) + q_mul(y2i, w[2u * q + j]));
+            re[i2] = q_sat((int32_t)q_mul(y1r, w[j])          - q_mul(y1i, w[q + j]));
+            im[i2] = q_sat((int32_t)q_mul(y1r, w[q + j])      + q_mul(y1i, w[j]));
+            re[i3] = q_sat((int32_t)q_mul(y3r, w[4u * q + j]) - q_mul(y3i, w[5u * q + j]));
+            im[i3] = q_sat((int32_t)q_mul(y3r, w[5u * q + j]) + q_mul(y3i, w[4u * q + j]));
+        }
+    }
+}
+
+static void r2_q15_ref(int16_t *re, int16_t *im, uint32_t n)
+{
+    for (uint32_t b = 0; b < n; b += 2u) {
+        int16_t ar = re[b], ai = im[b], br = re[b + 1u], bi = im[b + 1u];
+        re[b] = q_hadd(ar, br);  im[b] = q_hadd(ai, bi);
+        re[b + 1u] = q_hsub(ar, br);  im[b + 1u] = q_hsub(ai, bi);
+    }
+}
+
+static void bitrev_q15(int16_t *re, int16_t *im, uint32_t n)
+{
+    for (uint32_t i = 0, j = 0; i < n; ++i) {
+        if (i < j) {
+            int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+        uint32_t m = n >> 1;
+        while (j & m) { j ^= m; m >>= 1; }
+        j |= m;
+    }
+}
+
+// ---------------------------
+// Stadi NEON
+// ---------------------------
+#if FFT_NEON
+
+static void r4_f32_neon(float *re, float *im, uint32_t n, uint32_t lg)
+{
+    const uint32_t L = 1u << lg, q = L >> 2;
+    const float *w = s_tw[lg].f;
+    if (q < 4u) { r4_f32_ref(re, im, n, lg); return; }
+
+    for (uint32_t b = 0; b < n; b += L) {
+        float *r0 = re + b, *r1 = r0 + q, *r2 = r1 + q, *r3 = r2 + q;
+        float *m0 = im + b, *m1 = m0 + q, *m2 = m1 + q, *m3 = m2 + q;
+        for (uint32_t j = 0; j < q; j += 4u) {
+            float32x4_t a0r = vld1q_f32(r0 + j), a0i = vld1q_f32(m0 + j);
+            float32x4_t a1r = vld1q_f32(r1 + j), a1i = vld1q_f32(m1 + j);
+            float32x4_t a2r = vld1q_f32(r2 + j), a2i = vld1q_f32(m2 + j);
+            float32x4_t a3r = vld1q_f32(r3 + j), a3i = vld1q_f32(m3 + j);
+
+            float32x4_t t0r = vaddq_f32(a0r, a2r), t0i = vaddq_f32(a0i, a2i);
+            float32x4_t t1r = vsubq_f32(a0r, a2r), t1i = vsubq_f32(a0i, a2i);
+            float32x4_t t2r = vaddq_f32(a1r, a3r), t2i = vaddq_f32(a1i, a3i);
+            float32x4_t t3r = vsubq_f32(a1r, a3r), t3i = vsubq_f32(a1i, a3i);
+
+            vst1q_f32(r0 + j, vaddq_f32(t0r, t2r));
+            vst1q_f32(m0 + j, vaddq_f32(t0i, t2i));
+
+            float32x4_t yr = vsubq_f32(t0r, t2r), yi = vsubq_f32(t0i, t2i);
+            float32x4_t wr = vld1q_f32(w + 2u * q + j), wi = vld1q_f32(w + 3u * q + j);
+            vst1q_f32(r1 + j, vmlsq_f32(vmulq_f32(yr, wr), yi, wi));
+            vst1q_f32(m1 + j, vmlaq_f32(vmulq_f32(yr, wi), yi, wr));
+
+            yr = vaddq_f32(t1r, t3i); yi = vsubq_f32(t1i, t3r);
+            wr = vld1q_f32(w + j);    wi = vld1q_f32(w + q + j);
+            vst1q_f32(r2 + j, vmlsq_f32(vmulq_f32(yr, wr), yi, wi));
+            vst1q_f32(m2 + j, vmlaq_f32(vmulq_f32(yr, wi), yi, wr));
+
+            yr = vsubq_f32(t1r, t3i); yi = vaddq_f32(t1i, t3r);
+            wr = vld1q_f32(w + 4u * q + j); wi = vld1q_f32(w + 5u * q + j);
+            vst1q_f32(r3 + j, vmlsq_f32(vmulq_f32(yr, wr), yi, wi));
+            vst1q_f32(m3 + j, vmlaq_f32(vmulq_f32(yr, wi), yi, wr));
+        }
+    }
+}
+
+/* Ultimo stadio radix-4 (L = 4, twiddle unitari): 4 gruppi per volta con vld4 */
+static void r4_last_f32_neon(float *re, float *im, uint32_t n)
+{
+    if (n < 16u) { r4_f32_ref(re, im, n, 2u); return; }
+
+    for (uint32_t b = 0; b < n; b += 16u) {
+        float32x4x4_t r = vld4q_f32(re + b), m = vld4q_f32(im + b);
+        float32x4_t t0r = vaddq_f32(r.val[0], r.val[2]), t0i = vaddq_f32(m.val[0], m.val[2]);
+        float32x4_t t1r = vsubq_f32(r.val[0], r.val[2]), t1i = vsubq_f32(m.val[0], m.val[2]);
+        float32x4_t t2r = vaddq_f32(r.val[1], r.val[3]), t2i = vaddq_f32(m.val[1], m.val[3]);
+        float32x4_t t3r = vsubq_f32(r.val[1], r.val[3]), t3i = vsubq_f32(m.val[1], m.val[3]);
+        r.val[0] = vaddq_f32(t0r, t2r); m.val[0] = vaddq_f32(t0i, t2i);
+        r.val[1] = vsubq_f32(t0r, t2r); m.val[1] = vsubq_f32(t0i, t2i);
+        r.val[2] = vaddq_f32(t1r, t3i); m.val[2] = vsubq_f32(t1i, t3r);
+        r.val[3] = vsubq_f32(t1r, t3i); m.val[3] = vaddq_f32(t1i, t3r);
+        vst4q_f32(re + b, r);
+        vst4q_f32(im + b, m);
+    }
+}
+
+static void r2_f32_neon(float *re, float *im, uint32_t n)
+{
+    if (n < 8u) { r2_f32_ref(re, im, n); return; }
+
+    for (uint32_t b = 0; b < n; b += 8u) {
+        float32x4x2_t r = vld2q_f32(re + b), m = vld2q_f32(im + b);
+        float32x4_t sr = vaddq_f32(r.val[0], r.val[1]), si = vaddq_f32(m.val[0], m.val[1]);
+        r.val[1] = vsubq_f32(r.val[0], r.val[1]);
+        m.val[1] = vsubq_f32(m.val[0], m.val[1]);
+        r.val[0] = sr;
+        m.val[0] = si;
+        vst2q_f32(re + b, r);
+        vst2q_f32(im + b, m);
+    }
+}
+
+static inline int16x8_t q_cmul_re(int16x8_t yr, int16x8_t yi, int16x8_t wr, int16x8_t wi)
+{
+    return vqsubq_s16(vqrdmulhq_s16(yr, wr), vqrdmulhq_s16(yi, wi));
+}
+
+static inline int16x8_t q_cmul_im(int16x8_t yr, int16x8_t yi, int16x8_t wr, int16x8_t wi)
+{
+    return vqaddq_s16(vqrdmulhq_s16(yr, wi), vqrdmulhq_s16(yi, wr));
+}
+
+static void r4_q15_neon(int16_t *re, int16_t *im, uint32_t n, uint32_t lg)
+{
+    const uint32_t L = 1u << lg, q = L >> 2;
+    const int16_t *w = s_tw[lg].q;
+    if (q < 8u) { r4_q15_ref(re, im, n, lg); return; }
+
+    for (uint32_t b = 0; b < n; b += L) {
+        int16_t *r0 = re + b, *r1 = r0 + q, *r2 = r1 + q, *r3 = r2 + q;
+        int16_t *m0 = im + b, *m1 = m0 + q, *m2 = m1 + q, *m3 = m2 + q;
+        for (uint32_t j = 0; j < q; j += 8u) {
+            int16x8_t a0r = vld1q_s16(r0 + j), a0i = vld1q_s16(m0 + j);
+            int16x8_t a1r = vld1q_s16(r1 + j), a1i = vld1q_s16(m1 + j);
+            int16x8_t a2r = vld1q_s16(r2 + j), a2i = vld1q_s16(m2 + j);
+            int16x8_t a3r = vld1q_s16(r3 + j), a3i = vld1q_s16(m3 + j);
+
+            int16x8_t t0r = vhaddq_s16(a0r, a2r), t0i = vhaddq_s16(a0i, a2i);
+            int16x8_t t1r = vhsubq_s16(a0r, a2r), t1i = vhsubq_s16(a0i, a2i);
+            int16x8_t t2r = vhaddq_s16(a1r, a3r), t2i = vhaddq_s16(a1i, a3i);
+            int16x8_t t3r = vhsubq_s16(a1r, a3r), t3i = vhsubq_s16(a1i, a3i);
+
+            vst1q_s16(r0 + j, vhaddq_s16(t0r, t2r));
+            vst1q_s16(m0 + j, vhaddq_s16(t0i, t2i));
+
+            int16x8_t yr = vhsubq_s16(t0r, t2r), yi = vhsubq_s16(t0i, t2i);
+            int16x8_t wr = vld1q_s16(w + 2u * q + j), wi = vld1q_s16(w + 3u * q + j);
+            vst1q_s16(r1 + j, q_cmul_re(yr, yi, wr, wi));
+            vst1q_s16(m1 + j, q_cmul_im(yr, yi, wr, wi));
+
+            yr = vhaddq_s16(t1r, t3i); yi = vhsubq_s16(t1i, t3r);
+            wr = vld1q_s16(w + j);     wi = vld1q_s16(w + q + j);
+            vst1q_s16(r2 + j, q_cmul_re(yr, yi, wr, wi));
+            vst1q_s16(m2 + j, q_cmul_im(yr, yi, wr, wi));
+
+            yr = vhsubq_s16(t1r, t3i); yi = vhaddq_s16(t1i, t3r);
+            wr = vld1q_s16(w + 4u * q + j); wi = vld1q_s16(w + 5u * q + j);
+            vst1q_s16(r3 + j, q_cmul_re(yr, yi, wr, wi));
+            vst1q_s16(m3 + j, q_cmul_im(yr, yi, wr, wi));
+        }
+    }
+}
+
+static void r4_last_q15_neon(int16_t *re, int16_t *im, uint32_t n)
+{
+    if (n < 32u) { r4_q15_ref(re, im, n, 2u); return; }
+
+    for (uint32_t b = 0; b < n; b += 32u) {
+        int16x8x4_t r = vld4q_s16(re + b), m = vld4q_s16(im + b);
+        int16x8_t t0r = vhaddq_s16(r.val[0], r.val[2]), t0i = vhaddq_s16(m.val[0], m.val[2]);
+        int16x8_t t1r = vhsubq_s16(r.val[0], r.val[2]), t1i = vhsubq_s16(m.val[0], m.val[2]);
+        int16x8_t t2r = vhaddq_s16(r.val[1], r.val[3]), t2i = vhaddq_s16(m.val[1], m.val[3]);
+        int16x8_t t3r = vhsubq_s16(r.val[1], r.val[3]), t3i = vhsubq_s16(m.val[1], m.val[3]);
+        r.val[0] = vhaddq_s16(t0r, t2r); m.val[0] = vhaddq_s16(t0i, t2i);
+        r.val[1] = vhsubq_s16(t0r, t2r); m.val[1] = vhsubq_s16(t0i, t2i);
+        r.val[2] = vhaddq_s16(t1r, t3i); m.val[2] = vhsubq_s16(t1i, t3r);
+        r.val[3] = vhsubq_s16(t1r, t3i); m.val[3] = vhaddq_s16(t1i, t3r);
+        vst4q_s16(re + b, r);
+        vst4q_s16(im + b, m);
+    }
+}
+
+static void r2_q15_neon(int16_t *re, int16_t *im, uint32_t n)
+{
+    if (n < 16u) { r2_q15_ref(re, im, n); return; }
+
+    for (uint32_t b = 0; b < n; b += 16u) {
+        int16x8x2_t r = vld2q_s16(re + b), m = vld2q_s16(im + b);
+        int16x8_t sr = vhaddq_s16(r.val[0], r.val[1]), si = vhaddq_s16(m.val[0], m.val[1]);
+        r.val[1] = vhsubq_s16(r.val[0], r.val[1]);
+        m.val[1] = vhsubq_s16(m.val[0], m.val[1]);
+        r.val[0] = sr;
+        m.val[0] = si;
+        vst2q_s16(re + b, r);
+        vst2q_s16(im + b, m);
+    }
+}
+
+#else   /* senza NEON: gli stadi "veloci" sono quelli scalari */
+
+#define r4_f32_neon(re, im, n, lg)   r4_f32_ref(re, im, n, lg)
+#define r4_last_f32_neon(re, im, n)  r4_f32_ref(re, im, n, 2u)
+#define r2_f32_neon(re, im, n)       r2_f32_ref(re, im, n)
+#define r4_q15_neon(re, im, n, lg)   r4_q15_ref(re, im, n, lg)
+#define r4_last_q15_neon(re, im, n)  r4_q15_ref(re, im, n, 2u)
+#define r2_q15_neon(re, im, n)       r2_q15_ref(re, im, n)
+
+#endif
+
+// ---------------------------
+// FFT
+// ---------------------------
+static ALT_STATUS_CODE fft_f32(float *re, float *im, uint32_t n, bool neon)
+{
+    if (!re || !im) return ALT_E_BAD_ARG;
+    uint32_t lg = 0u;
+    ALT_STATUS_CODE s = fft_log2(n, &lg);
+    if (s == ALT_E_SUCCESS) s = dsp_fft_prepare(n);
+    if (s != ALT_E_SUCCESS) return s;
+
+    for (uint32_t l = lg; l >= 2u; l -= 2u) {
+        if (!neon)        r4_f32_ref(re, im, n, l);
+        else if (l == 2u) r4_last_f32_neon(re, im, n);
+        else              r4_f32_neon(re, im, n, l);
+    }
+    if (lg & 1u) {
+        if (neon) r2_f32_neon(re, im, n);
+        else      r2_f32_ref(re, im, n);
+    }
+    bitrev_f32(re, im, n);
+    return ALT_E_SUCCESS;
+}
+
+static ALT_STATUS_CODE fft_q15(int16_t *re, int16_t *im, uint32_t n, bool neon)
+{
+    if (!re || !im) return ALT_E_BAD_ARG;
+    uint32_t lg = 0u;
+    ALT_STATUS_CODE s = fft_log2(n, &lg);
+    if (s == ALT_E_SUCCESS) s = dsp_fft_prepare(n);
+    if (s != ALT_E_SUCCESS) return s;
+
+    for (uint32_t l = lg; l >= 2u; l -= 2u) {
+        if (!neon)        r4_q15_ref(re, im, n, l);
+        else if (l == 2u) r4_last_q15_neon(re, im, n);
+        else              r4_q15_neon(re, im, n, l);
+    }
+    if (lg & 1u) {
+        if (neon) r2_q15_neon(re, im, n);
+        else      r2_q15_ref(re, im, n);
+    }
+    bitrev_q15(re, im, n);
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE dsp_fft_f32(float *re, float *im, uint32_t n)         { return fft_f32(re, im, n, true); }
+ALT_STATUS_CODE dsp_fft_f32_ref(float *re, float *im, uint32_t n)     { return fft_f32(re, im, n, false); }
+ALT_STATUS_CODE dsp_fft_q15(int16_t *re, int16_t *im, uint32_t n)     { return fft_q15(re, im, n, true); }
+ALT_STATUS_CODE dsp_fft_q15_ref(int16_t *re, int16_t *im, uint32_t n) { return fft_q15(re, im, n, false); }
+
+ALT_STATUS_CODE dsp_ifft_f32(float *re, float *im, uint32_t n)
+{
+    // IFFT(x) = swap(FFT(swap(x))) / n: con i piani separati basta scambiarli
+    ALT_STATUS_CODE s = fft_f32(im, re, n, true);
+    if (s == ALT_E_SUCCESS) {
+        dsp_scale_f32(re, re, n, 1.0f / (float)n);
+        dsp_scale_f32(im, im, n, 1.0f / (float)n);
+    }
+    return s;
+}
+
+void dsp_fft_dump(void)
+{
+    fmt_printf("\r\nFFT twiddle: %u byte, stadi L =", s_tw_bytes);
+    for (uint32_t l = DSP_FFT_LOG2_MIN; l <= DSP_FFT_LOG2_MAX; ++l)
+        if (s_tw[l].f) fmt_printf(" %u", 1u << l);
+}
+
+// ---------------------------
+// Benchmark
+// ---------------------------
+static float   *s_bf[6];        // x re/im, ref re/im, neon re/im
+static int16_t *s_bq[4];        // ref re/im, neon re/im
+
+static float fabs_f(float x) { return (x < 0.0f) ? -x : x; }
+
+static float max_abs_diff(const float *a, const float *b, uint32_t n, float scale)
+{
+    float m = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+        float d = fabs_f(a[i] - b[i] * scale);
+        if (d > m) m = d;
+    }
+    return m;
+}
+
+void dsp_fft_bench(uint32_t n)
+{
+    uint32_t lg = 0u;
+    if (fft_log2(n, &lg) != ALT_E_SUCCESS || dsp_fft_prepare(n) != ALT_E_SUCCESS) {
+        fmt_printf("\r\nFFT bench: n=%u non valido o memoria", n);
+        return;
+    }
+    if (!s_bf[0]) {
+        mem_arena_t *a = mem_arena_get(MEM_REGION_DDR);
+        for (uint32_t i = 0; i < 6u; ++i) s_bf[i] = (float *)mem_arena_alloc(a, DSP_FFT_MAX_N * sizeof(float), MEM_POOL_ALIGN);
+        for (uint32_t i = 0; i < 4u; ++i) s_bq[i] = (int16_t *)mem_arena_alloc(a, DSP_FFT_MAX_N * sizeof(int16_t), MEM_POOL_ALIGN);
+        for (uint32_t i = 0; i < 4u; ++i) if (!s_bf[i] || !s_bq[i]) { s_bf[0] = NULL; fmt_printf("\r\nFFT bench: memoria"); return; }
+        if (!s_bf[4] || !s_bf[5]) { s_bf[0] = NULL; fmt_printf("\r\nFFT bench: memoria"); return; }
+    }
+    float *xr = s_bf[0], *xi = s_bf[1], *ar = s_bf[2], *ai = s_bf[3], *br = s_bf[4], *bi = s_bf[5];
+
+    // rumore in [-0.5, 0.5): in Q15 ben dentro il fondo scala
+    uint32_t seed = 0x1234567u;
+    for (uint32_t i = 0; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        xr[i] = ar[i] = br[i] = (float)(int32_t)seed * (0.5f / 2147483648.0f);
+        seed = seed * 1664525u + 1013904223u;
+        xi[i] = ai[i] = bi[i] = (float)(int32_t)seed * (0.5f / 2147483648.0f);
+        s_bq[0][i] = s_bq[2][i] = tw_q15(xr[i]);
+        s_bq[1][i] = s_bq[3][i] = tw_q15(xi[i]);
+    }
+
+    (void)alt_globaltmr_init();
+    uint32_t t0 = alt_globaltmr_counter_get_low32(); (void)dsp_fft_f32_ref(ar, ai, n);
+    uint32_t t1 = alt_globaltmr_counter_get_low32(); (void)dsp_fft_f32(br, bi, n);
+    uint32_t t2 = alt_globaltmr_counter_get_low32(); (void)dsp_fft_q15_ref(s_bq[0], s_bq[1], n);
+    uint32_t t3 = alt_globaltmr_counter_get_low32(); (void)dsp_fft_q15(s_bq[2], s_bq[3], n);
+    uint32_t t4 = alt_globaltmr_counter_get_low32();
+
+    // NEON vs scalare (float: scarto assoluto in milionesimi)
+    float e_nr = max_abs_diff(ar, br, n, 1.0f), e_ni = max_abs_diff(ai, bi, n, 1.0f);
+    uint32_t q_bad = 0u;
+    for (uint32_t i = 0; i < n; ++i) q_bad += (s_bq[0][i] != s_bq[2][i]) + (s_bq[1][i] != s_bq[3][i]);
+
+    // Q15 (scalata 1/n) vs float, in LSB
+    float e_q = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+        float dr = fabs_f((float)s_bq[2][i] - br[i] * (32768.0f / (float)n));
+        float di = fabs_f((float)s_bq[3][i] - bi[i] * (32768.0f / (float)n));
+        if (dr > e_q) e_q = dr;
+        if (di > e_q) e_q = di;
+    }
+
+    // round trip
+    (void)dsp_ifft_f32(br, bi, n);
+    float e_rt = max_abs_diff(xr, br, n, 1.0f);
+    float e_ri = max_abs_diff(xi, bi, n, 1.0f);
+    if (e_ri > e_rt) e_rt = e_ri;
+
+    fmt_printf("\r\nFFT n=%u float: ref %u tick  neon %u tick  x%.2q  scarto %u ppm  round trip %u ppm",
+               n, t1 - t0, t2 - t1, (t2 - t1) ? ((t1 - t0) * 100u) / (t2 - t1) : 0u,
+               (uint32_t)(((e_nr > e_ni) ? e_nr : e_ni) * 1000000.0f), (uint32_t)(e_rt * 1000000.0f));
+    fmt_printf("\r\nFFT n=%u q15:   ref %u tick  neon %u tick  x%.2q  diversi %u  vs float %u LSB",
+               n, t3 - t2, t4 - t3, (t4 - t3) ? ((t3 - t2) * 100u) / (t4 - t3) : 0u,
+               q_bad, (uint32_t)(e_q + 0.5f));
+}
@@ -7,6 +7,7 @@
 #include "arm_pio.h"
 #include "arm_mem_regions.h"
 #include "dma_layout.h"
+#include "fmt_min.h"
 
 extern volatile uint32_t *g_arm_msgdma0_csr;
 extern volatile uint32_t *g_arm_msgdma0_desc;
@@ -18,65 +19,198 @@ extern volatile uint32_t *g_arm_msgdma3_csr;
 extern volatile uint32_t *g_arm_msgdma3_desc;
 extern volatile uint32_t *g_arm_msgdma4_csr;
 extern volatile uint32_t *g_arm_msgdma4_desc;
-
-static volatile uint32_t coef_bank = 0;
-static volatile uint32_t coef_pair_idx = 0;
-
-static volatile uint32_t pulse_bank = 0;
-static volatile uint32_t pulse_pair_idx = 0;
+extern volatile uint32_t *g_arm_prf_counter;
+
+// Ring di slot OCRAM (COEF e PULSE accoppiati, stesso indice su BANK_SEL):
+//   rd                    slot letto dall'FPGA
+//   rd+1 .. rd+queued     accodati (FILLING o READY), in ordine di riempimento
+//   gli altri             liberi
+// Lo toccano solo la ISR del trigger e le ISR mSGDMA: stesso core, mai annidate.
+typedef struct {
+	uint32_t depth;
+	uint32_t channel;                   // geometria degli slot (size del canale)
+	uint32_t rd;
+	uint32_t queued;
+	uint8_t  state[SEQ_RING_MAX];
+	uint32_t pending[SEQ_RING_MAX];     // bit n = mSGDMAn ancora atteso sullo slot
+	uint32_t prf[SEQ_RING_MAX];         // PRF da scrivere quando lo slot va in lettura (0 = invariata)
+	uint32_t gen[SEQ_RING_MAX];         // config con cui è stato riempito (live quando va in lettura)
+} bank_ring_t;
+
+// all'avvio lo slot 1 conta come pronto (contenuto qualsiasi, come prima del tracking)
+static bank_ring_t s_ring = { 2u, 0u, 0u, 1u, { BANK_CONSUMED, BANK_READY }, { 0u }, { 0u }, { 0u } };
+static bank_stats_t s_bank_stats = { .ahead_min = SEQ_RING_MAX };
+static uint32_t s_under_run = 0;
 
 static volatile uint32_t coef_len = 0;
 static volatile uint32_t pulse_len = 0;
 
 volatile uint32_t g_edges = 0;
 
-void fpga_f2h0_isr(uint32_t icciar, void *ctx) {
-	(void)icciar; (void)ctx;
-
-	__asm__ volatile ("cpsie i");   // riapre gli IRQ durante questa ISR
-
-	coef_bank ^= 1u; // toggle BANK_SEL → FPGA legge il banco appena riempito
-	coef_bank_sel(coef_bank);
-	//uint32_t bank_dst_off = (coeff_bank == 0) ? FFT_COEF_OFF_B : FFT_COEF_OFF_A;
+/* Scrive un descrittore precompilato: 4 store, CONTROL (GO) per ultimo */
+static inline void msgdma_push(volatile uint32_t *desc, uint32_t src, const seq_desc_t *d)
+{
+	alt_write_word((void*)(desc + DESCRIPTOR_READ_ADDRESS_REG),     src);
+	alt_write_word((void*)(desc + DESCRIPTOR_WRITE_ADDRESS_REG),    d->dst);
+	alt_write_word((void*)(desc + DESCRIPTOR_LENGTH_REG),           d->len);
+	alt_write_word((void*)(desc + DESCRIPTOR_CONTROL_STANDARD_REG), d->ctrl);
+}
 
-	// size corrente (dipende dal channel)
-	uint32_t fft_size = g_coef_pair_bytes[g_channel];
-	uint32_t coef_dst_off = (coef_bank == 0) ? fft_size : 0u;
+static inline uint32_t ring_slot(const bank_ring_t *r, uint32_t i)
+{
+	uint32_t s = r->rd + i;
+	return (s >= r->depth) ? (s - r->depth) : s;
+}
 
-	coef_pair_idx = (coef_pair_idx + 1u) % COEF_NUM_PAIRS; // coppia successiva
-	uint32_t coef_src = pair_coef_source_addr(coef_pair_idx);
-	uint32_t coef_dst = COEF_DEST_BASE + coef_dst_off;
-	coef_len = coef_len_for_channel(g_channel);  // 64k/128k/256k/512k
+/* Completamenti dell'engine: l'mSGDMA esegue i descrittori in ordine, quindi
+ * sono chiusi i più vecchi tra gli slot che lo attendono, tanti quanti non sono
+ * più in coda. Conta l'hardware, non gli IRQ (che possono accorparsi). */
+static void ring_reap(uint32_t engine)
+{
+	bank_ring_t *r = &s_ring;
+	const uint32_t bit = 1u << engine;
+	uint32_t n = 0u;
+
+	for (uint32_t i = 1; i <= r->queued; ++i)
+		if (r->pending[ring_slot(r, i)] & bit) n++;
+	if (n == 0u) return;
+
+	uint32_t fl = msgdma_in_flight(engine);
+	for (uint32_t i = 1; (i <= r->queued) && (n > fl); ++i) {
+		uint32_t s = ring_slot(r, i);
+		if (!(r->pending[s] & bit)) continue;
+		r->pending[s] &= ~bit;
+		n--;
+		if (r->pending[s] == 0u) r->state[s] = BANK_READY;
+	}
+}
 
+void bank_fill_done(uint32_t engine)
+{
+	ring_reap(engine);
+}
 
-	pulse_bank ^= 1u; // toggle BANK_SEL → FPGA legge il banco appena riempito
-	pulse_bank_sel(pulse_bank);
-	//uint32_t pulse_dst_off = (pulse_bank == 0) ? PULSE_OFF_B : PULSE_OFF_A;
+const bank_stats_t *bank_stats(void)
+{
+	return &s_bank_stats;
+}
 
-	// size corrente (dipende dal channel)
-	uint32_t pulse_size = g_pulse_pair_bytes[g_channel];
-	uint32_t pulse_dst_off = (pulse_bank == 0) ? pulse_size : 0u;
+void bank_ring_recover(void)
+{
+	bank_ring_t *r = &s_ring;
+	uint32_t cpsr = arm_irq_save();   // trigger e ISR mSGDMA di Core0 fuori
+
+	msgdma_stream_reset();
+	// lo slot in lettura resta: l'FPGA lo ripete finché il ring non ha di nuovo un banco pronto
+	s_bank_stats.dropped += r->queued;
+	r->queued = 0u;
+	for (uint32_t s = 0; s < SEQ_RING_MAX; ++s) {
+		r->state[s]   = BANK_CONSUMED;
+		r->pending[s] = 0u;
+	}
+	s_under_run = 0;
+	s_bank_stats.recoveries++;
 
-	pulse_pair_idx = (pulse_pair_idx + 1u) % PULSE_NUM_PAIRS; // coppia successiva
-	uint32_t pulse_src = pair_pulse_source_addr(pulse_pair_idx);
-	uint32_t pulse_dst = PULSE_DEST_BASE + pulse_dst_off;
-	pulse_len = pulse_len_for_channel(g_channel);  // 1k/16k/32k/64k
+	arm_irq_restore(cpsr);
+}
 
-	// --- attende che i due DMA siano liberi ---
-	while (!msgdma_is_idle(g_arm_msgdma0_csr) ||
-	       !msgdma_is_idle(g_arm_msgdma4_csr)) {
-	        ; // busy-wait, assicura sequenzialità
+void fpga_f2h0_isr(uint32_t icciar, void *ctx) {
+	(void)icciar; (void)ctx;
+	bank_ring_t *r = &s_ring;
+
+	// Fronte del trigger = confine di PRI: qui (e solo qui) si applica una nuova config.
+	// Da questo punto la ISR usa solo *cfg, mai i globali.
+	const seq_config_t *cfg = seq_config_latch();
+
+	// completamenti con l'IRQ ancora pendente (qui gli IRQ sono mascherati)
+	for (uint32_t e = 0; e <= MSGDMA_PULSE_ENGINE; ++e) ring_reap(e);
+
+	// 1) lettura avanti solo su uno slot pronto: altrimenti l'FPGA ripete lo slot
+	//    attuale (forma d'onda vecchia ma intera) e l'underrun viene contato
+	uint32_t nx = ring_slot(r, 1u);
+	if (r->queued && r->state[nx] == BANK_READY) {
+		uint32_t ahead = 0u;
+		for (uint32_t i = 1; i <= r->queued; ++i)
+			if (r->state[ring_slot(r, i)] == BANK_READY) ahead++;
+		if (ahead < s_bank_stats.ahead_min) s_bank_stats.ahead_min = ahead;
+
+		r->state[r->rd] = BANK_CONSUMED;   // torna libero
+		r->rd = nx;
+		r->queued--;
+		coef_bank_sel(nx);
+		pulse_bank_sel(nx);
+		if (r->prf[nx]) arm_pio_write(g_arm_prf_counter, r->prf[nx]);
+		seq_config_shown(r->gen[nx]);
+		s_bank_stats.swaps++;
+		s_under_run = 0;
+	} else {
+		s_bank_stats.underruns++;
+		if (r->queued) {
+			if (r->pending[nx] & ~(1u << MSGDMA_PULSE_ENGINE)) s_bank_stats.coef_late++;
+			if (r->pending[nx] &  (1u << MSGDMA_PULSE_ENGINE)) s_bank_stats.pulse_late++;
+		}
+		if (++s_under_run > s_bank_stats.max_run) s_bank_stats.max_run = s_under_run;
 	}
 
-	alt_write_word((void*)(g_arm_msgdma0_desc + DESCRIPTOR_READ_ADDRESS_REG),  coef_src);
-	alt_write_word((void*)(g_arm_msgdma0_desc + DESCRIPTOR_WRITE_ADDRESS_REG), coef_dst);
-	alt_write_word((void*)(g_arm_msgdma0_desc + DESCRIPTOR_LENGTH_REG),        coef_len);
-	alt_write_word((void*)(g_arm_msgdma0_desc + DESCRIPTOR_CONTROL_STANDARD_REG), START_MSGDMA_MASK);
-
-	alt_write_word((void*)(g_arm_msgdma4_desc + DESCRIPTOR_READ_ADDRESS_REG),  pulse_src);
-	alt_write_word((void*)(g_arm_msgdma4_desc + DESCRIPTOR_WRITE_ADDRESS_REG), pulse_dst);
-	alt_write_word((void*)(g_arm_msgdma4_desc + DESCRIPTOR_LENGTH_REG),        pulse_len);
-	alt_write_word((void*)(g_arm_msgdma4_desc + DESCRIPTOR_CONTROL_STANDARD_REG), START_MSGDMA_MASK);
+	// 2) cambio canale = cambio geometria degli slot: si aspetta che i fill in volo
+	//    finiscano, quelli pronti (size vecchia) si scartano e il ring riparte.
+	//    Gli slot scartati hanno passi della config precedente, già consumati da
+	//    seq_config_step: non vengono mostrati (contati in dropped). La nuova config
+	//    riparte dal primo passo (il latch azzera il cursore; keep_cursor lo usano
+	//    solo le ridirezioni, che non cambiano geometria).
+	if (cfg->channel != r->channel || cfg->ring_depth != r->depth) {
+		for (uint32_t i = 1; i <= r->queued; ++i)
+			if (r->state[ring_slot(r, i)] == BANK_FILLING) { g_edges++; return; }
+
+		s_bank_stats.dropped += r->queued;
+		r->depth   = cfg->ring_depth;
+		r->channel = cfg->channel;
+		r->queued  = 0u;
+		if (r->rd >= r->depth) {
+			r->rd = 0u;
+			coef_bank_sel(0u);
+			pulse_bank_sel(0u);
+		}
+		for (uint32_t s = 0; s < SEQ_RING_MAX; ++s) {
+			r->state[s]   = BANK_CONSUMED;
+			r->pending[s] = 0u;
+		}
+		s_bank_stats.rebases++;
+	}
+	s_bank_stats.depth = r->depth;
+
+	// 3) riempie tutti gli slot liberi con i passi successivi (DMA in anticipo di
+	//    depth-1 trigger). Gli IRQ restano mascherati: le ISR mSGDMA non vedono
+	//    mai uno slot marcato prima che i suoi descrittori siano in coda.
+	volatile uint32_t *const coef_eng[MSGDMA_COEF_ENGINES] = {
+		g_arm_msgdma0_desc, g_arm_msgdma1_desc, g_arm_msgdma2_desc, g_arm_msgdma3_desc
+	};
+
+	while (r->queued + 1u < r->depth) {
+		uint32_t prf;
+		const seq_step_t *st = seq_config_step(cfg, &prf);   // sorgenti già calcolate
+		if (!st) break;
+
+		uint32_t slot = ring_slot(r, r->queued + 1u);
+		r->state[slot]   = BANK_FILLING;
+		r->pending[slot] = cfg->coef_eng_mask | (1u << MSGDMA_PULSE_ENGINE);
+		r->prf[slot]     = prf;
+		r->gen[slot]     = cfg->gen;
+		r->queued++;
+
+		// descrittori precompilati alla pubblicazione della config: niente calcoli qui
+		const seq_desc_t *cd = cfg->coef_desc[slot];
+		const seq_desc_t *pd = &cfg->pulse_desc[slot];
+		uint32_t len = 0u;
+		for (uint32_t k = 0; k < cfg->coef_parts; ++k) {
+			msgdma_push(coef_eng[cfg->coef_eng[k]], st->coef_src + cd[k].src, &cd[k]);
+			len += cd[k].len;
+		}
+		msgdma_push(g_arm_msgdma4_desc, st->pulse_src + pd->src, pd);
+
+		coef_len  = len;
+		pulse_len = pd->len;
+	}
 
 	g_edges++;
 	//gic_eoi(IRQ_ID_F2H0_0);
@@ -87,10 +221,15 @@ void fpga_f2h0_isr(uint32_t icciar, void *ctx) {
 
 void stampa_f2h(void)
 {
-	double freq = 0.0;
-
-	freq = g_edges/500.0;
-	printf("\n\n\rFFT Pulse Ref. %ld kB - Pulse Tx Buff. %ld kB", coef_len/1024,pulse_len/1024);
-	printf("\n\rFrequency F2H interrupt signal = %.2f kHz",freq);
+	// g_edges contati in 500 ms -> kHz con 2 decimali = g_edges / 5 (centesimi di kHz)
+	uint32_t freq_centi_khz = g_edges / 5u;
+
+	fmt_printf("\n\n\rFFT Pulse Ref. %lu kB - Pulse Tx Buff. %lu kB", coef_len/1024,pulse_len/1024);
+	fmt_printf("\n\rFrequency F2H interrupt signal = %.2q kHz",freq_centi_khz);
+	fmt_printf("\n\rConfig live: gen %u ch %u", seq_config_live_gen(), g_channel);
+	fmt_printf("\n\rBank ring %u slot: swap %u, underrun %u (COEF %u PULSE %u, max %u di fila), anticipo min %u, ripristini %u, passi scartati %u",
+	           s_bank_stats.depth, s_bank_stats.swaps, s_bank_stats.underruns, s_bank_stats.coef_late,
+	           s_bank_stats.pulse_late, s_bank_stats.max_run, s_bank_stats.ahead_min, s_bank_stats.recoveries,
+	           s_bank_stats.dropped);
 	g_edges=0;
 }
@@ -0,0 +1,224 @@
+// fmt_min.c
+// Formatter intero minimale (vedi fmt_min.h). Nessuno stato globale: ogni
+// chiamata lavora solo sul buffer del chiamante, quindi è usabile anche da ISR.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include "fmt_min.h"
+#include "uart_stdio.h"
+#include "alt_printf.h"
+#include "alt_globaltmr.h"
+
+typedef struct {
+    char   *buf;
+    size_t  size;   // capacità totale (incluso '\0')
+    size_t  pos;    // caratteri prodotti (anche oltre size: serve per il ritorno)
+} fmt_out_t;
+
+static inline void out_ch(fmt_out_t *o, char c)
+{
+    if (o->pos + 1u < o->size) o->buf[o->pos] = c;
+    o->pos++;
+}
+
+static inline void out_pad(fmt_out_t *o, char c, int n)
+{
+    while (n-- > 0) out_ch(o, c);
+}
+
+/* q = n / 10, r = n % 10 senza divisione (UMULL, esatto per tutto uint32) */
+static inline uint32_t div10(uint32_t n, uint32_t *r)
+{
+    uint32_t q = (uint32_t)(((uint64_t)n * 0xCCCCCCCDu) >> 35);
+    *r = n - q * 10u;
+    return q;
+}
+
+/* Converte in cifre (ordine inverso) dentro tmp; ritorna il numero di cifre */
+static int utoa_rev(uint32_t v, char *tmp, bool hex, bool upper)
+{
+    int n = 0;
+    if (hex) {
+        const char *dig = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+        do { tmp[n++] = dig[v & 0xFu]; v >>= 4; } while (v);
+    } else {
+        do { uint32_t r; v = div10(v, &r); tmp[n++] = (char)('0' + r); } while (v);
+    }
+    return n;
+}
+
+/* Emissione di un campo numerico con segno/padding; frac = cifre dopo il punto (%q) */
+static void out_number(fmt_out_t *o, uint32_t mag, bool neg, bool hex, bool upper,
+                       int width, bool left, bool zero, int frac)
+{
+    char tmp[12];
+    int nd = utoa_rev(mag, tmp, hex, upper);
+
+    // per %q servono almeno frac+1 cifre (es. 5 con .2 -> "0.05")
+    while (frac > 0 && nd < frac + 1 && nd < (int)sizeof(tmp)) tmp[nd++] = '0';
+
+    int len = nd + (neg ? 1 : 0) + ((frac > 0) ? 1 : 0);
+    int pad = (width > len) ? (width - len) : 0;
+
+    if (!left && !zero) out_pad(o, ' ', pad);
+    if (neg) out_ch(o, '-');
+    if (!left && zero) out_pad(o, '0', pad);
+
+    for (int i = nd - 1; i >= 0; --i) {
+        out_ch(o, tmp[i]);
+        if (frac > 0 && i == frac) out_ch(o, '.');
+    }
+
+    if (left) out_pad(o, ' ', pad);
+}
+
+int fmt_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+    fmt_out_t o = { .buf = buf, .size = (buf ? size : 0u), .pos = 0u };
+
+    while (*fmt) {
+        char c = *fmt++;
+        if (c != '%') { out_ch(&o, c); continue; }
+
+        bool left = false, zero = false;
+        int  width = 0, prec = -1;
+
+        // flag
+        for (;; ++fmt) {
+            if (*fmt == '-') left = true;
+            else if (*fmt == '0') zero = true;
+            else break;
+        }
+        // larghezza
+        if (*fmt == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) { left = true; width = -width; }
+            ++fmt;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+        }
+        // precisione
+        if (*fmt == '.') {
+            ++fmt;
+            prec = 0;
+            if (*fmt == '*') { prec = va_arg(ap, int); ++fmt; if (prec < 0) prec = -1; }
+            else while (*fmt >= '0' && *fmt <= '9') prec = prec * 10 + (*fmt++ - '0');
+        }
+        // modificatori di lunghezza (32 bit ovunque)
+        if (*fmt == 'l' && fmt[1] == 'l') { out_ch(&o, '?'); break; }
+        if (*fmt == 'j')                  { out_ch(&o, '?'); break; }
+        while (*fmt == 'h' || *fmt == 'l' || *fmt == 'z' || *fmt == 't') ++fmt;
+
+        c = *fmt;
+        if (c == '\0') break;
+        ++fmt;
+
+        switch (c) {
+        case 'd': case 'i': {
+            int32_t v = va_arg(ap, int32_t);
+            bool neg = (v < 0);
+            uint32_t mag = neg ? (0u - (uint32_t)v) : (uint32_t)v;
+            out_number(&o, mag, neg, false, false, width, left, zero, 0);
+            break;
+        }
+        case 'u':
+            out_number(&o, va_arg(ap, uint32_t), false, false, false, width, left, zero, 0);
+            break;
+        case 'x': case 'X':
+            out_number(&o, va_arg(ap, uint32_t), false, true, (c == 'X'), width, left, zero, 0);
+            break;
+        case 'p':
+            out_ch(&o, '0'); out_ch(&o, 'x');
+            out_number(&o, (uint32_t)(uintptr_t)va_arg(ap, void *), false, true, false, 8, false, true, 0);
+            break;
+        case 'q': {
+            int32_t v = va_arg(ap, int32_t);
+            bool neg = (v < 0);
+            uint32_t mag = neg ? (0u - (uint32_t)v) : (uint32_t)v;
+            int frac = (prec < 0) ? 0 : ((prec > 9) ? 9 : prec);
+            out_number(&o, mag, neg, false, false, width, left, zero, frac);
+            break;
+        }
+        case 'c': {
+            char ch = (char)va_arg(ap, int);
+            if (!left) out_pad(&o, ' ', width - 1);
+            out_ch(&o, ch);
+            if (left) out_pad(&o, ' ', width - 1);
+            break;
+        }
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            if (!s) s = "(null)";
+            int len = 0;
+            while (s[len] && (prec < 0 || len < prec)) ++len;
+            if (!left) out_pad(&o, ' ', width - len);
+            for (int i = 0; i < len; ++i) out_ch(&o, s[i]);
+            if (left) out_pad(&o, ' ', width - len);
+            break;
+        }
+        case '%':
+            out_ch(&o, '%');
+            break;
+        default:
+            // conversione sconosciuta: la riportiamo così com'è
+            out_ch(&o, '%');
+            out_ch(&o, c);
+            break;
+        }
+    }
+
+    if (o.size) o.buf[(o.pos < o.size) ? o.pos : (o.size - 1u)] = '\0';
+    return (int)o.pos;
+}
+
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int rc = fmt_vsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return rc;
+}
+
+int fmt_vprintf(const char *fmt, va_list ap)
+{
+    char line[FMT_MIN_LINE_MAX];
+    int rc = fmt_vsnprintf(line, sizeof(line), fmt, ap);
+    if (uart_stdio_write_string(line) != ALT_E_SUCCESS) return -1;
+    return rc;
+}
+
+int fmt_printf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int rc = fmt_vprintf(fmt, ap);
+    va_end(ap);
+    return rc;
+}
+
+// ---------------------------
+// Benchmark vs alt_printf
+// ---------------------------
+#define FMT_BENCH_LOOPS  1000u
+
+void fmt_min_bench(void)
+{
+    char buf[64];
+    uint32_t i;
+
+    (void)alt_globaltmr_init();   // avvia il contatore a 64 bit (PERIPHCLK)
+
+    uint64_t t0 = alt_globaltmr_get64();
+    for (i = 0; i < FMT_BENCH_LOOPS; ++i)
+        (void)fmt_snprintf(buf, sizeof(buf), "ch=%u idx=%4d addr=0x%08X", i & 3u, (int)i, 0x40000000u + i);
+    uint64_t t1 = alt_globaltmr_get64();
+    for (i = 0; i < FMT_BENCH_LOOPS; ++i)
+        (void)alt_snprintf(buf, sizeof(buf), "ch=%u idx=%4d addr=0x%08X", i & 3u, (int)i, 0x40000000u + i);
+    uint64_t t2 = alt_globaltmr_get64();
+
+    fmt_printf("\r\nfmt_min bench (%u loop): fmt_snprintf=%u tick, alt_snprintf=%u tick",
+               FMT_BENCH_LOOPS, (uint32_t)(t1 - t0), (uint32_t)(t2 - t1));
+}
@@ -2,6 +2,117 @@
 #include "alt_bridge_manager.h"
 #include "interrupts.h"
 #include "timers.h"
+#include "f2h_interrupts.h"
+#include "fmt_min.h"
+#include "irq_stats.h"
+
+// ---------------------------
+// Affinità / priorità
+// ---------------------------
+static irq_route_t s_route[] = {
+    { IRQ_ID_F2H0_0,                        IRQ_CPU0,            0x60u, ALT_INT_TRIGGER_EDGE },      // trigger: unico IRQ RT di Core0
+    { IRQ_ID_F2H0_1,                        IRQ_MSGDMA_CPU,      0x30u, ALT_INT_TRIGGER_LEVEL },     // mSGDMA0..3 (COEF)
+    { IRQ_ID_F2H0_2,                        IRQ_MSGDMA_CPU,      0x30u, ALT_INT_TRIGGER_LEVEL },
+    { IRQ_ID_F2H0_3,                        IRQ_MSGDMA_CPU,      0x30u, ALT_INT_TRIGGER_LEVEL },
+    { IRQ_ID_F2H0_4,                        IRQ_MSGDMA_CPU,      0x30u, ALT_INT_TRIGGER_LEVEL },
+    { IRQ_ID_F2H0_5,                        IRQ_MSGDMA_CPU,      0x20u, ALT_INT_TRIGGER_LEVEL },     // mSGDMA4 (PULSE)
+    { ALT_INT_INTERRUPT_PPI_TIMER_PRIVATE,  IRQ_CPU0 | IRQ_CPU1, 0xA0u, ALT_INT_TRIGGER_LEVEL },     // banked: ognuno il suo
+    { ALT_INT_INTERRUPT_DMA_IRQ0,           IRQ_CPU0,            0x90u, ALT_INT_TRIGGER_LEVEL },     // PL330 thread 0..3 (dma_copy Core0)
+    { ALT_INT_INTERRUPT_DMA_IRQ1,           IRQ_CPU0,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    { ALT_INT_INTERRUPT_DMA_IRQ2,           IRQ_CPU0,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    { ALT_INT_INTERRUPT_DMA_IRQ3,           IRQ_CPU0,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    { ALT_INT_INTERRUPT_DMA_IRQ4,           IRQ_CPU1,            0x90u, ALT_INT_TRIGGER_LEVEL },     // PL330 thread 4..7 (dma_copy Core1)
+    { ALT_INT_INTERRUPT_DMA_IRQ5,           IRQ_CPU1,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    { ALT_INT_INTERRUPT_DMA_IRQ6,           IRQ_CPU1,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    { ALT_INT_INTERRUPT_DMA_IRQ7,           IRQ_CPU1,            0x90u, ALT_INT_TRIGGER_LEVEL },
+    // UART1 (console): uart_stdio è in polling su entrambi i core, nessun IRQ da instradare
+    { ALT_INT_INTERRUPT_SGI1,               IRQ_CPU0 | IRQ_CPU1, 0x80u, ALT_INT_TRIGGER_SOFTWARE },  // doorbell (banked)
+    { ALT_INT_INTERRUPT_WDOG0_IRQ,          IRQ_CPU0,            0x50u, ALT_INT_TRIGGER_LEVEL },     // preallarme watchdog (wdog_mgr)
+};
+
+#define ROUTE_QTY  (sizeof(s_route) / sizeof(s_route[0]))
+
+static irq_route_t *route_find(ALT_INT_INTERRUPT_t int_id)
+{
+    for (uint32_t i = 0; i < ROUTE_QTY; ++i)
+        if (s_route[i].id == (uint16_t)int_id) return &s_route[i];
+    return NULL;
+}
+
+uint32_t hps_int_affinity(ALT_INT_INTERRUPT_t int_id)
+{
+    // SPI: fa fede il distributor, comune ai due core (la tabella è per-immagine)
+    if ((uint32_t)int_id >= 32u && (uint32_t)int_id < ALT_INT_PROVISION_INT_COUNT) {
+        uint32_t t = alt_read_byte((void *)(uintptr_t)GICD_ITARGETSR(int_id)) & (IRQ_CPU0 | IRQ_CPU1);
+        if (t) return t;                           // 0: non ancora instradata (prima di hps_int_routes_apply)
+    }
+    const irq_route_t *r = route_find(int_id);
+    return r ? r->cpu : IRQ_CPU0;
+}
+
+uint32_t hps_int_priority(ALT_INT_INTERRUPT_t int_id)
+{
+    const irq_route_t *r = route_find(int_id);
+    return r ? r->prio : IRQ_PRIO_DEFAULT;
+}
+
+/* Cambia il core di una linea già elencata. Il target nel distributor è
+ * comune ai due core; la tabella è per-core (compilata uguale nei due) e qui
+ * si aggiorna solo quella di Core0. Core1 vede il nuovo target tramite
+ * hps_int_affinity. Su Core1 non è disponibile: alt_int_dist_trigger_set vuole
+ * lo stato di hwlib che solo Core0 inizializza. */
+ALT_STATUS_CODE hps_int_affinity_set(ALT_INT_INTERRUPT_t int_id, uint32_t cpu_mask)
+{
+#if defined(CORE1)
+    (void)int_id; (void)cpu_mask;
+    return ALT_E_BAD_OPERATION;
+#else
+    irq_route_t *r = route_find(int_id);
+    if (!r) return ALT_E_BAD_ARG;
+    if ((cpu_mask & (IRQ_CPU0 | IRQ_CPU1)) == 0u || (cpu_mask & ~(IRQ_CPU0 | IRQ_CPU1))) return ALT_E_ARG_RANGE;
+
+    r->cpu = (uint8_t)cpu_mask;
+    if (int_id >= 32) {
+        // ICFGR lo scrive solo Core0 (vedi hps_int_routes_apply)
+        if (cpu_mask & IRQ_CPU1) {
+            ALT_STATUS_CODE status = alt_int_dist_trigger_set(int_id, (ALT_INT_TRIGGER_t)r->trig);
+            if (status != ALT_E_SUCCESS) return status;
+        }
+        alt_write_byte((void *)(uintptr_t)GICD_ITARGETSR(int_id), (uint8_t)cpu_mask);
+    }
+    __asm__ volatile("dsb sy" ::: "memory");
+    return ALT_E_SUCCESS;
+#endif
+}
+
+ALT_STATUS_CODE hps_int_routes_apply(void)
+{
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+
+    for (uint32_t i = 0; (status == ALT_E_SUCCESS) && (i < ROUTE_QTY); ++i) {
+        const irq_route_t *r = &s_route[i];
+        ALT_INT_INTERRUPT_t id = (ALT_INT_INTERRUPT_t)r->id;
+
+        if (r->id < 32u) {
+            // PPI banked: qui vale solo per Core0, Core1 la programma in hps_core1_int_start
+            if (r->cpu & IRQ_CPU0) status = alt_int_dist_priority_set(id, r->prio);
+            continue;
+        }
+        status = alt_int_dist_priority_set(id, r->prio);
+        if (status == ALT_E_SUCCESS) status = alt_int_dist_target_set(id, r->cpu);
+        /* ICFGR: 16 linee per registro, condiviso fra i core. Le SPI di Core1
+         * le configura Core0 qui, prima di avviarlo: niente RMW concorrenti. */
+        if ((status == ALT_E_SUCCESS) && (r->cpu & IRQ_CPU1))
+            status = alt_int_dist_trigger_set(id, (ALT_INT_TRIGGER_t)r->trig);
+    }
+    return status;
+}
+
+void hps_int_routes_dump(void)
+{
+    for (uint32_t i = 0; i < ROUTE_QTY; ++i)
+        fmt_printf("\r\nIRQ %u -> cpu 0x%x prio 0x%02X", s_route[i].id, s_route[i].cpu, s_route[i].prio);
+}
 
 void gic_eoi(uint32_t irq_id)
 {
@@ -37,6 +148,9 @@ ALT_STATUS_CODE hps_core0_int_start(ALT_INT_INTERRUPT_t int_id,
 {
     ALT_STATUS_CODE status = ALT_E_SUCCESS;
 
+    /* linea assegnata a Core1: non la si accende qui */
+    if ((int_id >= 32) && !(hps_int_affinity(int_id) & IRQ_CPU0)) return ALT_E_BAD_OPERATION;
+
     /* Disabilita la sola linea mentre la configuri */
     if (status == ALT_E_SUCCESS) status = alt_int_dist_disable(int_id);
     /* Pulisci eventuali pending “sporchi” sulla linea */
@@ -46,13 +160,11 @@ ALT_STATUS_CODE hps_core0_int_start(ALT_INT_INTERRUPT_t int_id,
 
     /* Edge-triggered */
     if (status == ALT_E_SUCCESS) status = alt_int_dist_trigger_set(int_id, trigger);
-    /* set priorità */
-    if (status == ALT_E_SUCCESS) status = alt_int_dist_priority_set(int_id, 0x80);
-
+    /* set priorità (tabella di routing) */
+    if (status == ALT_E_SUCCESS) status = alt_int_dist_priority_set(int_id, hps_int_priority(int_id));
 
     if ((status == ALT_E_SUCCESS) && (int_id >= 32)) {
-        int target = 0x1; /* 1 = CPU0, 2=CPU1 */
-        status = alt_int_dist_target_set(int_id, target);
+        status = alt_int_dist_target_set(int_id, hps_int_affinity(int_id));
     }
 
     /* Enable the distributor, CPU, and global interrupt */
@@ -81,13 +193,29 @@ void hps_core0_int_stop(ALT_INT_INTERRUPT_t int_id)
 
 
 
+// ---------------------------
+// Core1: distributor a registri + tabella di dispatch
+// ---------------------------
+typedef struct {
+    alt_int_callback_t cb;
+    void              *ctx;
+} core1_isr_t;
+
+static core1_isr_t      s_core1_isr[ALT_INT_PROVISION_INT_COUNT];
+static core1_irq_stats_t s_core1_stats;
+static volatile bool     s_core1_nest = true;
+
 /* Initializes and enables the interrupt controller */
 ALT_STATUS_CODE hps_core1_int_start(ALT_INT_INTERRUPT_t int_id,
                                       alt_int_callback_t callback,
                                       void *context,
                                       ALT_INT_TRIGGER_t trigger)
 {
-    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+    uint32_t id = (uint32_t)int_id;
+
+    if (id >= ALT_INT_PROVISION_INT_COUNT || !callback) return ALT_E_BAD_ARG;
+    if ((id >= 32u) && !(hps_int_affinity(int_id) & IRQ_CPU1)) return ALT_E_BAD_OPERATION;
+    if ((id < 16u) && (trigger != ALT_INT_TRIGGER_SOFTWARE)) return ALT_E_BAD_ARG;
 
     // CPU interface: accetta tutto, nessun pre-split, enable IF
 	alt_write_word((void*)(uintptr_t)GICC_PMR, 0xFF);
@@ -95,36 +223,146 @@ ALT_STATUS_CODE hps_core1_int_start(ALT_INT_INTERRUPT_t int_id,
 	alt_write_word((void*)(uintptr_t)GICC_CTLR, 0x1);
      __asm__ volatile("dsb sy; isb");
 
-     uint32_t bitpair = (int_id % 16u) * 2u;
-     uint32_t v = alt_read_word((void*)(uintptr_t)GICD_ICDICFR1);
-     v &= ~(3u << bitpair);                 /* default LEVEL = 00b */
-
-     switch (trigger) {
-     	 case ALT_INT_TRIGGER_LEVEL:
-     		 /* già 00b */
-     		 break;
-     	 case ALT_INT_TRIGGER_EDGE:
-     		 v |= (2u << bitpair);          /* EDGE = 10b */
-     		 break;
-     	 case ALT_INT_TRIGGER_SOFTWARE:
-     		 /* valido SOLO per SGI (0..15); non c’è nulla da settare in ICFGR */
-     		 if (int_id > 15u) return -2;
-     		 break;
-     	 case ALT_INT_TRIGGER_AUTODETECT:
-     		 /* Se vuoi “auto”: tipicamente usi LEVEL di default */
-     		 break;
-     	 default:
-     		 return -3;
-	}
-    alt_write_word((void*)(uintptr_t)GICD_ICDICFR1, v);
-    alt_write_word((void*)(uintptr_t)GICD_ICDISER1, (1u << int_id)); //abilita la linea di interrupt
+    /* linea spenta mentre la configuri */
+    alt_write_word((void*)(uintptr_t)GICD_ICENABLER(id), (1u << (id % 32u)));
+    __asm__ volatile("dsb sy" ::: "memory");
+
+    if (id >= 32u) {
+        /* SPI: ICFGR è condiviso con Core0, che l'ha già scritto dalla tabella
+         * (hps_int_routes_apply). Qui solo il controllo, nessuna scrittura. */
+        uint32_t cfg = (alt_read_word((void*)(uintptr_t)GICD_ICFGR(id)) >> ((id % 16u) * 2u)) & 2u;
+
+        if (trigger == ALT_INT_TRIGGER_SOFTWARE) return ALT_E_BAD_ARG;
+        if ((trigger == ALT_INT_TRIGGER_EDGE  && cfg == 0u) ||
+            (trigger == ALT_INT_TRIGGER_LEVEL && cfg != 0u)) return ALT_E_BAD_OPERATION;
+    } else if (id >= 16u) {
+        /* PPI: ICFGR banked per CPU, la RMW tocca solo la copia di Core1 */
+        uint32_t bitpair = (id % 16u) * 2u;
+        uint32_t v = alt_read_word((void*)(uintptr_t)GICD_ICFGR(id));
+        v &= ~(3u << bitpair);                 /* default LEVEL = 00b */
+
+        switch (trigger) {
+            case ALT_INT_TRIGGER_LEVEL:
+                /* già 00b */
+                break;
+            case ALT_INT_TRIGGER_EDGE:
+                v |= (2u << bitpair);          /* EDGE = 10b */
+                break;
+            case ALT_INT_TRIGGER_AUTODETECT:
+                /* Se vuoi “auto”: tipicamente usi LEVEL di default */
+                break;
+            default:
+                /* SOFTWARE valido SOLO per SGI (0..15) */
+                return ALT_E_BAD_ARG;
+        }
+        /* ICFGR delle PPI è read-only su alcune implementazioni: la scrittura è innocua */
+        alt_write_word((void*)(uintptr_t)GICD_ICFGR(id), v);
+    }
+    /* SGI (0..15): nessun ICFGR, l'enable è banked e sempre attivo su A9 */
+
+    alt_write_byte((void*)(uintptr_t)GICD_IPRIORITYR(id), (uint8_t)hps_int_priority(int_id));
+    if (id >= 32u) {
+        alt_write_byte((void*)(uintptr_t)GICD_ITARGETSR(id), (uint8_t)IRQ_CPU1);
+        alt_write_word((void*)(uintptr_t)GICD_ICPENDR(id), (1u << (id % 32u)));   // pending "sporchi"
+    }
+
+    uint32_t cpsr = arm_irq_save();
+    s_core1_isr[id].ctx = context;
+    s_core1_isr[id].cb  = callback;
+    arm_irq_restore(cpsr);
+
+    alt_write_word((void*)(uintptr_t)GICD_ISENABLER(id), (1u << (id % 32u))); //abilita la linea di interrupt
 
     __asm__ volatile("dsb sy; isb");
 
-    return status;
+    return ALT_E_SUCCESS;
+}
+
+
+void hps_core1_int_stop(ALT_INT_INTERRUPT_t int_id)
+{
+    uint32_t id = (uint32_t)int_id;
+    if (id >= ALT_INT_PROVISION_INT_COUNT) return;
+
+    alt_write_word((void*)(uintptr_t)GICD_ICENABLER(id), (1u << (id % 32u)));
+    __asm__ volatile("dsb sy" ::: "memory");
+
+    uint32_t cpsr = arm_irq_save();
+    s_core1_isr[id].cb  = NULL;
+    s_core1_isr[id].ctx = NULL;
+    arm_irq_restore(cpsr);
+}
+
+ALT_STATUS_CODE hps_core1_int_priority_set(ALT_INT_INTERRUPT_t int_id, uint32_t prio)
+{
+    uint32_t id = (uint32_t)int_id;
+    if (id >= ALT_INT_PROVISION_INT_COUNT || prio > 0xFFu) return ALT_E_BAD_ARG;
+
+    alt_write_byte((void*)(uintptr_t)GICD_IPRIORITYR(id), (uint8_t)prio);
+    __asm__ volatile("dsb sy" ::: "memory");
+    return ALT_E_SUCCESS;
+}
+
+void hps_core1_int_nesting_set(bool enable)
+{
+    s_core1_nest = enable;
+}
+
+uint32_t hps_core1_int_count(ALT_INT_INTERRUPT_t int_id)
+{
+    const irq_stat_t *q = irq_stats_get(int_id);
+    return q ? q->count : 0u;
+}
+
+const core1_irq_stats_t *hps_core1_int_stats(void)
+{
+    return &s_core1_stats;
 }
 
+void hps_core1_int_dump(void)
+{
+    fmt_printf("\r\n[CORE1] IRQ spurie %u senza handler %u annidamento max %u recuperate %u",
+               s_core1_stats.spurious, s_core1_stats.unhandled, s_core1_stats.nest_max,
+               s_core1_stats.recovered);
+    irq_stats_dump();
+}
+
+/* Il reset di CPU1 non tocca il GIC: una linea in servizio quando Core1 si è
+ * bloccato resta attiva e non verrebbe più consegnata (es. il timer privato).
+ * L'EOI con il suo ID la chiude; le SGI attive vengono da Core0 (sorgente 0). */
+void hps_core1_int_recover(void)
+{
+    alt_write_word((void*)(uintptr_t)GICC_CTLR, 0x1);
+    __asm__ volatile("dsb sy; isb");
+
+    // linee attive di CPU1: con il nesting possono essere più d'una, una per livello di priorità
+    uint16_t act_id[32];
+    uint32_t n = 0u;
+    for (uint32_t base = 0; base < ALT_INT_PROVISION_INT_COUNT; base += 32u) {
+        uint32_t act = alt_read_word((void*)(uintptr_t)GICD_ISACTIVER(base));
+        for (uint32_t b = 0; act && (b < 32u); ++b, act >>= 1) {
+            uint32_t id = base + b;
+            if (!(act & 1u)) continue;
+            if ((id >= 32u) && !(alt_read_byte((void*)(uintptr_t)GICD_ITARGETSR(id)) & IRQ_CPU1)) continue;
+            if (n < 32u) act_id[n++] = (uint16_t)id;
+        }
+    }
 
+    // GICv1: EOI in ordine inverso all'acknowledge, cioè dalla più urgente (annidata per ultima)
+    while (n) {
+        uint32_t best = 0u;
+        for (uint32_t i = 1; i < n; ++i)
+            if (alt_read_byte((void*)(uintptr_t)GICD_IPRIORITYR(act_id[i])) <
+                alt_read_byte((void*)(uintptr_t)GICD_IPRIORITYR(act_id[best]))) best = i;
+        gic_eoi(act_id[best]);
+        act_id[best] = act_id[--n];
+        s_core1_stats.recovered++;
+    }
+}
+
+/* Chiamata da core1_irq_entry in SVC con IRQ mascherati. Con il nesting la
+ * callback gira con I=0: il GIC lascia passare solo priorità più alte di
+ * quella della linea in servizio, che resta attiva fino all'EOI. */
 void core1_irq_handler_c(void) //vedi core1_vectors.S
 {
     uint32_t iar   = alt_read_word((void*)(uintptr_t)GICC_IAR);
@@ -132,16 +370,33 @@ void core1_irq_handler_c(void) //vedi core1_vectors.S
 
     // Spurious?
     if (intid >= 1020u) {
-    	gic_eoi(iar);
-        return;
+        s_core1_stats.spurious++;
+        return;                         // niente EOI per 1020..1023
     }
 
-    switch(intid) {
-    	case ALT_INT_INTERRUPT_PPI_TIMER_PRIVATE:
-    		core1_timer_int_callback(iar, NULL);
-		break;
+    if (intid >= ALT_INT_PROVISION_INT_COUNT || !s_core1_isr[intid].cb) {
+        // linea accesa senza handler: spenta, altrimenti un livello alto la ripete all'infinito
+        s_core1_stats.unhandled++;
+        if ((intid < ALT_INT_PROVISION_INT_COUNT) && (intid >= 16u))
+            alt_write_word((void*)(uintptr_t)GICD_ICENABLER(intid), (1u << (intid % 32u)));
+        gic_eoi(iar);
+        return;
     }
 
+    const core1_isr_t h = s_core1_isr[intid];
+    uint32_t t0 = irq_stats_enter(intid);     // conta, misura, eventuale storm
+
+    if (s_core1_nest) {
+        uint32_t d = ++s_core1_stats.nest_depth;
+        if (d > s_core1_stats.nest_max) s_core1_stats.nest_max = d;
+        __asm__ volatile("cpsie i" ::: "memory");
+        h.cb(iar, h.ctx);
+        __asm__ volatile("cpsid i" ::: "memory");
+        s_core1_stats.nest_depth--;
+    } else {
+        h.cb(iar, h.ctx);
+    }
+    irq_stats_exit(intid, t0);
 
     // EOI: sempre con l’IAR originale
     gic_eoi(iar);
@@ -0,0 +1,146 @@
+// irq_stats.c
+// Contatori/tempi per ID di interrupt e limitatore di storm nel percorso di dispatch.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "alt_clock_manager.h"
+#include "alt_globaltmr.h"
+#include "trace_log.h"
+#include "socal/socal.h"
+#include "irq_stats.h"
+#include "interrupts.h"
+#include "f2h_interrupts.h"
+#include "fmt_min.h"
+
+static irq_stat_t s_irq[ALT_INT_PROVISION_INT_COUNT];
+static uint32_t   s_win_ticks = 1000u;     // ricalcolato in irq_stats_init
+static bool       s_init;
+
+static inline uint32_t irq_now(void)
+{
+    return alt_globaltmr_counter_get_low32();
+}
+
+ALT_STATUS_CODE irq_stats_init(void)
+{
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+    uint32_t freq = 0u;
+
+#if !defined(CORE1)
+    // il global timer è uno per i due core: lo accende Core0
+    if (status == ALT_E_SUCCESS) status = alt_globaltmr_init();
+#endif
+    if (status == ALT_E_SUCCESS) status = alt_clk_freq_get(ALT_CLK_MPU_PERIPH, &freq);
+    if (status == ALT_E_SUCCESS) s_win_ticks = (freq / 1000u) * IRQ_STATS_WINDOW_MS;
+
+    uint32_t cpsr = arm_irq_save();
+    memset(s_irq, 0, sizeof(s_irq));
+    for (uint32_t i = 0; i < ALT_INT_PROVISION_INT_COUNT; ++i) s_irq[i].limit = IRQ_STATS_STORM_DEFAULT;
+    // il trigger è la linea RT da proteggere: un burst sopra la PRF massima non la deve spegnere
+    s_irq[IRQ_ID_F2H0_0].limit = 0u;
+    s_init = true;
+    arm_irq_restore(cpsr);
+
+    return status;
+}
+
+uint32_t irq_stats_enter(uint32_t int_id)
+{
+    uint32_t now = irq_now();
+    if (!s_init || int_id >= ALT_INT_PROVISION_INT_COUNT) return now;
+
+    irq_stat_t *q = &s_irq[int_id];
+    q->count++;
+
+    if ((uint32_t)(now - q->win_start) >= s_win_ticks) {
+        q->win_start = now;
+        q->win_count = 0u;
+    }
+    if (++q->win_count > q->limit && q->limit && !q->masked) {
+        // storm: fuori la linea, la segnalazione la fa il task
+        alt_write_word((void *)(uintptr_t)GICD_ICENABLER(int_id), (1u << (int_id % 32u)));
+        q->masked   = 1u;
+        q->reported = 0u;
+        q->storms++;
+        trace_log(TRACE_IRQ_STORM, int_id);
+    }
+    return now;
+}
+
+void irq_stats_exit(uint32_t int_id, uint32_t t0)
+{
+    if (!s_init || int_id >= ALT_INT_PROVISION_INT_COUNT) return;
+
+    irq_stat_t *q = &s_irq[int_id];
+    uint32_t dt = irq_now() - t0;
+    q->t_total += dt;
+    if (dt > q->t_max) q->t_max = dt;
+}
+
+ALT_STATUS_CODE irq_stats_limit_set(ALT_INT_INTERRUPT_t int_id, uint32_t per_window)
+{
+    if ((uint32_t)int_id >= ALT_INT_PROVISION_INT_COUNT) return ALT_E_BAD_ARG;
+    s_irq[int_id].limit = per_window;
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE irq_stats_rearm(ALT_INT_INTERRUPT_t int_id)
+{
+    uint32_t id = (uint32_t)int_id;
+    if (id >= ALT_INT_PROVISION_INT_COUNT) return ALT_E_BAD_ARG;
+
+    uint32_t cpsr = arm_irq_save();
+    irq_stat_t *q = &s_irq[id];
+    bool was = q->masked;
+    q->masked    = 0u;
+    q->win_count = 0u;
+    q->win_start = irq_now();
+    if (was) alt_write_word((void *)(uintptr_t)GICD_ISENABLER(id), (1u << (id % 32u)));
+    arm_irq_restore(cpsr);
+
+    return was ? ALT_E_SUCCESS : ALT_E_BAD_OPERATION;
+}
+
+const irq_stat_t *irq_stats_get(ALT_INT_INTERRUPT_t int_id)
+{
+    return ((uint32_t)int_id < ALT_INT_PROVISION_INT_COUNT) ? &s_irq[int_id] : NULL;
+}
+
+void irq_stats_clear(void)
+{
+    uint32_t cpsr = arm_irq_save();
+    for (uint32_t i = 0; i < ALT_INT_PROVISION_INT_COUNT; ++i) {
+        s_irq[i].count   = 0u;
+        s_irq[i].t_max   = 0u;
+        s_irq[i].t_total = 0u;
+    }
+    arm_irq_restore(cpsr);
+}
+
+void irq_stats_report(void)
+{
+    for (uint32_t i = 0; i < ALT_INT_PROVISION_INT_COUNT; ++i) {
+        irq_stat_t *q = &s_irq[i];
+        if (!q->masked || q->reported) continue;
+        q->reported = 1u;
+#if defined(CORE1)
+        fmt_printf("\r\n[CORE1] IRQ %u: storm (> %u in %u ms), linea spenta (%u volte)",
+                   i, q->limit, IRQ_STATS_WINDOW_MS, q->storms);
+#else
+        fmt_printf("\r\nIRQ %u: storm (> %u in %u ms), linea spenta (%u volte)",
+                   i, q->limit, IRQ_STATS_WINDOW_MS, q->storms);
+#endif
+    }
+}
+
+void irq_stats_dump(void)
+{
+    for (uint32_t i = 0; i < ALT_INT_PROVISION_INT_COUNT; ++i) {
+        const irq_stat_t *q = &s_irq[i];
+        if (!q->count && !q->storms) continue;
+        uint32_t avg = (uint32_t)(q->t_total / (q->count ? q->count : 1u));
+        fmt_printf("\r\nIRQ %u: n=%u avg=%u max=%u tick storm=%u%s",
+                   i, q->count, avg, q->t_max, q->storms, q->masked ? " (spenta)" : "");
+    }
+}
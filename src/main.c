@@ -24,6 +24,17 @@
 #include "socal/socal.h"
 #include "socal/alt_rstmgr.h"
 #include "qspi.h"
+#include "fmt_min.h"
+#include "mem_pool.h"
+#include "dma_copy.h"
+#include "wave_loader.h"
+#include "irq_stats.h"
+#include "doorbell.h"
+#include "wave_prep.h"
+#include "core1_health.h"
+#include "crash_dump.h"
+#include "trace_log.h"
+#include "wdog_mgr.h"
 
 extern volatile uint32_t *g_arm_pio_data;
 extern volatile uint32_t *g_arm_msgdma0_csr;
@@ -38,7 +49,7 @@ int main(int argc, char** argv)
 {
     ALT_STATUS_CODE status = ALT_E_SUCCESS;
 
-    /* Disable watchdogs */
+    /* Watchdog fermi durante l'init: WDOG0 lo riavvia wdog_mgr_init, servito dai controlli di salute */
     alt_wdog_stop(ALT_WDOG0);
     alt_wdog_stop(ALT_WDOG1);
 
@@ -58,6 +69,8 @@ int main(int argc, char** argv)
     /* Inizializza GIC una sola volta */
     if (status == ALT_E_SUCCESS) status = hps_global_interrupt_enable();
     if (status == ALT_E_SUCCESS) status = hps_GIC_init();
+    /* contatori/tempi per IRQ e limitatore di storm (global timer) prima del primo IRQ */
+    if (status == ALT_E_SUCCESS) status = irq_stats_init();
 
     /* ---- QUI aggiungi le priorità ---- */
     if (status == ALT_E_SUCCESS) {
@@ -65,22 +78,9 @@ int main(int argc, char** argv)
         alt_int_cpu_priority_mask_set(0xFF);   // PMR: non filtra nulla
         alt_int_cpu_binary_point_set(0);       // permette preemption annidata
 
-        // mSGDMA più urgente del trigger
-        alt_int_dist_priority_set(IRQ_ID_F2H0_5, 0x20); // DMA
-        alt_int_dist_priority_set(IRQ_ID_F2H0_4, 0x30); // DMA
-        alt_int_dist_priority_set(IRQ_ID_F2H0_3, 0x30); // DMA
-        alt_int_dist_priority_set(IRQ_ID_F2H0_2, 0x30); // DMA
-        alt_int_dist_priority_set(IRQ_ID_F2H0_1, 0x30); // DMA
-        alt_int_dist_priority_set(IRQ_ID_F2H0_0, 0x60); // trigger
-        alt_int_dist_priority_set(ALT_INT_INTERRUPT_PPI_TIMER_PRIVATE, 0xA0);
-
-        // per sicurezza: indirizza tutti su CPU0
-        alt_int_dist_target_set(IRQ_ID_F2H0_5, 0x1);
-        alt_int_dist_target_set(IRQ_ID_F2H0_4, 0x1);
-        alt_int_dist_target_set(IRQ_ID_F2H0_3, 0x1);
-        alt_int_dist_target_set(IRQ_ID_F2H0_2, 0x1);
-        alt_int_dist_target_set(IRQ_ID_F2H0_1, 0x1);
-        alt_int_dist_target_set(IRQ_ID_F2H0_0, 0x1);
+        // priorità e core di ogni linea: tabella in interrupts.c (trigger su Core0,
+        // completamenti mSGDMA/UART/PL330 4..7 su Core1)
+        status = hps_int_routes_apply();
     }
 
     if (status == ALT_E_SUCCESS) {
@@ -102,6 +102,21 @@ int main(int argc, char** argv)
 
     if (status == ALT_E_SUCCESS) status = uart_stdio_init_uart1(115200);
 
+    /* Fault prima del warm reset (record persistente in SHM, Core0 e Core1) */
+    if (status == ALT_E_SUCCESS) (void)crash_dump_report();
+    trace_log(TRACE_BOOT, 0u);
+
+    /* Arene/pool statici (OCRAM, DDR, SHM) prima di qualsiasi sottosistema che alloca */
+    if (status == ALT_E_SUCCESS) status = mem_pool_sys_init();
+
+    /* PL330: copie/azzeramenti bulk senza CPU (serve prima di core1_on) */
+    if (status == ALT_E_SUCCESS) status = dma_copy_init();
+
+    /* SGI doorbell con Core1 (handshake di avvio e comandi) */
+    if (status == ALT_E_SUCCESS) status = doorbell_init();
+    /* preparazione COEF/PULSE delegata a Core1 (coda comandi in SHM) */
+    if (status == ALT_E_SUCCESS) status = wave_prep_init();
+
 
     printf("\nFMC400 Start!");
     if (status == ALT_E_SUCCESS)
@@ -112,6 +127,10 @@ int main(int argc, char** argv)
     // (opz.) stampa stato per verifica
     arm_cache_dump_status();        // deve mostrare I=0 D=0 BP=0
     //change_pulse();
+    //fmt_min_bench();             // confronto fmt_min vs alt_printf
+
+    // libreria COEF/PULSE in DDR (trasporto: wave_transport_qspi / wave_transport_uart)
+    //wave_loader_load(wave_transport_qspi(WAVE_LIB_QSPI_OFST));
 
     /* 1 riceve dati da CPU100 PULSE e REF da mettere in memoria
      * 2 finito questo passaggio abilita il trasferimento DMA dei coefficienti
@@ -124,51 +143,46 @@ int main(int argc, char** argv)
     start_mSGDMA(g_arm_msgdma3_csr,3);
     start_mSGDMA(g_arm_msgdma4_csr,4);
 
-    arm_pio_write(g_arm_f2h_irq0_en,1); //enable interrupt del trigger!!! bisogna farlo dopo aver inizializzato MSGDMA
+    /* Throughput di mSGDMA0..3 verso la OCRAM COEF: decide lo split (senza, solo mSGDMA0) */
+    if (msgdma_coef_calibrate(MSGDMA_COEF_ROUTE_MASK) != ALT_E_SUCCESS)
+    	fmt_printf("\r\nCOEF split: calibrazione fallita, solo mSGDMA0");
+    msgdma_coef_split_dump();
 
-    if (status == ALT_E_SUCCESS) {
-    	hps_core0_int_start(IRQ_ID_F2H0_1,
-    						sgdma0_int_callback,
-							NULL,
-							ALT_INT_TRIGGER_LEVEL);
-    }
+    /* Sequenza iniziale compilata dopo la calibrazione, prima che il trigger possa arrivare */
+    if (status == ALT_E_SUCCESS) status = seq_config_init();
+    dma_layout_plan_dump(g_channel, g_coef_count, g_pulse_count);
 
-    if (status == ALT_E_SUCCESS) {
-    	hps_core0_int_start(IRQ_ID_F2H0_2,
-        					sgdma1_int_callback,
-    						NULL,
-    						ALT_INT_TRIGGER_LEVEL);
-	}
-
-    if (status == ALT_E_SUCCESS) {
-    	hps_core0_int_start(IRQ_ID_F2H0_3,
-        					sgdma2_int_callback,
-    						NULL,
-    						ALT_INT_TRIGGER_LEVEL);
-    }
-
-    if (status == ALT_E_SUCCESS) {
-    	hps_core0_int_start(IRQ_ID_F2H0_4,
-        					sgdma3_int_callback,
-    						NULL,
-    						ALT_INT_TRIGGER_LEVEL);
-    }
+    arm_pio_write(g_arm_f2h_irq0_en,1); //enable interrupt del trigger!!! bisogna farlo dopo aver inizializzato MSGDMA
 
-    if (status == ALT_E_SUCCESS) {
-    	hps_core0_int_start(IRQ_ID_F2H0_5,
-    						sgdma4_int_callback,
-							NULL,
-							ALT_INT_TRIGGER_LEVEL);
+    /* Completamenti mSGDMA: qui solo se la tabella li lascia a Core0,
+     * altrimenti li serve Core1 e il ring li conta dal trigger */
+    {
+        static const struct { ALT_INT_INTERRUPT_t id; alt_int_callback_t cb; } sgdma_irq[] = {
+            { IRQ_ID_F2H0_1, sgdma0_int_callback },
+            { IRQ_ID_F2H0_2, sgdma1_int_callback },
+            { IRQ_ID_F2H0_3, sgdma2_int_callback },
+            { IRQ_ID_F2H0_4, sgdma3_int_callback },
+            { IRQ_ID_F2H0_5, sgdma4_int_callback },
+        };
+        for (uint32_t i = 0; (status == ALT_E_SUCCESS) && (i < 5u); ++i) {
+            if (!(hps_int_affinity(sgdma_irq[i].id) & IRQ_CPU0)) continue;
+            hps_core0_int_start(sgdma_irq[i].id, sgdma_irq[i].cb, NULL, ALT_INT_TRIGGER_LEVEL);
+        }
     }
 
     core1_on();
+    /* heartbeat di Core1: stallo o fault -> diagnostica + riavvio di Core1 */
+    if (status == ALT_E_SUCCESS) status = core1_health_init(CORE1_HEALTH_TIMEOUT_MS);
 	sched_insert(CORE0,SCHED_PERIODIC,ledsys_core0,300);
-	sched_insert(CORE0,SCHED_ONETIME,check_core1,1000);
 	sched_insert(CORE0,SCHED_PERIODIC,change_pulse,5000);
+	sched_insert(CORE0,SCHED_PERIODIC,irq_stats_report,1000);
+    /* kick di WDOG0 solo con trigger servito, flusso mSGDMA vivo e Core1 sano */
+    if (status == ALT_E_SUCCESS) status = wdog_mgr_init(WDOG_MGR_TIMEOUT_MS);
 
     if (status == ALT_E_SUCCESS) {
         while (1) {
         	sched_manager(CORE0);
+        	(void)doorbell_poll();
         } /* Wait for the timer to be called X times. */
     }
     return 0;
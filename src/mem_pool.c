@@ -0,0 +1,282 @@
+// mem_pool.c
+// Arene statiche per regione (OCRAM/DDR/SHM) + pool a blocchi fissi O(1).
+// Niente malloc di newlib: nessun lock globale, nessuna frammentazione.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "mem_pool.h"
+#include "interrupts.h"
+#include "shared_ipc.h"
+#include "fmt_min.h"
+
+static inline uintptr_t mp_align_up(uintptr_t a, size_t align)
+{
+    return (a + (align - 1u)) & ~(uintptr_t)(align - 1u);
+}
+
+// ---------------------------
+// Arena (bump allocator)
+// ---------------------------
+ALT_STATUS_CODE mem_arena_init(mem_arena_t *a, const char *name, void *base, size_t size)
+{
+    if (!a || (!base && size)) return ALT_E_BAD_ARG;
+
+    a->name       = name;
+    a->base       = (uint8_t *)base;
+    a->size       = size;
+    a->off        = 0u;
+    a->high_water = 0u;
+    return ALT_E_SUCCESS;
+}
+
+void *mem_arena_alloc(mem_arena_t *a, size_t bytes, size_t align)
+{
+    if (!a || !a->base || bytes == 0u) return NULL;
+    if (align < sizeof(uint32_t)) align = sizeof(uint32_t);
+    if (align & (align - 1u)) return NULL;             // solo potenze di 2
+
+    uint32_t cpsr = arm_irq_save();
+
+    uintptr_t cur     = (uintptr_t)a->base + a->off;
+    uintptr_t aligned = mp_align_up(cur, align);
+    size_t    new_off = (size_t)(aligned - (uintptr_t)a->base) + bytes;
+    void     *ret     = NULL;
+
+    if (new_off <= a->size && new_off > a->off) {
+        a->off = new_off;
+        if (new_off > a->high_water) a->high_water = new_off;
+        ret = (void *)aligned;
+    }
+
+    arm_irq_restore(cpsr);
+    return ret;
+}
+
+void mem_arena_reset(mem_arena_t *a)
+{
+    if (a) a->off = 0u;   // high_water resta come storico
+}
+
+// ---------------------------
+// Pool a blocchi fissi
+// ---------------------------
+ALT_STATUS_CODE mem_pool_init(mem_pool_t *p, const char *name, void *storage,
+                              size_t storage_size, size_t block_size)
+{
+    if (!p || !storage) return ALT_E_BAD_ARG;
+    if (((uintptr_t)storage & (MEM_POOL_ALIGN - 1u)) != 0u) return ALT_E_BAD_ARG;
+
+    block_size = mp_align_up(block_size, MEM_POOL_ALIGN);
+    if (block_size < sizeof(mem_pool_blk_t)) return ALT_E_BAD_ARG;
+
+    // Blocchi + bitmap in_use in coda devono stare nello storage
+    uint32_t count = (uint32_t)(storage_size / block_size);
+    while (count && ((size_t)count * block_size + MEM_POOL_MAP_BYTES(count) > storage_size)) --count;
+    if (count == 0u) return ALT_E_BAD_ARG;
+
+    p->name        = name;
+    p->base        = (uint8_t *)storage;
+    p->block_size  = (uint32_t)block_size;
+    p->block_count = count;
+    p->used        = 0u;
+    p->high_water  = 0u;
+    p->fail_count  = 0u;
+    p->in_use      = (uint32_t *)(p->base + (size_t)count * block_size);
+    p->bad_free    = 0u;
+
+    // Azzera storage e bitmap (DDR con ECC: niente letture di celle mai scritte)
+    for (volatile uint32_t *w = (uint32_t *)storage;
+         w < p->in_use + MEM_POOL_MAP_BYTES(count) / sizeof(uint32_t); ++w)
+        *w = 0u;
+
+    // Free-list in ordine di indirizzo
+    p->free_head = NULL;
+    for (uint32_t i = p->block_count; i > 0u; --i) {
+        mem_pool_blk_t *b = (mem_pool_blk_t *)(p->base + (size_t)(i - 1u) * block_size);
+        b->next = p->free_head;
+        p->free_head = b;
+    }
+    return ALT_E_SUCCESS;
+}
+
+ALT_STATUS_CODE mem_pool_create(mem_pool_t *p, const char *name, mem_arena_t *a,
+                                size_t block_size, uint32_t block_count)
+{
+    if (!p || !a || block_count == 0u) return ALT_E_BAD_ARG;
+
+    size_t bs = mp_align_up(block_size, MEM_POOL_ALIGN);
+    size_t sz = bs * block_count + MEM_POOL_MAP_BYTES(block_count);
+    void *storage = mem_arena_alloc(a, sz, MEM_POOL_ALIGN);
+    if (!storage) return ALT_E_ERROR;
+
+    return mem_pool_init(p, name, storage, sz, bs);
+}
+
+void *mem_pool_alloc(mem_pool_t *p)
+{
+    if (!p) return NULL;
+
+    uint32_t cpsr = arm_irq_save();
+
+    mem_pool_blk_t *b = p->free_head;
+    if (b) {
+        uint32_t i = (uint32_t)((uint8_t *)b - p->base) / p->block_size;
+        p->in_use[i / 32u] |= (1u << (i % 32u));
+        p->free_head = b->next;
+        p->used++;
+        if (p->used > p->high_water) p->high_water = p->used;
+    } else {
+        p->fail_count++;
+    }
+
+    arm_irq_restore(cpsr);
+    return (void *)b;
+}
+
+bool mem_pool_owns(const mem_pool_t *p, const void *blk)
+{
+    if (!p || !p->base || !blk) return false;
+
+    uintptr_t a   = (uintptr_t)blk;
+    uintptr_t lo  = (uintptr_t)p->base;
+    uintptr_t hi  = lo + (uintptr_t)p->block_size * p->block_count;
+    if (a < lo || a >= hi) return false;
+
+    // deve essere l'inizio di un blocco
+    return ((a - lo) % p->block_size) == 0u;
+}
+
+ALT_STATUS_CODE mem_pool_free(mem_pool_t *p, void *blk)
+{
+    if (!blk) return ALT_E_SUCCESS;
+    if (!p) return ALT_E_BAD_ARG;
+
+    uint32_t cpsr = arm_irq_save();
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+
+    if (!mem_pool_owns(p, blk)) {
+        status = ALT_E_BAD_ARG;                          // estraneo o non a inizio blocco
+    } else {
+        uint32_t i   = (uint32_t)((uint8_t *)blk - p->base) / p->block_size;
+        uint32_t bit = 1u << (i % 32u);
+
+        if (!(p->in_use[i / 32u] & bit)) {
+            status = ALT_E_BAD_ARG;                      // già libero: doppio free
+        } else {
+            mem_pool_blk_t *b = (mem_pool_blk_t *)blk;
+            p->in_use[i / 32u] &= ~bit;
+            b->next = p->free_head;
+            p->free_head = b;
+            p->used--;
+        }
+    }
+    if (status != ALT_E_SUCCESS) p->bad_free++;
+
+    arm_irq_restore(cpsr);
+    return status;
+}
+
+// ---------------------------
+// Arene/pool di sistema
+// ---------------------------
+typedef struct {
+    const char   *name;
+    mem_region_t  region;
+    uint32_t      block_size;
+    uint32_t      block_count;
+} mem_pool_cfg_t;
+
+static const mem_pool_cfg_t s_pool_cfg[MEM_POOL_QTY] = {
+    [MEM_POOL_OCR_SMALL] = { "ocr_small", MEM_REGION_OCR,   64u,  64u },   //   4 KiB
+    [MEM_POOL_DDR_MSG]   = { "ddr_msg",   MEM_REGION_DDR, 1024u, 256u },   // 256 KiB
+    [MEM_POOL_DDR_PAGE]  = { "ddr_page",  MEM_REGION_DDR, 4096u, 256u },   //   1 MiB
+    [MEM_POOL_SHM_MSG]   = { "shm_msg",   MEM_REGION_SHM,  256u, 256u },   //  64 KiB
+};
+
+// Heap statico nell'immagine: in OCRAM solo su Core0. Core1 gira dalla DDR
+// (arria10-core1-ddr.ld), lì MEM_REGION_OCR è questo buffer nel suo .bss in DDR.
+static uint8_t s_ocr_heap[MEM_OCR_HEAP_SIZE] __attribute__((aligned(MEM_POOL_ALIGN)));
+
+#if defined(CORE1)
+#define MEM_OCR_ARENA_NAME  "bss1"   // non è OCRAM
+#else
+#define MEM_OCR_ARENA_NAME  "ocr"
+#endif
+
+static mem_arena_t s_arena[MEM_REGION_QTY];
+static mem_pool_t  s_pool[MEM_POOL_QTY];
+
+ALT_STATUS_CODE mem_pool_sys_init(void)
+{
+    ALT_STATUS_CODE s = ALT_E_SUCCESS;
+
+    if (s == ALT_E_SUCCESS) s = mem_arena_init(&s_arena[MEM_REGION_OCR], MEM_OCR_ARENA_NAME, s_ocr_heap, sizeof(s_ocr_heap));
+
+#if defined(CORE1)
+    {
+        extern uint8_t __heap_start__;
+        extern uint8_t __heap_end__;
+        uintptr_t lo = mp_align_up((uintptr_t)&__heap_start__, MEM_POOL_ALIGN);
+        uintptr_t hi = (uintptr_t)&__heap_end__;
+        if (s == ALT_E_SUCCESS) s = mem_arena_init(&s_arena[MEM_REGION_DDR], "ddr1", (void *)lo, (size_t)(hi - lo));
+    }
+    // SHM: la gestisce Core0, qui resta vuota
+    if (s == ALT_E_SUCCESS) s = mem_arena_init(&s_arena[MEM_REGION_SHM], "shm", NULL, 0u);
+#else
+    if (s == ALT_E_SUCCESS) s = mem_arena_init(&s_arena[MEM_REGION_DDR], "ddr0",
+                                               (void *)(uintptr_t)MEM_DDR0_HEAP_BASE, MEM_DDR0_HEAP_SIZE);
+    if (s == ALT_E_SUCCESS) s = mem_arena_init(&s_arena[MEM_REGION_SHM], "shm",
+                                               (void *)(uintptr_t)(SHM_BASE + MEM_SHM_HEAP_OFST), MEM_SHM_HEAP_SIZE);
+#endif
+
+    for (uint32_t i = 0; (s == ALT_E_SUCCESS) && (i < MEM_POOL_QTY); ++i) {
+        const mem_pool_cfg_t *c = &s_pool_cfg[i];
+        mem_arena_t *a = &s_arena[c->region];
+
+        s_pool[i].name = c->name;
+        if (!a->base) continue;   // regione non disponibile su questo core
+
+        s = mem_pool_create(&s_pool[i], c->name, a, c->block_size, c->block_count);
+    }
+
+    return s;
+}
+
+mem_pool_t *mem_pool_get(mem_pool_id_t id)
+{
+    return (id < MEM_POOL_QTY) ? &s_pool[id] : NULL;
+}
+
+mem_arena_t *mem_arena_get(mem_region_t region)
+{
+    return (region < MEM_REGION_QTY) ? &s_arena[region] : NULL;
+}
+
+void *mem_alloc(mem_pool_id_t id)
+{
+    return mem_pool_alloc(mem_pool_get(id));
+}
+
+ALT_STATUS_CODE mem_free(mem_pool_id_t id, void *blk)
+{
+    return mem_pool_free(mem_pool_get(id), blk);
+}
+
+void mem_pool_dump(void)
+{
+    for (uint32_t r = 0; r < MEM_REGION_QTY; ++r) {
+        const mem_arena_t *a = &s_arena[r];
+        if (!a->base) continue;
+        fmt_printf("\r\nARENA %-5s @0x%08X size=%u used=%u hw=%u",
+                   a->name, (uint32_t)(uintptr_t)a->base, (uint32_t)a->size,
+                   (uint32_t)a->off, (uint32_t)a->high_water);
+    }
+    for (uint32_t i = 0; i < MEM_POOL_QTY; ++i) {
+        const mem_pool_t *p = &s_pool[i];
+        if (!p->base) continue;
+        fmt_printf("\r\nPOOL  %-9s blk=%u n=%u used=%u hw=%u fail=%u badfree=%u",
+                   p->name, p->block_size, p->block_count, p->used, p->high_water, p->fail_count,
+                   p->bad_free);
+    }
+}
@@ -9,6 +9,9 @@
 #include "interrupts.h"
 #include "alt_printf.h"
 #include "uart_stdio.h"
+#include "alt_globaltmr.h"
+#include "dma_copy.h"
+#include "fmt_min.h"
 
 
 extern volatile uint32_t *g_arm_msgdma0_csr;
@@ -67,6 +70,19 @@ ALT_STATUS_CODE init_mSGDMA(volatile uint32_t *msgdma_csr_add)
 	return ALT_E_SUCCESS;
 }
 
+void msgdma_stream_reset(void)
+{
+	volatile uint32_t *const csr[] = {
+		g_arm_msgdma0_csr, g_arm_msgdma1_csr, g_arm_msgdma2_csr, g_arm_msgdma3_csr, g_arm_msgdma4_csr
+	};
+	for (uint32_t e = 0; e < 5u; ++e) {
+		reset_mSGDMA(csr[e]);
+		alt_write_word((void*)(csr[e] + CSR_STATUS_REG), CSR_IRQ_SET_MASK);
+		uint32_t ctrl = alt_read_word((void*)(csr[e] + CSR_CONTROL_REG));
+		alt_write_word((void*)(csr[e] + CSR_CONTROL_REG), ctrl | CSR_GLOBAL_INTERRUPT_MASK);
+	}
+}
+
 int msgdma_is_idle(volatile uint32_t *msgdma_csr_add)
 {
     uint32_t st = alt_read_word((msgdma_csr_add + CSR_STATUS_REG));
@@ -103,6 +119,7 @@ void sgdma0_int_callback(uint32_t icciar, void *ctx)
 
 	/* clear the IRQ state */
 	alt_write_word((void *)(g_arm_msgdma0_csr + CSR_STATUS_REG),CSR_IRQ_SET_MASK);
+	bank_fill_done(0u);
 	// EOI alla fine
 	//gic_eoi(IRQ_ID_F2H0_1);
 }
@@ -113,6 +130,7 @@ void sgdma1_int_callback(uint32_t icciar, void *ctx)
 
 	/* clear the IRQ state */
 	alt_write_word((void *)(g_arm_msgdma1_csr + CSR_STATUS_REG),CSR_IRQ_SET_MASK);
+	bank_fill_done(1u);
 	// EOI alla fine
 	//gic_eoi(IRQ_ID_F2H0_1);
 }
@@ -123,6 +141,7 @@ void sgdma2_int_callback(uint32_t icciar, void *ctx)
 
 	/* clear the IRQ state */
 	alt_write_word((void *)(g_arm_msgdma2_csr + CSR_STATUS_REG),CSR_IRQ_SET_MASK);
+	bank_fill_done(2u);
 	// EOI alla fine
 	//gic_eoi(IRQ_ID_F2H0_1);
 }
@@ -133,6 +152,7 @@ void sgdma3_int_callback(uint32_t icciar, void *ctx)
 
 	/* clear the IRQ state */
 	alt_write_word((void *)(g_arm_msgdma3_csr + CSR_STATUS_REG),CSR_IRQ_SET_MASK);
+	bank_fill_done(3u);
 	// EOI alla fine
 	//gic_eoi(IRQ_ID_F2H0_1);
 }
@@ -143,6 +163,184 @@ void sgdma4_int_callback(uint32_t icciar, void *ctx)
 
 	/* clear the IRQ state */
 	alt_write_word((void *)(g_arm_msgdma4_csr + CSR_STATUS_REG),CSR_IRQ_SET_MASK);
+	bank_fill_done(4u);
 }
 
 
+
+
+// ===== Split COEF su mSGDMA0..3 =====
+// Prima della calibrazione: solo mSGDMA0, come da sempre.
+static msgdma_split_info_t s_split = { .route_mask = 0x1u, .n = 1u, .eng = { 0u, 1u, 2u, 3u } };
+
+static volatile uint32_t *coef_csr(uint32_t e)
+{
+	switch (e) {
+		case 0: return g_arm_msgdma0_csr;
+		case 1: return g_arm_msgdma1_csr;
+		case 2: return g_arm_msgdma2_csr;
+		default: return g_arm_msgdma3_csr;
+	}
+}
+
+static volatile uint32_t *coef_desc(uint32_t e)
+{
+	switch (e) {
+		case 0: return g_arm_msgdma0_desc;
+		case 1: return g_arm_msgdma1_desc;
+		case 2: return g_arm_msgdma2_desc;
+		default: return g_arm_msgdma3_desc;
+	}
+}
+
+/* Parti contigue sui primi n engine di eng[], quota ~ 1/t_alone (l'ultima prende il resto) */
+static uint32_t split_parts(uint32_t len, uint32_t n, uint32_t part_len[], uint8_t part_eng[])
+{
+	uint64_t w[MSGDMA_COEF_ENGINES], wsum = 0u;
+	for (uint32_t i = 0; i < n; ++i) {
+		uint32_t t = s_split.t_alone[s_split.eng[i]];
+		w[i] = t ? (0xFFFFFFFFull / t) : 1u;
+		wsum += w[i];
+	}
+
+	uint32_t rest = len, k = 0;
+	for (uint32_t i = 0; (i < n) && rest; ++i) {
+		uint32_t l = rest;
+		if (i + 1u < n) {
+			l = (uint32_t)(((uint64_t)len * w[i]) / wsum) & ~(MSGDMA_SPLIT_ALIGN - 1u);
+			if (l > rest) l = rest;
+		}
+		if (l == 0u) continue;
+		part_len[k] = l;
+		part_eng[k] = s_split.eng[i];
+		k++;
+		rest -= l;
+	}
+	return k;
+}
+
+/* Transfer di prova DDR -> OCRAM COEF sulle parti date; tick del global timer, 0 = timeout */
+static uint32_t cal_run(const uint32_t part_len[], const uint8_t part_eng[], uint32_t n)
+{
+	uint32_t ofs = 0u;
+	uint64_t t0 = alt_globaltmr_get64();
+
+	for (uint32_t k = 0; k < n; ++k) {
+		volatile uint32_t *d = coef_desc(part_eng[k]);
+		alt_write_word((void*)(d + DESCRIPTOR_READ_ADDRESS_REG),     MSGDMA_CAL_SRC + ofs);
+		alt_write_word((void*)(d + DESCRIPTOR_WRITE_ADDRESS_REG),    COEF_DEST_BASE + ofs);
+		alt_write_word((void*)(d + DESCRIPTOR_LENGTH_REG),           part_len[k]);
+		alt_write_word((void*)(d + DESCRIPTOR_CONTROL_STANDARD_REG), DESCRIPTOR_CONTROL_GO_MASK);  // niente IRQ
+		ofs += part_len[k];
+	}
+
+	for (uint32_t spin = 0; spin < MSGDMA_CAL_SPINS; ++spin) {
+		bool idle = true;
+		for (uint32_t k = 0; k < n; ++k)
+			if (!msgdma_is_idle(coef_csr(part_eng[k]))) idle = false;
+		if (idle) {
+			uint64_t t = alt_globaltmr_get64() - t0;
+			return (t > 0u && t < 0xFFFFFFFFull) ? (uint32_t)t : 0xFFFFFFFFu;
+		}
+	}
+	return 0u;
+}
+
+ALT_STATUS_CODE msgdma_coef_calibrate(uint32_t route_mask)
+{
+	uint32_t plen[MSGDMA_COEF_ENGINES];
+	uint8_t  peng[MSGDMA_COEF_ENGINES];
+
+	// sorgente scritta prima di leggerla (DDR con ECC)
+	ALT_STATUS_CODE status = dma_copy_zero((void *)(uintptr_t)MSGDMA_CAL_SRC, MSGDMA_CAL_BYTES);
+	if (status == ALT_E_SUCCESS) status = alt_globaltmr_init();
+	if (status != ALT_E_SUCCESS) return status;
+
+	// 1) ogni engine da solo
+	uint32_t ok = 0u, cnt = 0u;
+	for (uint32_t e = 0; e < MSGDMA_COEF_ENGINES; ++e) {
+		s_split.t_alone[e] = 0u;
+		if (!(route_mask & (1u << e))) continue;
+		plen[0] = MSGDMA_CAL_BYTES;
+		peng[0] = (uint8_t)e;
+		s_split.t_alone[e] = cal_run(plen, peng, 1u);
+		if (s_split.t_alone[e]) { ok |= (1u << e); s_split.eng[cnt++] = (uint8_t)e; }
+	}
+	if (cnt == 0u) {
+		s_split.route_mask = 0x1u;
+		s_split.n = 1u;
+		s_split.eng[0] = 0u;
+		return ALT_E_ERROR;
+	}
+
+	// ordine per throughput (insertion sort su max 4 elementi)
+	for (uint32_t i = 1; i < cnt; ++i) {
+		uint8_t e = s_split.eng[i];
+		uint32_t j = i;
+		while (j > 0u && s_split.t_alone[s_split.eng[j - 1u]] > s_split.t_alone[e]) {
+			s_split.eng[j] = s_split.eng[j - 1u];
+			--j;
+		}
+		s_split.eng[j] = e;
+	}
+
+	// 2) split su 1..cnt engine insieme: si tiene il più veloce (con isteresi)
+	uint32_t best_n = 1u;
+	s_split.t_split[0] = s_split.t_alone[s_split.eng[0]];
+	for (uint32_t n = 2; n <= cnt; ++n) {
+		uint32_t k = split_parts(MSGDMA_CAL_BYTES, n, plen, peng);
+		uint32_t t = cal_run(plen, peng, k);
+		s_split.t_split[n - 1u] = t;
+		if (t && (uint64_t)t * 100u < (uint64_t)s_split.t_split[best_n - 1u] * (100u - MSGDMA_SPLIT_GAIN_PCT))
+			best_n = n;
+	}
+	for (uint32_t n = cnt + 1u; n <= MSGDMA_COEF_ENGINES; ++n) s_split.t_split[n - 1u] = 0u;
+
+	s_split.route_mask = ok;
+	s_split.n = best_n;
+	return ALT_E_SUCCESS;
+}
+
+uint32_t msgdma_coef_split(uint32_t len, uint32_t part_len[], uint8_t part_eng[], uint32_t max_parts)
+{
+	if (max_parts == 0u) return 0u;
+	uint32_t n = s_split.n;
+	if (n > max_parts) n = max_parts;
+	if (len < MSGDMA_SPLIT_MIN_BYTES) n = 1u;
+	return split_parts(len, n, part_len, part_eng);
+}
+
+uint32_t msgdma_in_flight(uint32_t engine)
+{
+	volatile uint32_t *csr = (engine == MSGDMA_PULSE_ENGINE) ? g_arm_msgdma4_csr : coef_csr(engine);
+	uint32_t st = alt_read_word((void *)(csr + CSR_STATUS_REG));
+	uint32_t fl = alt_read_word((void *)(csr + CSR_DESCRIPTOR_FILL_LEVEL_REG));
+	uint32_t rd = (fl & CSR_READ_FILL_LEVEL_MASK) >> CSR_READ_FILL_LEVEL_OFFSET;
+	uint32_t wr = (fl & CSR_WRITE_FILL_LEVEL_MASK) >> CSR_WRITE_FILL_LEVEL_OFFSET;
+
+	// descrittori ancora in coda + quello in esecuzione
+	return ((rd > wr) ? rd : wr) + ((st & CSR_BUSY_MASK) ? 1u : 0u);
+}
+
+int msgdma_coef_idle(void)
+{
+	for (uint32_t e = 0; e < MSGDMA_COEF_ENGINES; ++e)
+		if ((s_split.route_mask & (1u << e)) && !msgdma_is_idle(coef_csr(e))) return 0;
+	return 1;
+}
+
+const msgdma_split_info_t *msgdma_coef_split_info(void)
+{
+	return &s_split;
+}
+
+void msgdma_coef_split_dump(void)
+{
+	fmt_printf("\r\nCOEF split: engine mask 0x%X, split x%u", s_split.route_mask, s_split.n);
+	for (uint32_t e = 0; e < MSGDMA_COEF_ENGINES; ++e)
+		if (s_split.t_alone[e])
+			fmt_printf("\r\n  mSGDMA%u da solo: %u tick / %u KiB", e, s_split.t_alone[e], MSGDMA_CAL_BYTES / 1024u);
+	for (uint32_t n = 1; n <= MSGDMA_COEF_ENGINES; ++n)
+		if (s_split.t_split[n - 1u])
+			fmt_printf("\r\n  %u engine: %u tick", n, s_split.t_split[n - 1u]);
+}
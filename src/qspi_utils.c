@@ -6,6 +6,8 @@
 #include "uart_stdio.h"
 #include <stdint.h>
 #include "shared_ipc.h"
+#include "dma_copy.h"
+#include "doorbell.h"
 
 
 // Se la tua HWLIB ha ECC per Arria10, abilitalo (è dichiarato nel tuo header con #if defined(soc_a10))
@@ -99,6 +101,11 @@ static ALT_STATUS_CODE qspi_init_safe(void)
     return ALT_E_SUCCESS;
 }
 
+ALT_STATUS_CODE qspi_open(void)
+{
+    return qspi_init_safe();
+}
+
 ALT_STATUS_CODE qspi_read(uint8_t *dst1024, size_t len, uint32_t addr)
 {
     if (!dst1024) return ALT_E_BAD_ARG;
@@ -137,11 +144,14 @@ static ALT_STATUS_CODE qspi_copy_to_ddr(uint32_t qspi_ofs, void *ddr_dst, size_t
 /* 1) Legge da QSPI -> DDR e fa flush delle cache sulla regione */
 int core1_load_from_qspi_to_ddr(void)
 {
-    // (Consigliato) Inizializza l’area DDR per ECC
-    for (volatile uint32_t *p=(uint32_t*)CORE1_DDR_BASE; p<(uint32_t*)(CORE1_DDR_BASE+CORE1_IMAGE_SIZE); ++p)
-    	*p = 0u;
+    // (Consigliato) Inizializza l’area DDR per ECC: PL330, o CPU se il DMA non è pronto
+    ALT_STATUS_CODE s = dma_copy_zero((void *)CORE1_DDR_BASE, CORE1_IMAGE_SIZE);
+    if (s != ALT_E_SUCCESS) {
+        alt_printf("\r\nDDR zero-fill fail: %d", (int)s);
+        return -1;
+    }
 
-    ALT_STATUS_CODE s = qspi_copy_to_ddr(CORE1_QSPI_SRC, (void*)CORE1_DDR_BASE, CORE1_IMAGE_SIZE);
+    s = qspi_copy_to_ddr(CORE1_QSPI_SRC, (void*)CORE1_DDR_BASE, CORE1_IMAGE_SIZE);
     if (s != ALT_E_SUCCESS) {
         alt_printf("\r\nQSPI read fail: %d", (int)s);
         return -1;
@@ -193,30 +203,70 @@ int core1_boot_from_ddr(void)
     return 0;
 }
 
+/* Doorbell DB_CORE1_READY (dal loop di Core0, doorbell_poll) */
+static void core1_ready_db(doorbell_ch_t ch, uint32_t rings, void *ctx)
+{
+	(void)ch; (void)rings; (void)ctx;
+	check_core1();
+}
+
+/* Inizializza la shared memory
+ * (MMU off + cache off su Core0 = già NC, quindi scrivi direttamente) */
+static void core1_shm_init(void)
+{
+	SHM_CTRL->magic = SHM_MAGIC_BOOT;
+	SHM_CTRL->core0_ready = 0u;
+	SHM_CTRL->core1_ready = 0u;
+	SHM_CTRL->trig_count  = 0u;
+	SHM_CTRL->core1_timer  = 0u;
+	SHM_CTRL->log_head = SHM_CTRL->log_tail = 0u;
+	SHM_CTRL->hb_count = SHM_CTRL->hb_ticks = SHM_CTRL->hb_pc = SHM_CTRL->hb_task = 0u;
+	SHM_CTRL->fault_type = 0u;
+	SHM_CTRL->pl330_want[1] = 0u;          // Core1 in reset non tiene il lock del PL330
+	doorbell_reset();                      // chiude con dmb sy: flag azzerati prima del rilascio
+}
+
+static int core1_release(void)
+{
+	int r = core1_boot_from_ddr();
+	if (r != 0) {
+		alt_printf("\r\nCore1 boot failed");
+	}
+	__asm__ volatile("dmb sy" ::: "memory");   // SHM (NC) scritta da Core0 prima del flag
+	SHM_CTRL->core0_ready = 1u;
+	__asm__ volatile("dmb sy" ::: "memory");
+	(void)doorbell_ring(DB_CORE0_READY);   // Core1 aspetta questo, non fa più spin su SHM
+	return r;
+}
+
 void core1_on(void)
 {
-	//#ifdef CORE1
-
-	    // 1) Inizializza la shared memory
-		//    (MMU off + cache off su Core0 = già NC, quindi scrivi direttamente)
-		SHM_CTRL->magic = SHM_MAGIC_BOOT;
-		SHM_CTRL->core0_ready = 0u;
-		SHM_CTRL->core1_ready = 0u;
-		SHM_CTRL->trig_count  = 0u;
-		SHM_CTRL->core1_timer  = 0u;
-		SHM_CTRL->log_head = SHM_CTRL->log_tail = 0u;
-
-		//if (core1_boot_from_ddr() != 0) {
-		if (core1_boot_from_ddr() != 0) {
-			alt_printf("\r\nCore1 boot failed");
-		}
-		SHM_CTRL->core0_ready = 1u;
-		//
-	//#endif
+	core1_shm_init();
+	(void)doorbell_register(DB_CORE1_READY, core1_ready_db, NULL, DOORBELL_TASK);
+	(void)core1_release();
+}
+
+/* CPU1 in reset (RSTMGR.MPUMODRST bit1): ferma Core1 dov'è */
+void core1_hold_reset(void)
+{
+	uint32_t r = rd32(RSTMGR_MPUMODRST_ADDR);
+	wr32(RSTMGR_MPUMODRST_ADDR, r | (1u << 1));
+	dsb_isb();
+}
+
+/* Nuovo avvio di Core1 con Core0 in servizio (core1_health): stessa sequenza
+ * di core1_on, doorbell già registrati */
+int core1_restart(void)
+{
+	core1_hold_reset();
+	core1_shm_init();
+	return core1_release();
 }
 
 void check_core1(void)
 {
-	if (SHM_CTRL->core1_ready == 1) //core 1 ready
+	if (SHM_CTRL->core1_ready == 1) { //core 1 ready
+		__asm__ volatile("dmb sy" ::: "memory");   // dati di Core1 letti dopo il flag
 		alt_printf("\r\nWelcome Core 1!");
+	}
 }
@@ -8,6 +8,7 @@
 #include "schedule.h"
 
 static sched_slot sched_array[CORE_QTY][SCHED_MAX];
+static void (*volatile sched_running[CORE_QTY])(void);     // task in esecuzione (diagnostica)
 
 extern volatile unsigned long core0_ticks;
 extern volatile unsigned long core1_ticks;
@@ -93,6 +94,12 @@ void sched_rep_time_by_func(int core, void (*func)(void), unsigned int x_timer)
 
 }
 
+/* Task in esecuzione su core (0 fra un task e l'altro): letto dagli IRQ */
+void (*sched_current(int core))(void)
+{
+   return sched_running[core];
+}
+
 int sched_delete(int core, int slot)
 {
    if (sched_array[core][slot].code == SCHED_NOTUSED)
@@ -117,13 +124,17 @@ void sched_manager(int core)
 	  switch (sched_array[core][i].code)
 	  {
 		 case SCHED_CONTINUE:
+			sched_running[core] = sched_array[core][i].func;
 			(sched_array[core][i].func)();
+			sched_running[core] = 0;
 			f++;
 			break;
 		 case SCHED_PERIODIC:
 			if (get_Time(core)>= sched_array[core][i].time)
 			{
+			   sched_running[core] = sched_array[core][i].func;
 			   (sched_array[core][i].func)();
+			   sched_running[core] = 0;
 			   sched_array[core][i].time = get_Time(core)+ sched_array[core][i].period;
 			}
 			f++;
@@ -131,7 +142,9 @@ void sched_manager(int core)
 		 case SCHED_ONETIME:
 			if (get_Time(core)>= sched_array[core][i].time)
 			{
+			   sched_running[core] = sched_array[core][i].func;
 			   (sched_array[core][i].func)();
+			   sched_running[core] = 0;
 			   sched_delete(core, i);
 			}
 			f++;
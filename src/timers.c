@@ -2,6 +2,9 @@
 #include "alt_fpga_manager.h"
 #include "timers.h"
 #include "shared_ipc.h"
+#if defined(CORE1)
+#include "core1_health.h"
+#endif
 
 unsigned long core0_ticks = 0;
 unsigned long core1_ticks = 0;
@@ -70,6 +73,9 @@ void core1_timer_int_callback(uint32_t icciar, void * context)
 {
 	(void)alt_gpt_int_if_pending_clear(ALT_GPT_CPU_PRIVATE_TMR);
 	core1_ticks++;
+#if defined(CORE1)
+	core1_health_tick();
+#endif
 }
 
 
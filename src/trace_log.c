@@ -0,0 +1,75 @@
+// trace_log.c
+// Ring di eventi per core (timestamp global timer), copiato da crash_dump al fault.
+
+#include <stdint.h>
+#include "trace_log.h"
+#include "interrupts.h"
+#include "alt_globaltmr.h"
+#include "fmt_min.h"
+
+static trace_ent_t s_ring[TRACE_LOG_DEPTH];
+static uint32_t    s_head;      // voci scritte in totale
+
+static const char *const s_name[TRACE_ID_QTY] = {
+    [TRACE_NONE]           = "-",
+    [TRACE_BOOT]           = "boot",
+    [TRACE_IRQ_STORM]      = "irq_storm",
+    [TRACE_DMA_FAULT]      = "dma_fault",
+    [TRACE_WPREP_SUBMIT]   = "wprep_submit",
+    [TRACE_WPREP_DONE]     = "wprep_done",
+    [TRACE_WPREP_CMD]      = "wprep_cmd",
+    [TRACE_C1_STALL]       = "c1_stall",
+    [TRACE_C1_RESTART]     = "c1_restart",
+    [TRACE_WDOG_MISS]      = "wdog_miss",
+    [TRACE_WDOG_WARN]      = "wdog_warn",
+    [TRACE_STREAM_RECOVER] = "stream_recover",
+    [TRACE_TRIG_REARM]     = "trig_rearm",
+};
+
+void trace_log(trace_id_t id, uint32_t arg)
+{
+    uint32_t t = alt_globaltmr_counter_get_low32();
+    uint32_t cpsr = arm_irq_save();
+
+    trace_ent_t *e = &s_ring[s_head & (TRACE_LOG_DEPTH - 1u)];
+    e->t   = t;
+    e->id  = (uint16_t)id;
+    e->seq = (uint16_t)s_head;
+    e->arg = arg;
+    s_head++;
+
+    arm_irq_restore(cpsr);
+}
+
+uint32_t trace_log_copy(trace_ent_t *dst, uint32_t max)
+{
+    uint32_t head = s_head;     // niente lock: chiamata anche dal gestore di fault
+    uint32_t n = (head < TRACE_LOG_DEPTH) ? head : TRACE_LOG_DEPTH;
+    if (n > max) n = max;
+
+    for (uint32_t i = 0; i < n; ++i)
+        dst[i] = s_ring[(head - n + i) & (TRACE_LOG_DEPTH - 1u)];
+    return n;
+}
+
+const char *trace_log_name(uint32_t id)
+{
+    return (id < TRACE_ID_QTY && s_name[id]) ? s_name[id] : "?";
+}
+
+void trace_log_print(const trace_ent_t *e, uint32_t n)
+{
+    // tempi relativi all'ultima voce: tra un boot e l'altro il global timer non è confrontabile
+    uint32_t t_last = n ? e[n - 1u].t : 0u;
+    for (uint32_t i = 0; i < n; ++i)
+        fmt_printf("\r\n  #%-5u -%10u  %-12s 0x%08X",
+                   (uint32_t)e[i].seq, t_last - e[i].t, trace_log_name(e[i].id), e[i].arg);
+}
+
+void trace_log_dump(void)
+{
+    static trace_ent_t tmp[TRACE_LOG_DEPTH];
+    uint32_t n = trace_log_copy(tmp, TRACE_LOG_DEPTH);
+    fmt_printf("\r\nTRACE: %u voci (ultime %u, tick global timer prima dell'ultima)", s_head, n);
+    trace_log_print(tmp, n);
+}
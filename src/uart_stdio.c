@@ -112,6 +112,31 @@ ALT_STATUS_CODE uart_stdio_write_hex32(uint32_t value)
     return ALT_E_SUCCESS;
 }
 
+ALT_STATUS_CODE uart_stdio_read(void *buf, size_t len, uint32_t timeout_spins)
+{
+    char *p = (char *)buf;
+    uint32_t idle = 0;
+
+    while (len) {
+        uint32_t level = 0;
+        ALT_STATUS_CODE st = alt_16550_fifo_level_get_rx(&s_uart1, &level);
+        if (st != ALT_E_SUCCESS) return st;
+
+        if (level == 0u) {
+            if (++idle >= timeout_spins) return ALT_E_TMO;
+            continue;
+        }
+        idle = 0;
+
+        size_t n = (level < len) ? level : len;
+        st = alt_16550_fifo_read(&s_uart1, p, n);
+        if (st != ALT_E_SUCCESS) return st;
+        p   += n;
+        len -= n;
+    }
+    return ALT_E_SUCCESS;
+}
+
 /* ---------------- newlib syscalls redirect ---------------- */
 
 int _write(int fd, const void *buf, size_t cnt)
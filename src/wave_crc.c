@@ -0,0 +1,30 @@
+// wave_crc.c
+// CRC32 delle entry COEF/PULSE: la usano il loader (Core0) e la preparazione su Core1.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "wave_loader.h"
+
+// ---------------------------
+// CRC32 (IEEE 802.3, riflessa) con tabella costruita al primo uso
+// ---------------------------
+static uint32_t s_crc_tab[256];
+static bool     s_crc_tab_ok;
+
+uint32_t wave_crc32(uint32_t crc, const void *buf, size_t len)
+{
+    if (!s_crc_tab_ok) {
+        for (uint32_t i = 0; i < 256u; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1u) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            s_crc_tab[i] = c;
+        }
+        s_crc_tab_ok = true;
+    }
+
+    const uint8_t *p = (const uint8_t *)buf;
+    crc = ~crc;
+    while (len--) crc = s_crc_tab[(crc ^ *p++) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
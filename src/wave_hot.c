@@ -0,0 +1,163 @@
+// wave_hot.c
+// Hot-update di entry COEF/PULSE: slot di riserva, ridirezione al trigger, quarantena.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "wave_hot.h"
+#include "wave_loader.h"
+#include "dma_layout.h"
+#include "dma_copy.h"
+#include "arm_mem_regions.h"
+
+#define WAVE_HOT_NONE     0xFFFFu
+// passi accodati dopo il latch prima di riusare uno slot: con il ring OCRAM i fill
+// in volo sono al massimo SEQ_RING_MAX-1, quindi quelli con la sorgente vecchia sono finiti
+#define WAVE_HOT_SETTLE   (SEQ_RING_MAX + 1u)
+
+typedef struct {
+    uint16_t slot;
+    uint32_t gen;
+} wave_retire_t;
+
+static bool          s_ok;
+static seq_config_t  s_lay;                              // layout della libreria caricata
+static dma_plan_t    s_plan;
+static uint32_t      s_coef_spare_base;
+static uint16_t      s_map[WAVE_TYPE_QTY][1024];          // entry logica -> slot fisico
+static uint16_t      s_ver[WAVE_TYPE_QTY][1024];
+static uint16_t      s_free[WAVE_TYPE_QTY][WAVE_HOT_SPARES];
+static uint32_t      s_n_free[WAVE_TYPE_QTY];
+static wave_retire_t s_retire[WAVE_TYPE_QTY][WAVE_HOT_SPARES];
+static uint32_t      s_n_retire[WAVE_TYPE_QTY];
+
+static inline uint32_t type_count(wave_type_t t)
+{
+    return (t == WAVE_COEF) ? s_lay.coef_count : s_lay.pulse_count;
+}
+
+static inline uint32_t type_size(wave_type_t t)
+{
+    return (t == WAVE_COEF) ? g_coef_pair_bytes[s_lay.channel] : g_pulse_pair_bytes[s_lay.channel];
+}
+
+static uint32_t slot_addr(wave_type_t t, uint32_t slot)
+{
+    uint32_t n = type_count(t);
+    if (slot < n)
+        return (t == WAVE_COEF) ? pair_coef_source_addr_cfg(&s_lay, slot) : pair_pulse_source_addr_cfg(&s_lay, slot);
+    // PULSE di riserva: continuano lo schema del planner (stesso sfasamento di banco)
+    if (t == WAVE_PULSE) return dma_plan_pulse_addr(&s_plan, slot);
+    return s_coef_spare_base + (slot - n) * s_plan.coef_stride;
+}
+
+ALT_STATUS_CODE wave_hot_reset(uint32_t channel, uint32_t coef_count, uint32_t pulse_count)
+{
+    s_ok = false;
+    if (channel > 3u || coef_count == 0u || coef_count > 1024u ||
+        pulse_count == 0u || pulse_count > 1024u) return ALT_E_ARG_RANGE;
+
+    memset(&s_lay, 0, sizeof(s_lay));
+    s_lay.channel     = channel;
+    s_lay.coef_count  = coef_count;
+    s_lay.pulse_count = pulse_count;
+
+    // riserve dopo l'area pianificata: prima le PULSE (indici count..), poi le COEF dal banco 0
+    ALT_STATUS_CODE s = dma_layout_plan(channel, coef_count, pulse_count, &s_plan);
+    s_lay.plan = s_plan;
+    uint64_t pend = (uint64_t)dma_plan_pulse_addr(&s_plan, pulse_count + WAVE_HOT_SPARES - 1u)
+                  + g_pulse_pair_bytes[channel];
+    s_coef_spare_base = (uint32_t)((pend + DDR_BANK_SPAN - 1u) / DDR_BANK_SPAN * DDR_BANK_SPAN);
+    uint64_t top = (uint64_t)s_coef_spare_base + (uint64_t)WAVE_HOT_SPARES * s_plan.coef_stride;
+
+    seq_redirect_reset(channel, coef_count, pulse_count);
+
+    for (uint32_t t = 0; t < WAVE_TYPE_QTY; ++t) {
+        uint32_t n = type_count((wave_type_t)t);
+        for (uint32_t i = 0; i < 1024u; ++i) {
+            s_map[t][i] = (i < n) ? (uint16_t)i : WAVE_HOT_NONE;
+            s_ver[t][i] = 0u;
+        }
+        for (uint32_t k = 0; k < WAVE_HOT_SPARES; ++k) s_free[t][k] = (uint16_t)(n + k);
+        s_n_free[t]   = WAVE_HOT_SPARES;
+        s_n_retire[t] = 0u;
+    }
+
+    // senza spazio per le riserve la libreria si carica lo stesso, niente hot-update
+    if (s != ALT_E_SUCCESS || top > (uint64_t)DDR3_PLAN_END) return ALT_E_SUCCESS;
+
+    s_ok = true;
+    return ALT_E_SUCCESS;
+}
+
+void wave_hot_poll(void)
+{
+    const bool settled = (seq_trigger_count() - seq_config_live_trigger()) >= WAVE_HOT_SETTLE;
+
+    for (uint32_t t = 0; t < WAVE_TYPE_QTY; ++t) {
+        for (uint32_t i = 0; i < s_n_retire[t]; ) {
+            wave_retire_t *r = &s_retire[t][i];
+            if (settled && seq_config_is_live(r->gen)) {
+                s_free[t][s_n_free[t]++] = r->slot;
+                *r = s_retire[t][--s_n_retire[t]];
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+ALT_STATUS_CODE wave_hot_update(wave_type_t type, uint32_t index,
+                                const void *data, uint32_t len, uint32_t crc, uint32_t *gen)
+{
+    if (!s_ok) return ALT_E_BAD_OPERATION;
+    if (type >= WAVE_TYPE_QTY || !data) return ALT_E_BAD_ARG;
+    if (index >= type_count(type) || len != type_size(type)) return ALT_E_ARG_RANGE;
+    if (wave_crc32(0u, data, len) != crc) return ALT_E_ERROR;
+
+    wave_hot_poll();
+    if (s_n_free[type] == 0u) return ALT_E_RESERVED;     // tutti gli slot ancora in quarantena: riprova
+
+    // 1) slot libero: nessun DMA lo può leggere
+    uint16_t slot = s_free[type][--s_n_free[type]];
+    uint32_t dst  = slot_addr(type, slot);
+
+    // 2) dati nuovi
+    ALT_STATUS_CODE s = dma_copy_memcpy((void *)(uintptr_t)dst, data, len);
+    if (s != ALT_E_SUCCESS) {
+        s_free[type][s_n_free[type]++] = slot;
+        return s;
+    }
+
+    // 3) ridirezione: compilazioni future + sequenza attiva al prossimo trigger
+    uint16_t old = s_map[type][index];
+    uint32_t g = 0u;
+    s = seq_redirect_set(type, index, (slot == index) ? 0u : dst);
+    if (s == ALT_E_SUCCESS) s = seq_config_redirect(type, slot_addr(type, old), dst, &g);
+    if (s != ALT_E_SUCCESS) {
+        (void)seq_redirect_set(type, index, (old == index) ? 0u : slot_addr(type, old));
+        s_free[type][s_n_free[type]++] = slot;
+        return s;
+    }
+    s_map[type][index] = slot;
+
+    // 4) quarantena del vecchio slot
+    s_retire[type][s_n_retire[type]++] = (wave_retire_t){ old, g };
+
+    s_ver[type][index]++;
+    wave_index_set_entry(type, index, crc);
+    if (gen) *gen = g;
+    return ALT_E_SUCCESS;
+}
+
+uint32_t wave_hot_version(wave_type_t type, uint32_t index)
+{
+    return (type < WAVE_TYPE_QTY && index < 1024u) ? s_ver[type][index] : 0u;
+}
+
+uint32_t wave_hot_addr(wave_type_t type, uint32_t index)
+{
+    if (type >= WAVE_TYPE_QTY || index >= 1024u || s_map[type][index] == WAVE_HOT_NONE) return 0u;
+    return slot_addr(type, s_map[type][index]);
+}
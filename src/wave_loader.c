@@ -0,0 +1,267 @@
+// wave_loader.c
+// Caricamento libreria COEF/PULSE in DDR: trasporto -> staging -> PL330 -> layout.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "wave_loader.h"
+#include "dma_layout.h"
+#include "dma_copy.h"
+#include "mem_pool.h"
+#include "arm_mem_regions.h"
+#include "uart_stdio.h"
+#include "qspi.h"
+#include "fmt_min.h"
+#include "wave_hot.h"
+
+#define WAVE_UART_TIMEOUT   200000000u   // giri di polling senza byte prima di ALT_E_TMO
+
+static wave_index_t s_index;
+
+// ---------------------------
+// Trasporti
+// ---------------------------
+static ALT_STATUS_CODE uart_open(void *ctx)  { (void)ctx; return ALT_E_SUCCESS; }
+static void            uart_close(void *ctx) { (void)ctx; }
+static ALT_STATUS_CODE uart_rd(void *ctx, void *buf, size_t len)
+{
+    (void)ctx;
+    return uart_stdio_read(buf, len, WAVE_UART_TIMEOUT);
+}
+
+static const wave_transport_t s_tp_uart = { "uart", uart_open, uart_rd, uart_close, NULL };
+
+const wave_transport_t *wave_transport_uart(void)
+{
+    return &s_tp_uart;
+}
+
+typedef struct { uint32_t ofs; } qspi_ctx_t;
+
+static qspi_ctx_t       s_qspi_ctx;
+static wave_transport_t s_tp_qspi;
+
+static ALT_STATUS_CODE qspi_tp_open(void *ctx)  { (void)ctx; return qspi_open(); }
+static void            qspi_tp_close(void *ctx) { (void)ctx; (void)alt_qspi_uninit(); }
+static ALT_STATUS_CODE qspi_tp_read(void *ctx, void *buf, size_t len)
+{
+    qspi_ctx_t *q = (qspi_ctx_t *)ctx;
+    ALT_STATUS_CODE s = alt_qspi_read(buf, q->ofs, len);
+    if (s == ALT_E_SUCCESS) q->ofs += (uint32_t)len;
+    return s;
+}
+
+const wave_transport_t *wave_transport_qspi(uint32_t qspi_ofs)
+{
+    s_qspi_ctx.ofs = qspi_ofs;
+    s_tp_qspi = (wave_transport_t){ "qspi", qspi_tp_open, qspi_tp_read, qspi_tp_close, &s_qspi_ctx };
+    return &s_tp_qspi;
+}
+
+// ---------------------------
+// Validazione layout
+// ---------------------------
+static ALT_STATUS_CODE hdr_check(const wave_lib_hdr_t *h, seq_config_t *lay)
+{
+    if (h->magic != WAVE_LIB_MAGIC)     return ALT_E_BAD_VERSION;
+    if (h->version != WAVE_LIB_VERSION) return ALT_E_BAD_VERSION;
+    if (wave_crc32(0u, h, offsetof(wave_lib_hdr_t, hdr_crc)) != h->hdr_crc) return ALT_E_ERROR;
+
+    if (h->channel > 3u) return ALT_E_ARG_RANGE;
+    if (h->coef_count  == 0u || h->coef_count  > COEF_NUM_PAIRS)  return ALT_E_ARG_RANGE;
+    if (h->pulse_count == 0u || h->pulse_count > PULSE_NUM_PAIRS) return ALT_E_ARG_RANGE;
+    if (h->entry_count > (uint32_t)h->coef_count + h->pulse_count) return ALT_E_ARG_RANGE;
+
+    // l'intera area (ultima PULSE compresa) deve stare nella finestra DDR letta dall'FPGA
+    dma_plan_t plan;
+    if (dma_layout_plan(h->channel, h->coef_count, h->pulse_count, &plan) != ALT_E_SUCCESS) return ALT_E_ARG_RANGE;
+
+    memset(lay, 0, sizeof(*lay));
+    lay->channel     = h->channel;
+    lay->coef_count  = h->coef_count;
+    lay->pulse_count = h->pulse_count;
+    lay->plan        = plan;
+
+    return ALT_E_SUCCESS;
+}
+
+// ---------------------------
+// Staging a doppio buffer
+// ---------------------------
+typedef struct {
+    uint8_t                 *buf;
+    volatile bool            busy;
+    volatile ALT_STATUS_CODE status;
+} stage_t;
+
+static void stage_done(ALT_STATUS_CODE status, void *ctx)
+{
+    stage_t *s = (stage_t *)ctx;
+    s->status = status;
+    s->busy   = false;
+}
+
+static ALT_STATUS_CODE stage_wait(stage_t *s)
+{
+    for (uint32_t spin = 0; s->busy; ++spin) {
+        (void)dma_copy_poll();
+        if (spin >= DMA_COPY_WAIT_SPINS) return ALT_E_TMO;
+    }
+    return s->status;
+}
+
+/* Riceve un'entry (len byte) e la copia a dst; ritorna la CRC calcolata */
+static ALT_STATUS_CODE load_entry(const wave_transport_t *t, stage_t st[2],
+                                  uint32_t dst, uint32_t len, uint32_t *crc)
+{
+    ALT_STATUS_CODE s = ALT_E_SUCCESS;
+    uint32_t c = 0u, b = 0u;
+
+    while ((s == ALT_E_SUCCESS) && len) {
+        uint32_t n = (len < WAVE_LOADER_CHUNK) ? len : WAVE_LOADER_CHUNK;
+
+        s = stage_wait(&st[b]);                 // il buffer b è di nuovo libero?
+        if (s == ALT_E_SUCCESS) s = t->read(t->ctx, st[b].buf, n);
+        if (s == ALT_E_SUCCESS) {
+            c = wave_crc32(c, st[b].buf, n);
+            st[b].busy = true;
+            s = dma_copy_memcpy_async((void *)(uintptr_t)dst, st[b].buf, n, stage_done, &st[b]);
+            if (s != ALT_E_SUCCESS) st[b].busy = false;
+        }
+        dst += n;
+        len -= n;
+        b ^= 1u;
+    }
+
+    ALT_STATUS_CODE s0 = stage_wait(&st[0]);
+    ALT_STATUS_CODE s1 = stage_wait(&st[1]);
+    if (s == ALT_E_SUCCESS) s = (s0 != ALT_E_SUCCESS) ? s0 : s1;
+
+    *crc = c;
+    return s;
+}
+
+/* Scarta len byte dallo stream (entry rifiutata) per restare allineati */
+static ALT_STATUS_CODE skip_entry(const wave_transport_t *t, uint8_t *tmp, uint32_t len)
+{
+    ALT_STATUS_CODE s = ALT_E_SUCCESS;
+    while ((s == ALT_E_SUCCESS) && len) {
+        uint32_t n = (len < WAVE_LOADER_CHUNK) ? len : WAVE_LOADER_CHUNK;
+        s = t->read(t->ctx, tmp, n);
+        len -= n;
+    }
+    return s;
+}
+
+// ---------------------------
+// Load
+// ---------------------------
+ALT_STATUS_CODE wave_loader_load(const wave_transport_t *t)
+{
+    if (!t || !t->read) return ALT_E_BAD_ARG;
+
+    stage_t st[2] = {
+        { (uint8_t *)mem_alloc(MEM_POOL_DDR_PAGE), false, ALT_E_SUCCESS },
+        { (uint8_t *)mem_alloc(MEM_POOL_DDR_PAGE), false, ALT_E_SUCCESS },
+    };
+    if (!st[0].buf || !st[1].buf) {
+        (void)mem_free(MEM_POOL_DDR_PAGE, st[0].buf);
+        (void)mem_free(MEM_POOL_DDR_PAGE, st[1].buf);
+        return ALT_E_ERROR;
+    }
+
+    ALT_STATUS_CODE s = t->open ? t->open(t->ctx) : ALT_E_SUCCESS;
+
+    wave_lib_hdr_t hdr;
+    seq_config_t lay;
+    if (s == ALT_E_SUCCESS) s = t->read(t->ctx, &hdr, sizeof(hdr));
+    if (s == ALT_E_SUCCESS) s = hdr_check(&hdr, &lay);
+
+    if (s == ALT_E_SUCCESS) {
+        // indice non valido finché il load non è finito
+        s_index.ready = 0u;
+        __asm__ volatile("dmb sy" ::: "memory");
+        s_index.channel     = lay.channel;
+        s_index.coef_count  = lay.coef_count;
+        s_index.pulse_count = lay.pulse_count;
+        s_index.loaded      = 0u;
+        s_index.errors      = 0u;
+        memset(s_index.valid, 0, sizeof(s_index.valid));
+        // le ridirezioni del layout precedente non valgono più
+        s = wave_hot_reset(lay.channel, lay.coef_count, lay.pulse_count);
+    }
+
+    for (uint32_t e = 0; (s == ALT_E_SUCCESS) && (e < hdr.entry_count); ++e) {
+        wave_entry_hdr_t eh;
+        s = t->read(t->ctx, &eh, sizeof(eh));
+        if (s != ALT_E_SUCCESS) break;
+
+        uint32_t count = (eh.type == WAVE_COEF) ? lay.coef_count : lay.pulse_count;
+        uint32_t size  = (eh.type == WAVE_COEF) ? g_coef_pair_bytes[lay.channel] : g_pulse_pair_bytes[lay.channel];
+
+        if (eh.type >= WAVE_TYPE_QTY || eh.index >= count || eh.len != size) {
+            fmt_printf("\r\nWLIB: entry %u rifiutata (type %u idx %u len %u)", e, eh.type, eh.index, eh.len);
+            s_index.errors++;
+            s = skip_entry(t, st[0].buf, eh.len);
+            continue;
+        }
+
+        uint32_t dst = (eh.type == WAVE_COEF) ? pair_coef_source_addr_cfg(&lay, eh.index)
+                                              : pair_pulse_source_addr_cfg(&lay, eh.index);
+        uint32_t crc = 0u;
+        s = load_entry(t, st, dst, eh.len, &crc);
+        if (s != ALT_E_SUCCESS) break;
+
+        if (crc != eh.crc) {
+            fmt_printf("\r\nWLIB: CRC %s[%u] 0x%08X != 0x%08X",
+                       (eh.type == WAVE_COEF) ? "COEF" : "PULSE", eh.index, crc, eh.crc);
+            s_index.errors++;
+            continue;
+        }
+
+        s_index.crc[eh.type][eh.index] = crc;
+        s_index.valid[eh.type][eh.index >> 5] |= (1u << (eh.index & 31u));
+        s_index.loaded++;
+    }
+
+    if (t->close) t->close(t->ctx);
+    (void)mem_free(MEM_POOL_DDR_PAGE, st[0].buf);
+    (void)mem_free(MEM_POOL_DDR_PAGE, st[1].buf);
+
+    if (s == ALT_E_SUCCESS) {
+        s_index.gen++;
+        __asm__ volatile("dmb sy" ::: "memory");
+        s_index.ready = 1u;
+        if (s_index.errors) s = ALT_E_ERROR;   // caricata, ma con entry scartate
+    }
+
+    fmt_printf("\r\nWLIB [%s]: ch %u coef %u pulse %u -> %u ok, %u err (st %d)",
+               t->name, s_index.channel, s_index.coef_count, s_index.pulse_count,
+               s_index.loaded, s_index.errors, (int)s);
+    return s;
+}
+
+const wave_index_t *wave_index(void)
+{
+    return &s_index;
+}
+
+void wave_index_set_entry(wave_type_t type, uint32_t index, uint32_t crc)
+{
+    if (type >= WAVE_TYPE_QTY || index >= 1024u) return;
+    s_index.crc[type][index] = crc;
+    s_index.valid[type][index >> 5] |= (1u << (index & 31u));
+}
+
+void wave_index_clear_entry(wave_type_t type, uint32_t index)
+{
+    if (type >= WAVE_TYPE_QTY || index >= 1024u) return;
+    s_index.valid[type][index >> 5] &= ~(1u << (index & 31u));
+}
+
+bool wave_entry_ready(wave_type_t type, uint32_t index)
+{
+    if (!s_index.ready || type >= WAVE_TYPE_QTY || index >= 1024u) return false;
+    return (s_index.valid[type][index >> 5] >> (index & 31u)) & 1u;
+}
@@ -0,0 +1,225 @@
+// wave_prep.c
+// Core0: client della preparazione forme d'onda su Core1 (coda comandi in SHM + doorbell).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "wave_prep.h"
+#include "wave_hot.h"
+#include "wave_loader.h"
+#include "dma_layout.h"
+#include "doorbell.h"
+#include "interrupts.h"
+#include "f2h_interrupts.h"
+#include "socal/socal.h"
+#include "fmt_min.h"
+#include "trace_log.h"
+
+typedef struct {
+    bool             busy;
+    uint32_t         seq;
+    wave_type_t      type;
+    uint32_t         index;
+    wave_prep_dst_t  dst;
+    uint32_t         dst_addr;  // indirizzo scritto da Core1
+    uint32_t         len;       // byte scritti (dal canale al submit)
+    int32_t          stage;     // slot di staging (-1 = nessuno)
+    wave_prep_done_t done;
+    void            *ctx;
+} wave_prep_pend_t;
+
+static wave_prep_pend_t s_pend[WAVE_PREP_QDEPTH];
+static bool             s_stage_busy[WAVE_PREP_STAGE_SLOTS];
+static uint32_t         s_seq;
+static uint32_t         s_ok, s_err;
+
+static int32_t stage_take(void)
+{
+    for (uint32_t i = 0; i < WAVE_PREP_STAGE_SLOTS; ++i)
+        if (!s_stage_busy[i]) { s_stage_busy[i] = true; return (int32_t)i; }
+    return -1;
+}
+
+/* Trigger acceso nel distributor: la sequenza gira e gli mSGDMA leggono il layout */
+static bool trigger_running(void)
+{
+    return (alt_read_word(GICD_ISENABLER(IRQ_ID_F2H0_0)) & (1u << (IRQ_ID_F2H0_0 % 32u))) != 0u;
+}
+
+/* Chiusura di un comando: dal loop di Core0 (doorbell DOORBELL_TASK) */
+static void rsp_complete(const wave_prep_rsp_t *r)
+{
+    wave_prep_pend_t *p = &s_pend[r->seq & (WAVE_PREP_QDEPTH - 1u)];
+    if (!p->busy || p->seq != r->seq) return;      // risposta orfana (dopo un reset)
+
+    wave_prep_rsp_t rsp = *r;
+    if (rsp.status == ALT_E_SUCCESS) {
+        if (p->dst == WAVE_PREP_DST_LAYOUT) {
+            // trigger acceso mentre Core1 scriveva uno slot in sequenza: gli mSGDMA
+            // possono averlo letto a metà, l'entry non si può dare per buona
+            if (trigger_running() && seq_config_uses_src(p->type == WAVE_COEF ? 0u : 1u, p->dst_addr)) {
+                wave_index_clear_entry(p->type, p->index);
+                rsp.status = ALT_E_BAD_OPERATION;
+            } else {
+                wave_index_set_entry(p->type, p->index, rsp.crc);
+            }
+        } else {
+            // verifica CRC + slot di riserva + ridirezione al prossimo trigger; lunghezza
+            // quella del submit (la libreria può essere stata ricaricata nel frattempo)
+            rsp.status = wave_hot_update(p->type, p->index,
+                                         (const void *)(uintptr_t)WAVE_PREP_STAGE(p->stage),
+                                         p->len, rsp.crc, NULL);
+        }
+    }
+    if (p->stage >= 0) s_stage_busy[p->stage] = false;
+    trace_log(TRACE_WPREP_DONE, (r->seq & 0xFFFFu) | ((uint32_t)rsp.status << 16));
+    if (rsp.status == ALT_E_SUCCESS) s_ok++; else s_err++;
+
+    wave_prep_done_t done = p->done;
+    void *ctx = p->ctx;
+    p->busy = false;
+    if (done) done(p->type, p->index, &rsp, ctx);
+}
+
+static void rsp_db(doorbell_ch_t ch, uint32_t rings, void *ctx)
+{
+    (void)ch; (void)rings; (void)ctx;
+    wave_prep_shm_t *q = WAVE_PREP_SHM;
+
+    while (q->rsp_tail != q->rsp_head) {
+        __asm__ volatile("dmb sy" ::: "memory");   // indice letto prima del contenuto
+        wave_prep_rsp_t r = q->rsp[q->rsp_tail & (WAVE_PREP_QDEPTH - 1u)];
+        __asm__ volatile("dmb sy" ::: "memory");
+        q->rsp_tail = q->rsp_tail + 1u;
+        rsp_complete(&r);
+    }
+}
+
+ALT_STATUS_CODE wave_prep_init(void)
+{
+    wave_prep_shm_t *q = WAVE_PREP_SHM;
+    memset((void *)q, 0, sizeof(*q));
+    memset(s_pend, 0, sizeof(s_pend));
+    memset(s_stage_busy, 0, sizeof(s_stage_busy));
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    return doorbell_register(DB_RSP_TO_CORE0, rsp_db, NULL, DOORBELL_TASK);
+}
+
+ALT_STATUS_CODE wave_prep_submit(const wave_prep_req_t *req, uint32_t *seq)
+{
+    if (!req || !req->src || req->type >= WAVE_TYPE_QTY) return ALT_E_BAD_ARG;
+    if (req->fmt >= WAVE_PREP_FMT_QTY || req->window >= WAVE_PREP_WIN_QTY) return ALT_E_BAD_ARG;
+    wave_prep_op_t op = req->op ? req->op : WAVE_PREP_OP_BUILD;
+    if (op > WAVE_PREP_OP_COEF) return ALT_E_BAD_ARG;
+    if (op == WAVE_PREP_OP_COEF && req->type != WAVE_COEF) return ALT_E_BAD_ARG;
+
+    const wave_index_t *wi = wave_index();
+    uint32_t count = (req->type == WAVE_COEF) ? wi->coef_count : wi->pulse_count;
+    uint32_t len   = (req->type == WAVE_COEF) ? g_coef_pair_bytes[wi->channel & 3u]
+                                              : g_pulse_pair_bytes[wi->channel & 3u];
+    if (req->index >= count) return ALT_E_ARG_RANGE;
+    if (req->src_count == 0u || req->src_count > len / WAVE_PREP_SAMPLE_BYTES) return ALT_E_ARG_RANGE;
+
+    wave_prep_shm_t *q = WAVE_PREP_SHM;
+    if ((uint32_t)(q->cmd_head - q->cmd_tail) >= WAVE_PREP_QDEPTH) return ALT_E_RESERVED;
+
+    wave_prep_pend_t *p = &s_pend[(s_seq + 1u) & (WAVE_PREP_QDEPTH - 1u)];
+    if (p->busy) return ALT_E_RESERVED;            // risposta non ancora chiusa
+
+    uint32_t dst;
+    int32_t stage = -1;
+    if (req->dst == WAVE_PREP_DST_HOT) {
+        if (len > WAVE_PREP_STAGE_BYTES) return ALT_E_ARG_RANGE;
+        stage = stage_take();
+        if (stage < 0) return ALT_E_RESERVED;
+        dst = WAVE_PREP_STAGE(stage);
+    } else {
+        dst = wave_hot_addr(req->type, req->index);  // slot attuale dell'entry
+        if (dst == 0u) return ALT_E_BAD_OPERATION;   // nessun layout caricato
+        // scrittura diretta nello slot letto dagli mSGDMA: solo a trigger fermo o entry
+        // fuori dalle sequenze (altrimenti WAVE_PREP_DST_HOT)
+        if (trigger_running() && seq_config_uses_src(req->type == WAVE_COEF ? 0u : 1u, dst))
+            return ALT_E_BAD_OPERATION;
+    }
+
+    uint32_t n = ++s_seq;
+    *p = (wave_prep_pend_t){ true, n, req->type, req->index, req->dst, dst, len, stage, req->done, req->ctx };
+
+    wave_prep_cmd_t *c = &q->cmd[q->cmd_head & (WAVE_PREP_QDEPTH - 1u)];
+    c->seq       = n;
+    c->op        = (uint16_t)op;
+    c->fmt       = (uint16_t)req->fmt;
+    c->window    = (uint16_t)req->window;
+    c->type      = (uint16_t)req->type;
+    c->index     = req->index;
+    c->src_addr  = (uint32_t)(uintptr_t)req->src;
+    c->src_count = req->src_count;
+    c->gain      = req->gain;
+    c->dst_addr  = dst;
+    c->dst_len   = len;
+    __asm__ volatile("dmb sy" ::: "memory");       // comando completo prima dell'indice
+    q->cmd_head = q->cmd_head + 1u;
+
+    trace_log(TRACE_WPREP_SUBMIT, n);
+    if (seq) *seq = n;
+    return doorbell_ring(DB_CMD_TO_CORE1);
+}
+
+ALT_STATUS_CODE wave_prep_coef_from_pulse(uint32_t coef_idx, uint32_t pulse_idx, float gain,
+                                          wave_prep_dst_t dst, wave_prep_done_t done, void *ctx,
+                                          uint32_t *seq)
+{
+    const wave_index_t *wi = wave_index();
+    if (pulse_idx >= wi->pulse_count) return ALT_E_ARG_RANGE;
+
+    uint32_t src = wave_hot_addr(WAVE_PULSE, pulse_idx);   // slot attuale (anche dopo un hot-update)
+    if (src == 0u) return ALT_E_BAD_OPERATION;
+    uint32_t n = g_pulse_pair_bytes[wi->channel & 3u] / WAVE_PREP_SAMPLE_BYTES;
+
+    wave_prep_req_t req = {
+        .op        = WAVE_PREP_OP_COEF,
+        .type      = WAVE_COEF,
+        .index     = coef_idx,
+        .fmt       = WAVE_PREP_FMT_S16_IQ,
+        .window    = WAVE_PREP_WIN_NONE,
+        .dst       = dst,
+        .src       = (const void *)(uintptr_t)src,
+        .src_count = n,
+        .gain      = (gain > 0.0f) ? gain : 1.0f / (float)n,   // |FFT|/n <= max |pulse|: satura solo oltre modulo 1
+        .done      = done,
+        .ctx       = ctx,
+    };
+    return wave_prep_submit(&req, seq);
+}
+
+void wave_prep_abort(ALT_STATUS_CODE status)
+{
+    wave_prep_shm_t *q = WAVE_PREP_SHM;
+    q->cmd_head = q->cmd_tail = 0u;
+    q->rsp_head = q->rsp_tail = 0u;
+    __asm__ volatile("dmb sy" ::: "memory");
+
+    for (uint32_t i = 0; i < WAVE_PREP_QDEPTH; ++i) {
+        wave_prep_pend_t *p = &s_pend[i];
+        if (!p->busy) continue;
+        if (p->dst == WAVE_PREP_DST_LAYOUT) wave_index_clear_entry(p->type, p->index);
+        wave_prep_rsp_t r = { .seq = p->seq, .status = status };
+        rsp_complete(&r);
+    }
+}
+
+uint32_t wave_prep_pending(void)
+{
+    uint32_t n = 0u;
+    for (uint32_t i = 0; i < WAVE_PREP_QDEPTH; ++i) if (s_pend[i].busy) n++;
+    return n;
+}
+
+void wave_prep_dump(void)
+{
+    const wave_prep_shm_t *q = WAVE_PREP_SHM;
+    fmt_printf("\r\nWPREP: cmd %u/%u rsp %u/%u pending %u ok %u err %u",
+               q->cmd_tail, q->cmd_head, q->rsp_tail, q->rsp_head, wave_prep_pending(), s_ok, s_err);
+}
@@ -0,0 +1,280 @@
+// wdog_mgr.c
+// Kick del watchdog L4 solo con tutti i controlli di salute a posto; preallarme con dump prima del reset.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "wdog_mgr.h"
+#include "alt_watchdog.h"
+#include "alt_clock_manager.h"
+#include "socal/socal.h"
+#include "socal/alt_rstmgr.h"
+#include "interrupts.h"
+#include "irq_stats.h"
+#include "f2h_interrupts.h"
+#include "core1_health.h"
+#include "crash_dump.h"
+#include "trace_log.h"
+#include "fmt_min.h"
+#include "schedule.h"
+
+typedef struct {
+    const char  *name;
+    wdog_check_t fn;
+    void        *ctx;
+    uint32_t     fails;             // giri falliti in totale
+} wdog_check_slot_t;
+
+typedef struct {
+    wdog_check_slot_t check[WDOG_MGR_CHECKS_MAX];
+    uint32_t n;
+    uint32_t timeout_ms;            // effettivo (potenza di 2 di osc1_clk)
+    uint32_t fail_mask;             // ultimo giro
+    uint32_t kicks;
+    uint32_t misses;                // giri senza kick
+    volatile uint32_t warned;       // preallarme arrivato: niente più kick
+    bool     running;
+} wdog_mgr_t;
+
+static wdog_mgr_t s_w;
+
+// ---------------------------
+// Controlli di serie
+// ---------------------------
+
+typedef struct {
+    uint32_t min_hz;
+    uint32_t last_count;
+    uint32_t last_t;
+    uint32_t pending_rounds;        // giri con la linea pendente e count fermo
+    uint32_t rearms;                // riaccensioni consecutive
+} trig_chk_t;
+
+static trig_chk_t s_trig;
+
+static bool chk_trigger(void *ctx)
+{
+    trig_chk_t *c = (trig_chk_t *)ctx;
+    const irq_stat_t *q = irq_stats_get((ALT_INT_INTERRUPT_t)IRQ_ID_F2H0_0);
+    const uint32_t now = (uint32_t)get_Time(CORE0);
+    if (!q) return true;
+
+    uint32_t count = q->count;
+    uint32_t dn = count - c->last_count;
+    uint32_t dt = now - c->last_t;
+    c->last_count = count;
+    c->last_t     = now;
+
+    // spenta dal limitatore: ripristino locale, poi si lascia decidere al watchdog
+    if (q->masked) {
+        if (c->rearms >= WDOG_MGR_REARM_MAX) return false;
+        c->rearms++;
+        trace_log(TRACE_TRIG_REARM, c->rearms);
+        (void)irq_stats_rearm((ALT_INT_INTERRUPT_t)IRQ_ID_F2H0_0);
+        return true;
+    }
+    if (dn) c->rearms = 0u;
+
+    // pendente nel distributor per due giri senza una callback: Core0 non serve gli IRQ
+    bool pending = (alt_read_word(GICD_ISPENDR(IRQ_ID_F2H0_0)) & (1u << (IRQ_ID_F2H0_0 % 32u))) != 0u;
+    c->pending_rounds = (pending && dn == 0u) ? c->pending_rounds + 1u : 0u;
+    if (c->pending_rounds >= 2u) return false;
+
+    if (c->min_hz && dt) {
+        if ((uint64_t)dn * 1000u < (uint64_t)c->min_hz * dt) return false;
+    }
+    return true;
+}
+
+typedef struct {
+    uint32_t last_swaps;
+    uint32_t last_late;
+    uint32_t stall_ms;              // underrun con swap fermi
+    uint32_t recover_run;           // ripristini senza swap in mezzo
+} stream_chk_t;
+
+static stream_chk_t s_stream;
+
+static bool chk_stream(void *ctx)
+{
+    stream_chk_t *c = (stream_chk_t *)ctx;
+    const bank_stats_t *b = bank_stats();
+
+    uint32_t swaps = b->swaps;
+    uint32_t late  = b->coef_late + b->pulse_late;
+    bool moving = (swaps != c->last_swaps);
+    bool late_up = (late != c->last_late);
+    c->last_swaps = swaps;
+    c->last_late  = late;
+
+    if (moving) {
+        c->stall_ms    = 0u;
+        c->recover_run = 0u;
+        return true;
+    }
+    if (!late_up) {                 // nessun trigger (o nessun fill chiesto): non è uno stallo
+        c->stall_ms = 0u;
+        return true;
+    }
+    if (c->recover_run >= WDOG_MGR_RECOVER_MAX) return false;   // ancora fermo dopo l'ultimo ripristino
+
+    c->stall_ms += WDOG_MGR_KICK_MS;
+    if (c->stall_ms < WDOG_MGR_STREAM_STALL_MS) return true;
+
+    // trigger che arrivano con i fill mai conclusi: gli mSGDMA sono fermi
+    c->stall_ms = 0u;
+    c->recover_run++;
+    trace_log(TRACE_STREAM_RECOVER, c->recover_run);
+    bank_ring_recover();
+    fmt_printf("\r\nWDOG: flusso fermo, mSGDMA e ring ripristinati (%u)", c->recover_run);
+    return true;
+}
+
+static bool chk_core1(void *ctx)
+{
+    (void)ctx;
+    return core1_health_state() != CORE1_HEALTH_STALLED;
+}
+
+// ---------------------------
+// Preallarme (primo timeout di WDOG0)
+// ---------------------------
+
+static void wdog_warn_isr(uint32_t icciar, void *ctx)
+{
+    (void)icciar; (void)ctx;
+
+    // niente EOI sul watchdog: con l'interrupt pulito il secondo timeout non resetterebbe.
+    // Linea a livello: la si spegne nel distributor, il reset arriva comunque.
+    s_w.warned = 1u;
+    alt_write_word(GICD_ICENABLER(ALT_INT_INTERRUPT_WDOG0_IRQ), 1u << (ALT_INT_INTERRUPT_WDOG0_IRQ % 32u));
+
+    trace_log(TRACE_WDOG_WARN, s_w.fail_mask);
+    crash_dump_soft(CRASH_WDOG, s_w.fail_mask);
+
+    fmt_printf("\r\nWDOG: preallarme, reset tra %u ms (controlli 0x%08X, task 0x%08X)",
+               s_w.timeout_ms, s_w.fail_mask, (uint32_t)(uintptr_t)sched_current(CORE0));
+    wdog_mgr_dump();
+    core1_health_dump();
+    trace_log_dump();
+}
+
+// ---------------------------
+// API
+// ---------------------------
+
+ALT_STATUS_CODE wdog_mgr_register(const char *name, wdog_check_t fn, void *ctx)
+{
+    if (!fn) return ALT_E_BAD_ARG;
+    if (s_w.n >= WDOG_MGR_CHECKS_MAX) return ALT_E_BUF_OVF;
+
+    wdog_check_slot_t *k = &s_w.check[s_w.n];
+    k->name  = name ? name : "?";
+    k->fn    = fn;
+    k->ctx   = ctx;
+    k->fails = 0u;
+    s_w.n++;
+    return ALT_E_SUCCESS;
+}
+
+void wdog_mgr_trigger_rate_set(uint32_t min_hz)
+{
+    s_trig.min_hz = min_hz;
+}
+
+void wdog_mgr_service(void)
+{
+    uint32_t mask = 0u;
+    for (uint32_t i = 0; i < s_w.n; ++i) {
+        if (!s_w.check[i].fn(s_w.check[i].ctx)) {
+            mask |= 1u << i;
+            s_w.check[i].fails++;
+        }
+    }
+    s_w.fail_mask = mask;
+
+    if (mask == 0u && !s_w.warned) {
+        if (s_w.running) (void)alt_wdog_reset(ALT_WDOG0);
+        s_w.kicks++;
+    } else {
+        // nessun kick: se il controllo non rientra prima del timeout arriva il preallarme
+        s_w.misses++;
+        trace_log(TRACE_WDOG_MISS, mask);
+    }
+}
+
+uint32_t wdog_mgr_fail_mask(void)
+{
+    return s_w.fail_mask;
+}
+
+/* Più piccolo k con 2^(16+k) periodi di osc1_clk >= timeout_ms */
+static ALT_WDOG_TIMEOUT_t wdog_timeout_sel(uint32_t osc1_hz, uint32_t timeout_ms, uint32_t *eff_ms)
+{
+    uint64_t want = (uint64_t)osc1_hz * timeout_ms / 1000u;
+    uint32_t k = 0u;
+    while (k < (uint32_t)ALT_WDOG_TIMEOUT2G && ((uint64_t)1u << (16u + k)) < want) k++;
+    *eff_ms = (uint32_t)(((uint64_t)1u << (16u + k)) * 1000u / osc1_hz);
+    return (ALT_WDOG_TIMEOUT_t)k;
+}
+
+ALT_STATUS_CODE wdog_mgr_init(uint32_t timeout_ms)
+{
+    ALT_STATUS_CODE status = ALT_E_SUCCESS;
+    alt_freq_t osc1 = 0u;
+
+    // reset precedente da WDOG0 (il dettaglio è nel record CRASH_WDOG già riportato)
+    if (alt_read_word(ALT_RSTMGR_STAT_ADDR) & ALT_RSTMGR_STAT_L4WD0RST_SET_MSK) {
+        fmt_printf("\r\nWDOG: l'ultimo reset è stato del watchdog L4");
+        alt_write_word(ALT_RSTMGR_STAT_ADDR, ALT_RSTMGR_STAT_L4WD0RST_SET_MSK);   // W1C
+    }
+
+    if (timeout_ms < 4u * WDOG_MGR_KICK_MS) timeout_ms = WDOG_MGR_TIMEOUT_MS;
+
+    const irq_stat_t *q = irq_stats_get((ALT_INT_INTERRUPT_t)IRQ_ID_F2H0_0);
+    s_trig.last_count   = q ? q->count : 0u;
+    s_trig.last_t       = (uint32_t)get_Time(CORE0);
+    s_stream.last_swaps = bank_stats()->swaps;
+    s_stream.last_late  = bank_stats()->coef_late + bank_stats()->pulse_late;
+
+    if (status == ALT_E_SUCCESS) status = wdog_mgr_register("trigger", chk_trigger, &s_trig);
+    if (status == ALT_E_SUCCESS) status = wdog_mgr_register("stream", chk_stream, &s_stream);
+    if (status == ALT_E_SUCCESS) status = wdog_mgr_register("core1", chk_core1, NULL);
+    if (status == ALT_E_SUCCESS) status = sched_insert(CORE0, SCHED_PERIODIC, wdog_mgr_service, WDOG_MGR_KICK_MS) ? ALT_E_SUCCESS : ALT_E_ERROR;
+
+#if WDOG_MGR_ENABLE
+    // reset da watchdog con SDRAM in self-refresh: il record in SHM sopravvive
+    if (status == ALT_E_SUCCESS) alt_setbits_word(ALT_RSTMGR_HDSKEN_ADDR, ALT_RSTMGR_HDSKEN_SDRSELFREFEN_SET_MSK);
+
+    if (status == ALT_E_SUCCESS) status = alt_clk_freq_get(ALT_CLK_OSC1, &osc1);
+    if (status == ALT_E_SUCCESS && osc1 == 0u) status = ALT_E_ERROR;
+    if (status == ALT_E_SUCCESS) status = alt_wdog_init();
+    if (status == ALT_E_SUCCESS) {
+        ALT_WDOG_TIMEOUT_t k = wdog_timeout_sel(osc1, timeout_ms, &s_w.timeout_ms);
+        status = alt_wdog_counter_set(ALT_WDOG0_INIT, k);
+        if (status == ALT_E_SUCCESS) status = alt_wdog_counter_set(ALT_WDOG0, k);
+    }
+    if (status == ALT_E_SUCCESS) status = alt_wdog_response_mode_set(ALT_WDOG0, ALT_WDOG_INT_THEN_RESET);
+    if (status == ALT_E_SUCCESS) status = hps_core0_int_start(ALT_INT_INTERRUPT_WDOG0_IRQ, wdog_warn_isr, NULL,
+                                                              ALT_INT_TRIGGER_LEVEL);
+    if (status == ALT_E_SUCCESS) status = alt_wdog_start(ALT_WDOG0);
+    if (status == ALT_E_SUCCESS) s_w.running = true;
+#else
+    (void)osc1;
+    s_w.timeout_ms = timeout_ms;
+#endif
+
+    fmt_printf("\r\nWDOG: %s, timeout %u ms, %u controlli", s_w.running ? "attivo" : "fermo",
+               s_w.timeout_ms, s_w.n);
+    return status;
+}
+
+void wdog_mgr_dump(void)
+{
+    fmt_printf("\r\nWDOG: %s timeout %u ms kick %u mancati %u preallarme %u",
+               s_w.running ? "attivo" : "fermo", s_w.timeout_ms, s_w.kicks, s_w.misses, s_w.warned);
+    for (uint32_t i = 0; i < s_w.n; ++i)
+        fmt_printf("\r\n  %u %-8s %s  falliti %u", i, s_w.check[i].name,
+                   (s_w.fail_mask & (1u << i)) ? "KO" : "ok", s_w.check[i].fails);
+    fmt_printf("\r\n  trigger: riaccensioni %u  stream: ripristini %u di fila, %u in totale",
+               s_trig.rearms, s_stream.recover_run, bank_stats()->recoveries);
+}